@@ -22,16 +22,41 @@
 #include <driver/i2s.h>
 #include <FastLED.h>  // For LED control without M5Atom
 #include "config.h"
-#include "base64.h"
+#include <vc_base64.h>    // From ../../voice_core (see README)
+#include <vc_realtime.h>
+#include <vc_pipeline.hpp>
 
 // FastLED for SK6812 RGB LED
 #define NUM_LEDS 1
 CRGB leds[NUM_LEDS];
 
+// Status LED animation
+#define LED_FRAME_MS 20
+#define LED_BREATHE_PERIOD_MS 2000
+#define LED_LEVEL_FULL 2048  // Mean absolute sample that lights the LED fully
+
+enum LedEffect {
+  LED_SOLID,
+  LED_BREATHE,  // Waiting on something (Wi-Fi, the WebSocket)
+  LED_LEVEL     // Pulses with the mic level
+};
+
+struct LedState {
+  CRGB color;
+  LedEffect effect;
+};
+
+// Latest state for the LED task - one slot, a newer state replaces an unseen one
+static QueueHandle_t ledQueue = NULL;
+static volatile uint16_t micLevel = 0;
+
 // I2S Port Numbers
 #define I2S_PORT_MIC I2S_NUM_0
 #define I2S_PORT_SPK I2S_NUM_1
 
+// Mic and speaker stream shape; buffer and DMA sizes follow from it
+typedef vc::pipeline<int16_t, SAMPLE_RATE, 1, MIC_BUFFER_SIZE> audio;
+
 // WebSocket client
 WebSocketsClient webSocket;
 
@@ -53,6 +78,10 @@ bool buttonPressed = false;
 unsigned long lastPingTime = 0;
 String sessionId = "";
 
+// input_audio_buffer.append frame, with room in front for the WebSocket header
+// so sendTXT() can frame it in place instead of copying
+static uint8_t audioFrame[WEBSOCKETS_MAX_HEADER_SIZE + VC_RT_APPEND_FRAME_SIZE(audio::chunk_bytes)];
+
 // Function declarations
 void setupWiFi();
 void setupI2SMicrophone();
@@ -60,8 +89,10 @@ void setupI2SSpeaker();
 void setupWebSocket();
 void webSocketEvent(WStype_t type, uint8_t * payload, size_t length);
 void sendSessionUpdate();
+void playAudioDelta(char* delta, size_t deltaLen);
 void recordAndSendAudio();
-void updateLED();
+void ledTask(void* arg);
+void setStatusLed(CRGB color, LedEffect effect = LED_SOLID);
 void handleButton();
 
 void setup() {
@@ -79,9 +110,12 @@ void setup() {
   FastLED.addLeds<WS2812, LED_PIN, GRB>(leds, NUM_LEDS);
   FastLED.setBrightness(20);
   
+  // Only the LED task touches the strip, so no state change waits on it
+  ledQueue = xQueueCreate(1, sizeof(LedState));
+  xTaskCreatePinnedToCore(ledTask, "ledTask", 2048, NULL, 1, NULL, 0);
+  
   // Set initial LED color (blue = initializing)
-  leds[0] = CRGB::Blue;
-  FastLED.show();
+  setStatusLed(CRGB::Blue);
   currentState = STATE_INIT;
   
   // Setup WiFi
@@ -98,8 +132,7 @@ void setup() {
   
   Serial.println("Setup complete - Ready!");
   currentState = STATE_READY;
-  leds[0] = CRGB::Green;  // Green = ready
-  FastLED.show();
+  setStatusLed(CRGB::Green);  // Green = ready
 }
 
 void loop() {
@@ -108,9 +141,6 @@ void loop() {
   // Handle button press
   handleButton();
   
-  // Update LED based on state
-  updateLED();
-  
   // Send WebSocket ping
   if (millis() - lastPingTime > WS_PING_INTERVAL) {
     if (currentState >= STATE_WS_CONNECTED) {
@@ -128,8 +158,7 @@ void setupWiFi() {
   Serial.println(WIFI_SSID);
   
   currentState = STATE_WIFI_CONNECTING;
-  leds[0] = CRGB::Yellow;  // Yellow = connecting
-  FastLED.show();
+  setStatusLed(CRGB::Yellow, LED_BREATHE);  // Yellow = connecting
   
   WiFi.mode(WIFI_STA);
   WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
@@ -149,8 +178,7 @@ void setupWiFi() {
   } else {
     Serial.println("\nWiFi connection failed!");
     currentState = STATE_ERROR;
-    leds[0] = CRGB::Red;  // Red = error
-    FastLED.show();
+    setStatusLed(CRGB::Red);  // Red = error
     while(1) delay(1000);
   }
 }
@@ -161,13 +189,13 @@ void setupI2SMicrophone() {
   // I2S configuration for PDM microphone (SPM1423)
   i2s_config_t i2s_config_mic = {
     .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_PDM),  // PDM mode!
-    .sample_rate = SAMPLE_RATE,
+    .sample_rate = audio::rate,
     .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
     .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
     .communication_format = I2S_COMM_FORMAT_STAND_I2S,
     .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 8,
-    .dma_buf_len = 64,
+    .dma_buf_count = audio::dma_buf_count,
+    .dma_buf_len = audio::dma_buf_len,
     .use_apll = false,
     .tx_desc_auto_clear = false,
     .fixed_mclk = 0
@@ -197,7 +225,7 @@ void setupI2SMicrophone() {
   }
   
   // Set clock for PDM mode
-  err = i2s_set_clk(I2S_PORT_MIC, SAMPLE_RATE, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
+  err = i2s_set_clk(I2S_PORT_MIC, audio::rate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
   if (err != ESP_OK) {
     Serial.printf("Failed to set I2S clock for mic: %d\n", err);
     currentState = STATE_ERROR;
@@ -213,13 +241,13 @@ void setupI2SSpeaker() {
   // I2S configuration for speaker (NS4168)
   i2s_config_t i2s_config_spk = {
     .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
-    .sample_rate = SAMPLE_RATE,
+    .sample_rate = audio::rate,
     .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
     .channel_format = I2S_CHANNEL_FMT_ONLY_RIGHT,
     .communication_format = I2S_COMM_FORMAT_STAND_I2S,
     .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = 8,
-    .dma_buf_len = 64,
+    .dma_buf_count = audio::dma_buf_count,
+    .dma_buf_len = audio::dma_buf_len,
     .use_apll = false,
     .tx_desc_auto_clear = true,
     .fixed_mclk = 0
@@ -283,15 +311,13 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
     case WStype_DISCONNECTED:
       Serial.println("[WS] Disconnected!");
       currentState = STATE_WIFI_CONNECTED;
-      leds[0] = CRGB::Yellow;  // Yellow = reconnecting
-      FastLED.show();
+      setStatusLed(CRGB::Yellow, LED_BREATHE);  // Yellow = reconnecting
       break;
       
     case WStype_CONNECTED:
       Serial.println("[WS] Connected to OpenAI Realtime API!");
       currentState = STATE_WS_CONNECTED;
-      leds[0] = CRGB::Cyan;  // Cyan = connected
-      FastLED.show();
+      setStatusLed(CRGB::Cyan);  // Cyan = connected
       
       // Send session configuration
       sendSessionUpdate();
@@ -299,11 +325,25 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
       
     case WStype_TEXT:
       {
+        // Audio deltas are most of the traffic - route them without building a document
+        vc_rt_event_t sniffed = vc_rt_sniff((const char*)payload, length);
+        if (sniffed == VC_RT_EVENT_AUDIO_DELTA) {
+          size_t deltaLen = 0;
+          char* delta = (char*)vc_rt_find_string((const char*)payload, length, "delta", &deltaLen);
+          if (delta) {
+            playAudioDelta(delta, deltaLen);
+            return;
+          }
+        } else if (sniffed == VC_RT_EVENT_AUDIO_TRANSCRIPT_DELTA) {
+          return;
+        }
+        
         Serial.printf("[WS] Received: %s\n", payload);
         
-        // Parse JSON
+        // Parse JSON in zero-copy mode - strings point into payload, so a
+        // large audio delta does not have to fit in the document
         DynamicJsonDocument doc(4096);
-        DeserializationError error = deserializeJson(doc, payload, length);
+        DeserializationError error = deserializeJson(doc, (char*)payload, length);
         
         if (error) {
           Serial.printf("[WS] JSON parse error: %s\n", error.c_str());
@@ -316,16 +356,15 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
           sessionId = doc["session"]["id"].as<String>();
           Serial.printf("[WS] Session created: %s\n", sessionId.c_str());
           currentState = STATE_READY;
-          leds[0] = CRGB::Green;  // Green = ready
-          FastLED.show();
+          setStatusLed(CRGB::Green);  // Green = ready
         }
         else if (strcmp(eventType, "response.audio.delta") == 0) {
           // Audio response from OpenAI
-          const char* audioBase64 = doc["delta"];
-          if (audioBase64) {
-            Serial.println("[WS] Received audio delta");
-            // TODO: Decode Base64 and play through speaker
-            currentState = STATE_SPEAKING;
+          // Only reached when the sniffer could not take the fast path
+          const char* delta = doc["delta"];
+          if (delta) {
+            char* deltaChars = const_cast<char*>(delta);
+            playAudioDelta(deltaChars, strlen(deltaChars));
           }
         }
         else if (strcmp(eventType, "error") == 0) {
@@ -353,6 +392,19 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
   }
 }
 
+// Decode a base64 audio delta in place inside the receive buffer and play the PCM
+void playAudioDelta(char* delta, size_t deltaLen) {
+  size_t pcmLen = vc_base64_decode((uint8_t*)delta, deltaLen, delta, deltaLen);
+  if (pcmLen == VC_BASE64_ERROR) {
+    Serial.println("[WS] Malformed audio delta");
+    return;
+  }
+  
+  size_t bytesWritten = 0;
+  i2s_write(I2S_PORT_SPK, delta, audio::whole_bytes(pcmLen), &bytesWritten, portMAX_DELAY);
+  currentState = STATE_SPEAKING;
+}
+
 void sendSessionUpdate() {
   Serial.println("[WS] Sending session configuration...");
   
@@ -384,11 +436,11 @@ void sendSessionUpdate() {
 void recordAndSendAudio() {
   Serial.println("[MIC] Recording audio...");
   currentState = STATE_RECORDING;
-  leds[0] = CRGB::Magenta;  // Magenta = recording
-  FastLED.show();
+  micLevel = 0;
+  setStatusLed(CRGB::Magenta, LED_LEVEL);  // Magenta = recording
   
   // Buffer for audio samples
-  int16_t audioBuffer[MIC_BUFFER_SIZE];
+  int16_t audioBuffer[audio::chunk_frames];
   size_t bytesRead = 0;
   
   // Read from PDM microphone
@@ -400,31 +452,29 @@ void recordAndSendAudio() {
     
     // Check if we got real audio data
     int nonZero = 0;
+    uint32_t magnitude = 0;
     for (int i = 0; i < samplesRead; i++) {
       if (audioBuffer[i] != 0) nonZero++;
+      magnitude += abs(audioBuffer[i]);
     }
+    micLevel = magnitude / samplesRead;
     Serial.printf("[MIC] Non-zero samples: %d / %d (%.1f%%)\n", nonZero, samplesRead, (nonZero * 100.0) / samplesRead);
     
-    // Encode to Base64
-    String audioBase64 = base64::encode((uint8_t*)audioBuffer, bytesRead);
+    // Build the append frame in place: fixed prefix, base64 audio, closing suffix.
+    // The prefix is rewritten every time because the client masks the payload in place.
+    char* frame = (char*)audioFrame + WEBSOCKETS_MAX_HEADER_SIZE;
+    vc_rt_append_init(frame);
+    size_t frameLen = vc_rt_append_fill(frame, sizeof(audioFrame) - WEBSOCKETS_MAX_HEADER_SIZE, audioBuffer, bytesRead);
     
-    // Send to OpenAI
-    DynamicJsonDocument doc(bytesRead * 2);  // Base64 is larger than binary
-    doc["type"] = "input_audio_buffer.append";
-    doc["audio"] = audioBase64;
-    
-    String output;
-    serializeJson(doc, output);
-    
-    webSocket.sendTXT(output);
+    // Send to OpenAI - header is written into the reserved space, no copy
+    webSocket.sendTXT(audioFrame, frameLen, true);
     Serial.println("[WS] Audio sent to OpenAI");
   } else {
     Serial.printf("[MIC] Read error: %d, bytes: %d\n", result, bytesRead);
   }
   
   currentState = STATE_READY;
-  leds[0] = CRGB::Green;  // Green = ready
-  FastLED.show();
+  setStatusLed(CRGB::Green);  // Green = ready
 }
 
 void handleButton() {
@@ -446,7 +496,44 @@ void handleButton() {
   lastButtonState = currentButtonState;
 }
 
-void updateLED() {
-  // LED colors are already set in state transitions
-  // This function can be used for blinking or animations
+// Post the LED state; never blocks, safe from the WebSocket callback
+void setStatusLed(CRGB color, LedEffect effect) {
+  if (!ledQueue) {
+    return;
+  }
+  LedState state = { color, effect };
+  xQueueOverwrite(ledQueue, &state);
+}
+
+// Shows the latest posted state: once when solid, every frame when animated
+void ledTask(void* arg) {
+  LedState state = { CRGB::Black, LED_SOLID };
+  unsigned long effectStart = 0;
+  uint16_t meter = 0;
+  
+  while (true) {
+    TickType_t wait = state.effect == LED_SOLID ? portMAX_DELAY : pdMS_TO_TICKS(LED_FRAME_MS);
+    LedState next;
+    if (xQueueReceive(ledQueue, &next, wait) == pdTRUE) {
+      if (next.effect != state.effect) {
+        effectStart = millis();
+        meter = 0;
+      }
+      state = next;
+    }
+    
+    CRGB frame = state.color;
+    if (state.effect == LED_BREATHE) {
+      uint8_t phase = (millis() - effectStart) % LED_BREATHE_PERIOD_MS * 256 / LED_BREATHE_PERIOD_MS;
+      frame.nscale8(qadd8(quadwave8(phase), 24));  // Never quite off
+    } else if (state.effect == LED_LEVEL) {
+      // Jumps up with the level, falls back an eighth per frame
+      uint16_t level = micLevel;
+      meter = level > meter ? level : meter - (meter >> 3);
+      uint16_t clipped = meter < LED_LEVEL_FULL ? meter : LED_LEVEL_FULL;
+      frame.nscale8(48 + 207 * clipped / LED_LEVEL_FULL);
+    }
+    leds[0] = frame;
+    FastLED.show();
+  }
 }
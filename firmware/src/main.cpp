@@ -13,6 +13,8 @@
 #include <driver/i2s.h>
 #include <M5Atom.h>
 #include <ArduinoJson.h>
+#include <vc_adpcm.h>    // From ../voice_core (lib_deps in platformio.ini)
+#include <vc_pipeline.hpp>
 
 // WiFi Configuration - UPDATE THESE!
 const char *WIFI_SSID = "Everest";  // Your WiFi name
@@ -30,15 +32,37 @@ const char *SERVER_URL = "http://192.168.1.237:8000/api/voice";  // Your server
 
 #define MODE_MIC  0
 #define MODE_SPK  1
-#define DATA_SIZE 1024
 #define MAX_RECORD_TIME_MS 5000  // 5 seconds max recording
 
-// Audio buffer
-static uint8_t microphonedata0[1024 * 70];  // ~70KB buffer
+// Mic and speaker share one shape: 16kHz mono PCM16, 32 ms per i2s_read
+typedef vc::pipeline<int16_t, 16000, 1, 512> audio;
+
+#define DATA_SIZE audio::chunk_bytes
+#define MIC_BUFFER_INTERNAL (audio::chunk_bytes * 70)  // ~2.2s, all internal RAM can spare next to Wi-Fi
+#define MIC_BUFFER_PSRAM    audio::bytes_for_ms(MAX_RECORD_TIME_MS)  // Full MAX_RECORD_TIME_MS
+#define UPLOAD_RATE_PARAM   "; rate=16000"
+static_assert(audio::rate == 16000, "UPLOAD_RATE_PARAM names the capture rate");
+#define RESPONSE_CHUNK_SIZE 4096
+#define RESPONSE_IDLE_TIMEOUT_MS 5000  // Give up if the server stops sending mid-reply
+#define UPLINK_ADPCM 1                 // Upload IMA-ADPCM (4:1) if the server supports it, else PCM16
+
+// Audio buffers - allocated once in setup(), so a turn never touches the heap.
+// The recording goes to PSRAM when the board has it; the response chunk feeds
+// I2S and stays in internal RAM.
+static uint8_t *microphonedata0 = NULL;
+static size_t mic_buffer_size = 0;
+static uint8_t responseChunk[RESPONSE_CHUNK_SIZE];
 size_t byte_read = 0;
 uint32_t data_offset = 0;
 bool is_recording = false;
 
+// High-water marks of the buffers above
+size_t mic_high_water = 0;
+size_t response_high_water = 0;
+
+// Set by probeServerCodecs() once the server has listed "ima-adpcm"
+bool server_adpcm = false;
+
 // LED Colors
 #define LED_IDLE      CRGB(0, 50, 0)     // Green - ready
 #define LED_RECORDING CRGB(50, 0, 0)     // Red - recording
@@ -52,7 +76,7 @@ bool InitI2SSpeakerOrMic(int mode) {
     i2s_driver_uninstall(SPEAKER_I2S_NUMBER);
     i2s_config_t i2s_config = {
         .mode        = (i2s_mode_t)(I2S_MODE_MASTER),
-        .sample_rate = 16000,
+        .sample_rate = audio::rate,
         .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
         .channel_format = I2S_CHANNEL_FMT_ALL_RIGHT,
 #if ESP_IDF_VERSION > ESP_IDF_VERSION_VAL(4, 1, 0)
@@ -61,8 +85,8 @@ bool InitI2SSpeakerOrMic(int mode) {
         .communication_format = I2S_COMM_FORMAT_I2S,
 #endif
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count    = 6,
-        .dma_buf_len      = 60,
+        .dma_buf_count    = audio::dma_buf_count,
+        .dma_buf_len      = audio::dma_buf_len,
     };
 
     if (mode == MODE_MIC) {
@@ -85,61 +109,191 @@ bool InitI2SSpeakerOrMic(int mode) {
     tx_pin_config.data_in_num  = CONFIG_I2S_DATA_IN_PIN;
 
     err += i2s_set_pin(SPEAKER_I2S_NUMBER, &tx_pin_config);
-    err += i2s_set_clk(SPEAKER_I2S_NUMBER, 16000, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
+    err += i2s_set_clk(SPEAKER_I2S_NUMBER, audio::rate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
 
     return (err == ESP_OK);
 }
 
-bool sendAudioToServer(uint8_t* audio_data, size_t audio_len, uint8_t** response_audio, size_t* response_len) {
+// Ask the server root which uplink codecs /api/voice decodes.
+// Servers without the list predate ADPCM and only take PCM16.
+void probeServerCodecs() {
+    String url(SERVER_URL);
+    int api = url.indexOf("/api/");
+    if (api > 0) {
+        url = url.substring(0, api + 1);
+    }
+    
+    HTTPClient http;
+    http.begin(url);
+    http.setTimeout(5000);
+    if (http.GET() == HTTP_CODE_OK) {
+        StaticJsonDocument<512> doc;
+        if (!deserializeJson(doc, http.getString())) {
+            for (JsonVariant codec : doc["uplink_codecs"].as<JsonArray>()) {
+                if (codec == "ima-adpcm") {
+                    server_adpcm = true;
+                }
+            }
+        }
+    }
+    http.end();
+    Serial.printf("Uplink codec: %s\n", UPLINK_ADPCM && server_adpcm ? "IMA-ADPCM" : "PCM16");
+}
+
+// Encode the recording to IMA-ADPCM in place, returns the new length
+size_t encodeUplinkAdpcm(uint8_t* audio_data, size_t audio_len) {
+    size_t samples = audio_len / sizeof(int16_t);
+    vc_adpcm_state_t adpcm;
+    vc_adpcm_init(&adpcm);
+    
+    unsigned long start_us = micros();
+    size_t encoded = vc_adpcm_encode(&adpcm, (const int16_t*)audio_data, samples, audio_data);
+    encoded += vc_adpcm_encode_flush(&adpcm, audio_data + encoded);
+    unsigned long encode_us = micros() - start_us;
+    
+    // 320 samples = one 20 ms frame at 16kHz
+    Serial.printf("ADPCM: %d -> %d bytes (%d saved) in %lu us, %lu us per 20 ms frame\n",
+                  audio_len, encoded, audio_len - encoded, encode_us,
+                  samples ? encode_us * 320 / samples : 0);
+    return encoded;
+}
+
+// Transfer-Encoding: chunked, undone as the body arrives. HTTPClient only
+// de-chunks in writeToStream(); getStreamPtr() hands out the raw framing.
+struct ChunkedBody {
+    size_t remaining = 0;  // Payload bytes left in the current chunk
+    bool done = false;     // Zero-size chunk seen
+};
+
+// Copy up to want payload bytes into buf, returns 0 while only framing was read
+int readChunked(WiFiClient* stream, ChunkedBody& body, uint8_t* buf, size_t want) {
+    if (body.remaining == 0) {
+        // "<hex size>[;ext]\r\n" - the size line is a few bytes, so it's read in one go
+        String line = stream->readStringUntil('\n');
+        body.remaining = strtoul(line.c_str(), NULL, 16);
+        if (body.remaining == 0) {
+            body.done = true;  // Trailer and final CRLF are left to http.end()
+        }
+        return 0;
+    }
+    
+    int n = stream->readBytes(buf, min(want, body.remaining));
+    if (n > 0) {
+        body.remaining -= n;
+        if (body.remaining == 0) {
+            stream->readStringUntil('\n');  // CRLF after the chunk data
+        }
+    }
+    return n;
+}
+
+bool sendAudioAndPlayResponse(uint8_t* audio_data, size_t audio_len, const char* content_type) {
     HTTPClient http;
     
     Serial.println("Connecting to server...");
     http.begin(SERVER_URL);
-    http.addHeader("Content-Type", "application/octet-stream");
+    http.addHeader("Content-Type", content_type);
+    http.addHeader("X-Device-ID", WiFi.macAddress());  // Server keeps one conversation per device
     http.setTimeout(30000);  // 30 second timeout for AI processing
     
     Serial.printf("Sending %d bytes of audio data...\n", audio_len);
     int httpCode = http.POST(audio_data, audio_len);
     
-    if (httpCode == HTTP_CODE_OK) {
-        int len = http.getSize();
-        if (len > 0) {
-            Serial.printf("Received %d bytes of audio response\n", len);
-            *response_audio = (uint8_t*)malloc(len);
-            if (*response_audio) {
-                WiFiClient* stream = http.getStreamPtr();
-                size_t received = 0;
-                while (received < len && stream->available()) {
-                    int chunk = stream->readBytes(*response_audio + received, len - received);
-                    if (chunk > 0) {
-                        received += chunk;
-                    }
-                    delay(1);
-                }
-                *response_len = received;
-                http.end();
-                return true;
-            }
-        }
-    } else {
+    if (httpCode != HTTP_CODE_OK) {
         Serial.printf("HTTP POST failed: %d - %s\n", httpCode, http.errorToString(httpCode).c_str());
+        http.end();
+        return false;
     }
     
-    http.end();
-    return false;
-}
-
-void playAudio(uint8_t* audio_data, size_t audio_len) {
-    if (!audio_data || audio_len == 0) return;
+    // -1 when the server streams TTS as it is generated (chunked transfer)
+    int len = http.getSize();
+    bool chunked = len < 0;
+    if (len == 0) {
+        Serial.println("Empty audio response");
+        http.end();
+        return false;
+    }
+    if (chunked) {
+        Serial.println("Receiving streamed audio response");
+    } else {
+        Serial.printf("Receiving %d bytes of audio response\n", len);
+    }
     
+    // Play while receiving, one chunk at a time, instead of holding the whole reply
     Serial.println("Playing audio response...");
     InitI2SSpeakerOrMic(MODE_SPK);
     M5.dis.drawpix(0, LED_SPEAKING);
     
-    size_t bytes_written;
-    i2s_write(SPEAKER_I2S_NUMBER, audio_data, audio_len, &bytes_written, portMAX_DELAY);
+    WiFiClient* stream = http.getStreamPtr();
+    ChunkedBody body;
+    size_t received = 0;
+    size_t carry = 0;  // Partial frame held back so I2S writes stay frame-aligned
+    unsigned long last_data = millis();
     
+    while (chunked ? !body.done : received < (size_t)len) {
+        size_t available = stream->available();
+        if (available == 0) {
+            if (!http.connected() || millis() - last_data > RESPONSE_IDLE_TIMEOUT_MS) {
+                break;
+            }
+            delay(1);
+            continue;
+        }
+        
+        last_data = millis();
+        size_t want = min(available, sizeof(responseChunk) - carry);
+        int chunk;
+        if (chunked) {
+            chunk = readChunked(stream, body, responseChunk + carry, want);
+        } else {
+            want = min(want, (size_t)len - received);
+            chunk = stream->readBytes(responseChunk + carry, want);
+        }
+        if (chunk <= 0) {
+            continue;
+        }
+        received += chunk;
+        
+        size_t total = carry + chunk;
+        response_high_water = max(response_high_water, total);
+        size_t aligned = audio::whole_bytes(total);
+        size_t bytes_written;
+        i2s_write(SPEAKER_I2S_NUMBER, responseChunk, aligned, &bytes_written, portMAX_DELAY);
+        carry = total - aligned;
+        memmove(responseChunk, responseChunk + aligned, carry);
+    }
+    
+    http.end();
     delay(100);  // Small delay to ensure playback completes
+    
+    if (chunked ? !body.done : received < (size_t)len) {
+        Serial.printf("Response ended early: %d bytes received\n", received);
+    }
+    return received > 0;
+}
+
+bool allocateAudioBuffers() {
+    // Internal RAM is what TLS and Wi-Fi run out of first, keep the bulk buffer out of it if possible
+    bool in_psram = false;
+    if (psramFound()) {
+        microphonedata0 = (uint8_t*)ps_malloc(MIC_BUFFER_PSRAM);
+        mic_buffer_size = MIC_BUFFER_PSRAM;
+        in_psram = microphonedata0 != NULL;
+    }
+    if (!microphonedata0) {
+        microphonedata0 = (uint8_t*)heap_caps_malloc(MIC_BUFFER_INTERNAL, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        mic_buffer_size = MIC_BUFFER_INTERNAL;
+    }
+    if (!microphonedata0) {
+        mic_buffer_size = 0;
+        return false;
+    }
+    
+    Serial.printf("Mic buffer: %d bytes in %s (internal free: %d, largest block: %d)\n",
+                  mic_buffer_size, in_psram ? "PSRAM" : "internal RAM",
+                  heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                  heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    return true;
 }
 
 void setup() {
@@ -150,6 +304,13 @@ void setup() {
     Serial.println("\n\nM5Stack Echo - Voice AI Gateway");
     Serial.println("================================");
     
+    // Before Wi-Fi, while internal RAM is still in one piece
+    if (!allocateAudioBuffers()) {
+        Serial.println("Failed to allocate mic buffer!");
+        M5.dis.drawpix(0, LED_ERROR);
+        return;
+    }
+    
     // Initialize speaker mode first
     InitI2SSpeakerOrMic(MODE_SPK);
     delay(100);
@@ -174,6 +335,7 @@ void setup() {
         Serial.println("WiFi Connected!");
         Serial.printf("IP Address: %s\n", WiFi.localIP().toString().c_str());
         Serial.printf("Server URL: %s\n", SERVER_URL);
+        probeServerCodecs();
         Serial.println("\nReady! Press button to record voice.");
         M5.dis.drawpix(0, LED_IDLE);
     } else {
@@ -186,7 +348,7 @@ void loop() {
     M5.update();
     
     // Button pressed - start recording
-    if (M5.Btn.isPressed() && !is_recording) {
+    if (M5.Btn.isPressed() && !is_recording && microphonedata0) {
         is_recording = true;
         data_offset = 0;
         
@@ -206,7 +368,7 @@ void loop() {
             data_offset += byte_read;
             
             // Check if buffer is full
-            if (data_offset >= sizeof(microphonedata0) - DATA_SIZE) {
+            if (data_offset >= mic_buffer_size - DATA_SIZE) {
                 Serial.println("Buffer full!");
                 break;
             }
@@ -223,16 +385,20 @@ void loop() {
             M5.dis.drawpix(0, LED_SENDING);
             Serial.println("Sending to AI server...");
             
-            uint8_t* response_audio = NULL;
-            size_t response_len = 0;
+            mic_high_water = max(mic_high_water, (size_t)data_offset);
             
-            if (sendAudioToServer(microphonedata0, data_offset, &response_audio, &response_len)) {
-                Serial.println("AI response received!");
-                
-                if (response_audio && response_len > 0) {
-                    playAudio(response_audio, response_len);
-                    free(response_audio);
-                }
+            size_t upload_len = data_offset;
+            const char* content_type = "application/octet-stream" UPLOAD_RATE_PARAM;
+            if (UPLINK_ADPCM && server_adpcm) {
+                upload_len = encodeUplinkAdpcm(microphonedata0, data_offset);
+                content_type = VC_ADPCM_CONTENT_TYPE UPLOAD_RATE_PARAM;
+            }
+            
+            if (sendAudioAndPlayResponse(microphonedata0, upload_len, content_type)) {
+                Serial.println("AI response played!");
+                Serial.printf("Buffer high-water: mic %d/%d, response %d/%d bytes\n",
+                              mic_high_water, mic_buffer_size,
+                              response_high_water, sizeof(responseChunk));
                 
                 M5.dis.drawpix(0, LED_IDLE);
                 Serial.println("Ready for next recording.\n");
@@ -5,6 +5,7 @@
  */
 
 #include <stdio.h>
+#include <limits.h>
 
 #include "esp_websocket_client.h"
 #include "esp_transport.h"
@@ -20,6 +21,7 @@
 #include "esp_timer.h"
 #include "esp_tls_crypto.h"
 #include "esp_system.h"
+#include "esp_random.h"
 #include <errno.h>
 #include <arpa/inet.h>
 
@@ -38,6 +40,7 @@ static const char *TAG = "websocket_client";
 #define WEBSOCKET_KEEP_ALIVE_IDLE       (5)
 #define WEBSOCKET_KEEP_ALIVE_INTERVAL   (5)
 #define WEBSOCKET_KEEP_ALIVE_COUNT      (3)
+#define WEBSOCKET_MAX_HEADER_SIZE       (14)    // 2 + 8 byte length + 4 byte mask key
 
 #ifdef CONFIG_ESP_WS_CLIENT_SEPARATE_TX_LOCK
 #define WEBSOCKET_TX_LOCK_TIMEOUT_MS    (CONFIG_ESP_WS_CLIENT_TX_LOCK_TIMEOUT_MS)
@@ -113,6 +116,7 @@ typedef struct {
     const char                  *cert_common_name;
     esp_err_t (*crt_bundle_attach)(void *conf);
     esp_transport_handle_t      ext_transport;
+    esp_websocket_data_cb_t     data_cb;
 } websocket_config_storage_t;
 
 typedef enum {
@@ -154,6 +158,8 @@ struct esp_websocket_client {
     ws_transport_opcodes_t      last_opcode;
     int                         payload_len;
     int                         payload_offset;
+    ws_transport_opcodes_t      message_opcode;
+    size_t                      message_offset;
     esp_transport_keep_alive_t  keep_alive_cfg;
     struct ifreq                *if_name;
 };
@@ -387,6 +393,7 @@ static esp_err_t esp_websocket_client_set_config(esp_websocket_client_handle_t c
 
 
     cfg->user_context = config->user_context;
+    cfg->data_cb = config->data_cb;
     cfg->auto_reconnect = true;
     if (config->disable_auto_reconnect) {
         cfg->auto_reconnect = false;
@@ -618,6 +625,46 @@ static esp_err_t esp_websocket_client_create_transport(esp_websocket_client_hand
     return ESP_OK;
 }
 
+/**
+ * Copy len payload bytes into dst, masked with key starting at payload offset phase.
+ * Word-at-a-time once dst is aligned; the same pass replaces the memcpy of the copying path.
+ */
+static void esp_websocket_mask_copy(uint8_t *dst, const uint8_t *src, size_t len, const uint8_t key[4], size_t phase)
+{
+    size_t i = 0;
+    for (; i < len && ((uintptr_t)(dst + i) & 3); i++) {
+        dst[i] = src[i] ^ key[(phase + i) & 3];
+    }
+    if (len - i >= 4) {
+        uint8_t rotated[4];
+        for (int k = 0; k < 4; k++) {
+            rotated[k] = key[(phase + i + k) & 3];
+        }
+        uint32_t mask;
+        memcpy(&mask, rotated, sizeof(mask));
+        for (; i + 4 <= len; i += 4) {
+            uint32_t word;
+            memcpy(&word, src + i, sizeof(word));
+            *(uint32_t *)(dst + i) = word ^ mask;
+        }
+    }
+    for (; i < len; i++) {
+        dst[i] = src[i] ^ key[(phase + i) & 3];
+    }
+}
+
+/**
+ * Transport under the websocket layer (TCP or TLS), NULL for an external transport
+ */
+static esp_transport_handle_t esp_websocket_base_transport(esp_websocket_client_handle_t client)
+{
+    if (client->config->ext_transport || !client->transport_list) {
+        return NULL;
+    }
+    const char *name = strcasecmp(client->config->scheme, WS_OVER_TLS_SCHEME) == 0 ? "_ssl" : "_tcp";
+    return esp_transport_list_get_transport(client->transport_list, name);
+}
+
 static int esp_websocket_client_send_with_exact_opcode(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout)
 {
     int ret = -1;
@@ -988,6 +1035,36 @@ esp_err_t esp_websocket_client_append_header(esp_websocket_client_handle_t clien
     return ESP_OK;
 }
 
+/**
+ * Pass a data fragment to the streaming receive callback, no event loop round trip
+ *
+ * @return false for control frames, which are dispatched as events
+ */
+static bool esp_websocket_client_deliver_fragment(esp_websocket_client_handle_t client, int rlen)
+{
+    ws_transport_opcodes_t opcode = client->last_opcode;
+    if (opcode != WS_TRANSPORT_OPCODES_TEXT && opcode != WS_TRANSPORT_OPCODES_BINARY &&
+        opcode != WS_TRANSPORT_OPCODES_CONT) {
+        return false;
+    }
+    if (opcode != WS_TRANSPORT_OPCODES_CONT && client->payload_offset == 0) {
+        client->message_opcode = opcode;
+        client->message_offset = 0;
+    }
+
+    esp_websocket_fragment_t fragment = {
+        .data_ptr = client->rx_buffer,
+        .data_len = rlen,
+        .op_code = client->message_opcode,
+        .payload_len = client->payload_len,
+        .payload_offset = client->payload_offset,
+        .message_offset = client->message_offset,
+        .fin = client->last_fin,
+    };
+    client->config->data_cb(&fragment, client->config->user_context);
+    return true;
+}
+
 static esp_err_t esp_websocket_client_recv(esp_websocket_client_handle_t client)
 {
     int rlen;
@@ -1020,7 +1097,11 @@ static esp_err_t esp_websocket_client_recv(esp_websocket_client_handle_t client)
             return ESP_OK;
         }
 
-        esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_DATA, client->rx_buffer, rlen);
+        if (client->config->data_cb && esp_websocket_client_deliver_fragment(client, rlen)) {
+            client->message_offset += rlen;
+        } else {
+            esp_websocket_client_dispatch_event(client, WEBSOCKET_EVENT_DATA, client->rx_buffer, rlen);
+        }
 
         client->payload_offset += rlen;
     } while (client->payload_offset < client->payload_len);
@@ -1406,6 +1487,133 @@ int esp_websocket_client_send_fin(esp_websocket_client_handle_t client, TickType
     return esp_websocket_client_send_with_exact_opcode(client, WS_TRANSPORT_OPCODES_FIN, NULL, 0, timeout);
 }
 
+int esp_websocket_client_send_iov(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode,
+                                  const esp_websocket_iov_t *iov, int iovcnt, TickType_t timeout)
+{
+    if (client == NULL || iovcnt < 0 || (iov == NULL && iovcnt > 0)) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return -1;
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        len += iov[i].len;
+    }
+    if (len > INT_MAX) {
+        ESP_LOGE(TAG, "Invalid arguments");
+        return -1;
+    }
+
+    if (!esp_websocket_client_is_connected(client)) {
+        ESP_LOGE(TAG, "Websocket client is not connected");
+        return -1;
+    }
+
+    esp_transport_handle_t base = esp_websocket_base_transport(client);
+    if (base == NULL || client->buffer_size < WEBSOCKET_MAX_HEADER_SIZE + 4) {
+        // No access to the raw connection: send the segments as fragments of one message
+        int sent = 0;
+        for (int i = 0; i < iovcnt || i == 0; i++) {
+            ws_transport_opcodes_t frag_opcode = (i == 0 ? opcode : WS_TRANSPORT_OPCODES_CONT) & ~WS_TRANSPORT_OPCODES_FIN;
+            if (i >= iovcnt - 1) {
+                frag_opcode |= WS_TRANSPORT_OPCODES_FIN;
+            }
+            int ret = esp_websocket_client_send_with_exact_opcode(client, frag_opcode,
+                                                                  iovcnt ? iov[i].data : NULL, iovcnt ? (int)iov[i].len : 0, timeout);
+            if (ret < 0) {
+                return ret;
+            }
+            sent += ret;
+        }
+        return sent;
+    }
+
+#ifdef CONFIG_ESP_WS_CLIENT_SEPARATE_TX_LOCK
+    if (xSemaphoreTakeRecursive(client->tx_lock, timeout) != pdPASS) {
+        ESP_LOGE(TAG, "Could not lock ws-client within %" PRIu32 " timeout", timeout);
+        return -1;
+    }
+#else
+    if (xSemaphoreTakeRecursive(client->lock, timeout) != pdPASS) {
+        ESP_LOGE(TAG, "Could not lock ws-client within %" PRIu32 " timeout", timeout);
+        return -1;
+    }
+#endif
+
+    int ret = -1;
+#ifdef CONFIG_ESP_WS_CLIENT_ENABLE_DYNAMIC_BUFFER
+    // Kept between frames; freed by the next copying send or when the client is destroyed
+    if (client->tx_buffer == NULL) {
+        client->tx_buffer = malloc(client->buffer_size);
+        ESP_WS_CLIENT_MEM_CHECK(TAG, client->tx_buffer, goto unlock_and_return);
+    }
+#endif
+    uint8_t *buf = (uint8_t *)client->tx_buffer;
+    int timeout_ms = (timeout == portMAX_DELAY) ? -1 : timeout * portTICK_PERIOD_MS;
+
+    // Header goes in front of the first payload bytes, so short frames are a single write
+    size_t fill = 0;
+    buf[fill++] = (uint8_t)((opcode & 0x0f) | WS_TRANSPORT_OPCODES_FIN);
+    if (len <= 125) {
+        buf[fill++] = (uint8_t)(0x80 | len);
+    } else if (len <= 0xffff) {
+        buf[fill++] = 0x80 | 126;
+        buf[fill++] = (uint8_t)(len >> 8);
+        buf[fill++] = (uint8_t)len;
+    } else {
+        buf[fill++] = 0x80 | 127;
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            buf[fill++] = (uint8_t)((uint64_t)len >> shift);
+        }
+    }
+    uint8_t key[4];
+    uint32_t random = esp_random();
+    memcpy(key, &random, sizeof(key));
+    memcpy(buf + fill, key, sizeof(key));
+    fill += sizeof(key);
+
+    size_t offset = 0;  // Payload bytes masked so far (mask phase)
+    for (int i = 0; i <= iovcnt; i++) {
+        const uint8_t *src = i < iovcnt ? (const uint8_t *)iov[i].data : NULL;
+        size_t remaining = i < iovcnt ? iov[i].len : 0;
+        while (remaining > 0) {
+            size_t n = client->buffer_size - fill;
+            if (n > remaining) {
+                n = remaining;
+            }
+            esp_websocket_mask_copy(buf + fill, src, n, key, offset);
+            fill += n;
+            src += n;
+            offset += n;
+            remaining -= n;
+            if (fill < (size_t)client->buffer_size) {
+                break;  // Room left, top it up from the next segment
+            }
+            if (esp_transport_write(base, (const char *)buf, fill, timeout_ms) != (int)fill) {
+                goto write_error;
+            }
+            fill = 0;
+        }
+    }
+    if (fill > 0 && esp_transport_write(base, (const char *)buf, fill, timeout_ms) != (int)fill) {
+        goto write_error;
+    }
+    ret = (int)len;
+    goto unlock_and_return;
+
+write_error:
+    esp_websocket_client_error(client, "esp_transport_write() failed on a %d byte frame, errno=%d", (int)len, errno);
+    esp_websocket_client_abort_connection(client, WEBSOCKET_ERROR_TYPE_TCP_TRANSPORT);
+
+unlock_and_return:
+#ifdef CONFIG_ESP_WS_CLIENT_SEPARATE_TX_LOCK
+    xSemaphoreGiveRecursive(client->tx_lock);
+#else
+    xSemaphoreGiveRecursive(client->lock);
+#endif
+    return ret;
+}
+
 int esp_websocket_client_send_with_opcode(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode, const uint8_t *data, int len, TickType_t timeout)
 {
     return esp_websocket_client_send_with_exact_opcode(client, opcode | WS_TRANSPORT_OPCODES_FIN, data, len, timeout);
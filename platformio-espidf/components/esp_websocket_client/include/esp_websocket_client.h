@@ -93,6 +93,32 @@ typedef struct {
     esp_websocket_error_codes_t error_handle; /*!< esp-websocket error handle including esp-tls errors as well as internal websocket errors */
 } esp_websocket_event_data_t;
 
+/**
+ * @brief One segment of a frame sent with esp_websocket_client_send_iov()
+ */
+typedef struct {
+    const void *data;                       /*!< Segment data (only read) */
+    size_t len;                             /*!< Segment length */
+} esp_websocket_iov_t;
+
+/**
+ * @brief One received piece of a text or binary message, see esp_websocket_client_config_t::data_cb
+ */
+typedef struct {
+    const char *data_ptr;                   /*!< Fragment data, only valid during the callback */
+    int data_len;                           /*!< Fragment length, at most buffer_size */
+    ws_transport_opcodes_t op_code;         /*!< Opcode of the message (TEXT or BINARY, also for its continuation frames) */
+    int payload_len;                        /*!< Total payload length of the current frame */
+    int payload_offset;                     /*!< Offset of this fragment within the current frame */
+    size_t message_offset;                  /*!< Offset of this fragment within the whole message */
+    bool fin;                               /*!< The current frame is the last of the message */
+} esp_websocket_fragment_t;
+
+/**
+ * @brief Streaming receive callback, runs on the websocket task
+ */
+typedef void (*esp_websocket_data_cb_t)(const esp_websocket_fragment_t *fragment, void *user_context);
+
 /**
  * @brief Websocket Client transport
  */
@@ -147,6 +173,7 @@ typedef struct {
     size_t                      ping_interval_sec;          /*!< Websocket ping interval, defaults to 10 seconds if not set */
     struct ifreq                *if_name;                   /*!< The name of interface for data to go through. Use the default interface without setting */
     esp_transport_handle_t      ext_transport;              /*!< External WebSocket tcp_transport handle to the client; or if null, the client will create its own transport handle. */
+    esp_websocket_data_cb_t     data_cb;                    /*!< Streaming receive: text and binary data is passed to this callback fragment by fragment, straight from the rx buffer, instead of being posted as WEBSOCKET_EVENT_DATA. Control frames are still posted as events. */
 } esp_websocket_client_config_t;
 
 /**
@@ -350,6 +377,31 @@ int esp_websocket_client_send_cont_msg(esp_websocket_client_handle_t client, con
  */
 int esp_websocket_client_send_fin(esp_websocket_client_handle_t client, TickType_t timeout);
 
+/**
+ * @brief      Write one complete frame whose payload is the concatenation of several segments
+ *
+ *  Notes:
+ *   - Nothing is allocated per frame: the payload is masked word-at-a-time straight from
+ *     the segments into the client's tx buffer, which also holds the frame header, and each
+ *     buffer_size fill goes out as one transport write. With dynamic buffers enabled the
+ *     tx buffer is kept between frames.
+ *   - Use it for high-rate frames that are assembled from parts (e.g. a fixed prefix,
+ *     a payload and a suffix) without first copying them together.
+ *   - With an external transport the segments are sent as fragments of one message.
+ *
+ * @param[in]  client  The client
+ * @param[in]  opcode  WS_TRANSPORT_OPCODES_TEXT or WS_TRANSPORT_OPCODES_BINARY (FIN is implied)
+ * @param[in]  iov     The segments
+ * @param[in]  iovcnt  Number of segments
+ * @param[in]  timeout Write data timeout in RTOS ticks
+ *
+ * @return
+ *     - Number of payload bytes sent
+ *     - (-1) if any errors
+ */
+int esp_websocket_client_send_iov(esp_websocket_client_handle_t client, ws_transport_opcodes_t opcode,
+                                  const esp_websocket_iov_t *iov, int iovcnt, TickType_t timeout);
+
 /**
  * @brief      Write opcode data to the WebSocket connection
  *
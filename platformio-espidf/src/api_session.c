@@ -0,0 +1,307 @@
+/**
+ * Persistent HTTPS sessions to api.openai.com
+ *
+ * Every stage of a turn talks to the same host, so instead of paying a
+ * full TLS handshake per call the clients are created once and their
+ * connections are kept alive between requests. Each pooled client has a
+ * fixed event handler that forwards to the handler of the current request.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "api_session.h"
+#include "../credentials.h"
+
+static const char *TAG = "api_session";
+
+#define API_BASE_URL            "https://api.openai.com"
+#define API_SESSION_POOL_SIZE   2        // Lets a Whisper/Chat request overlap with TTS
+#define API_SESSION_BUFFER_SIZE 4096
+#define API_SESSION_IDLE_MS     60000    // Older connections are assumed closed by the server
+#define API_PREWARM_PATH        "/v1/models/whisper-1"  // Small authenticated GET
+#define API_SESSION_READ_CHUNK  1024
+
+typedef struct {
+    esp_http_client_handle_t client;
+    bool busy;
+    bool connected;              // Connection is open and can be reused
+    bool retryable;              // Request went out on a kept-alive connection, not yet resent
+    int64_t last_used_us;
+    uint32_t handshakes;
+    size_t rx_bytes;             // Body bytes delivered during the current attempt
+    http_event_handle_cb handler;
+    void *user_data;
+} api_slot_t;
+
+static api_slot_t s_slots[API_SESSION_POOL_SIZE];
+static SemaphoreHandle_t s_free = NULL;
+static SemaphoreHandle_t s_lock = NULL;
+
+/**
+ * Shared event handler - tracks connection state, then forwards to the request's handler
+ */
+static esp_err_t session_event_handler(esp_http_client_event_t *evt)
+{
+    api_slot_t *slot = (api_slot_t *)evt->user_data;
+
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            slot->connected = true;
+            slot->handshakes++;
+            ESP_LOGI(TAG, "New connection on slot %d (handshake #%lu)", (int)(slot - s_slots), slot->handshakes);
+            break;
+        case HTTP_EVENT_DISCONNECTED:
+            slot->connected = false;
+            break;
+        case HTTP_EVENT_ON_DATA:
+            slot->rx_bytes += evt->data_len;
+            break;
+        default:
+            break;
+    }
+
+    if (!slot->handler) {
+        return ESP_OK;
+    }
+    evt->user_data = slot->user_data;
+    esp_err_t ret = slot->handler(evt);
+    evt->user_data = slot;
+    return ret;
+}
+
+static api_slot_t *find_slot(esp_http_client_handle_t client)
+{
+    for (int i = 0; i < API_SESSION_POOL_SIZE; i++) {
+        if (s_slots[i].client == client) {
+            return &s_slots[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * A request failed: if it was the first try on a kept-alive connection and
+ * no response came back, the server had closed the connection while idle.
+ * Drop it so the retry reconnects (once per request).
+ */
+static bool take_retry(api_slot_t *slot)
+{
+    if (!slot->retryable || slot->rx_bytes > 0) {
+        return false;
+    }
+    slot->retryable = false;
+    ESP_LOGW(TAG, "Kept-alive connection was closed by the server, reconnecting");
+    esp_http_client_close(slot->client);
+    slot->connected = false;
+    return true;
+}
+
+esp_err_t api_session_init(void)
+{
+    if (s_free) {
+        return ESP_OK;
+    }
+
+    char auth_header[256];
+    snprintf(auth_header, sizeof(auth_header), "Bearer %s", OPENAI_API_KEY);
+
+    for (int i = 0; i < API_SESSION_POOL_SIZE; i++) {
+        api_slot_t *slot = &s_slots[i];
+        esp_http_client_config_t config = {
+            .url = API_BASE_URL API_PREWARM_PATH,
+            .event_handler = session_event_handler,
+            .user_data = slot,
+            .crt_bundle_attach = esp_crt_bundle_attach,
+            .buffer_size = API_SESSION_BUFFER_SIZE,
+            .keep_alive_enable = true,  // TCP keep-alive so idle NAT mappings survive between turns
+        };
+        slot->client = esp_http_client_init(&config);
+        if (!slot->client) {
+            ESP_LOGE(TAG, "Failed to create HTTP client %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+        esp_http_client_set_header(slot->client, "Authorization", auth_header);
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    s_free = xSemaphoreCreateCounting(API_SESSION_POOL_SIZE, API_SESSION_POOL_SIZE);
+    if (!s_lock || !s_free) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_http_client_handle_t api_session_acquire(esp_http_client_method_t method, const char *path, int timeout_ms,
+                                             http_event_handle_cb handler, void *user_data)
+{
+    if (!s_free) {
+        return NULL;
+    }
+    xSemaphoreTake(s_free, portMAX_DELAY);
+
+    // Prefer a slot whose connection is still open
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    api_slot_t *slot = NULL;
+    for (int i = 0; i < API_SESSION_POOL_SIZE; i++) {
+        if (!s_slots[i].busy && (!slot || (s_slots[i].connected && !slot->connected))) {
+            slot = &s_slots[i];
+        }
+    }
+    slot->busy = true;
+    xSemaphoreGive(s_lock);
+
+    esp_http_client_handle_t client = slot->client;
+    if (slot->connected && esp_timer_get_time() - slot->last_used_us > API_SESSION_IDLE_MS * 1000LL) {
+        esp_http_client_close(client);
+        slot->connected = false;
+    }
+
+    char url[128];
+    snprintf(url, sizeof(url), API_BASE_URL "%s", path);
+    esp_http_client_set_url(client, url);  // Same host, so the connection is kept
+    esp_http_client_set_method(client, method);
+    esp_http_client_set_timeout_ms(client, timeout_ms);
+
+    // Headers persist on the handle - drop the previous request's body and framing
+    esp_http_client_set_post_field(client, NULL, 0);
+    esp_http_client_delete_header(client, "Content-Type");
+    esp_http_client_delete_header(client, "Transfer-Encoding");
+
+    slot->handler = handler;
+    slot->user_data = user_data;
+    slot->rx_bytes = 0;
+    slot->retryable = slot->connected;
+    return client;
+}
+
+esp_err_t api_session_perform(esp_http_client_handle_t client)
+{
+    api_slot_t *slot = find_slot(client);
+
+    esp_err_t err = esp_http_client_perform(client);
+    if (err != ESP_OK && take_retry(slot)) {
+        err = esp_http_client_perform(client);
+    }
+    return err;
+}
+
+/**
+ * Send the request with its post field as the body and read the response headers
+ */
+static esp_err_t send_request(esp_http_client_handle_t client, const char *body, int body_len)
+{
+    esp_err_t err = api_session_open(client, body_len);
+    if (err == ESP_OK && body_len > 0 && esp_http_client_write(client, body, body_len) != body_len) {
+        err = ESP_FAIL;
+    }
+    if (err == ESP_OK && esp_http_client_fetch_headers(client) < 0) {
+        err = ESP_FAIL;
+    }
+    return err;
+}
+
+esp_err_t api_session_perform_cancellable(esp_http_client_handle_t client, const volatile bool *cancel)
+{
+    api_slot_t *slot = find_slot(client);
+    char *body = NULL;
+    int body_len = esp_http_client_get_post_field(client, &body);
+
+    // A closed keep-alive connection usually still opens; it fails at the write or the headers
+    esp_err_t err = send_request(client, body, body_len);
+    if (err != ESP_OK && take_retry(slot)) {
+        err = send_request(client, body, body_len);
+    }
+
+    // The handler gets the body from this loop only, never twice through the client's events
+    http_event_handle_cb handler = slot->handler;
+    slot->handler = NULL;
+    char chunk[API_SESSION_READ_CHUNK];
+    esp_http_client_event_t evt = {
+        .event_id = HTTP_EVENT_ON_DATA,
+        .client = client,
+        .data = chunk,
+        .user_data = slot->user_data,
+    };
+    while (err == ESP_OK && !*cancel) {
+        int n = esp_http_client_read(client, chunk, sizeof(chunk));
+        if (n < 0) {
+            err = ESP_FAIL;
+        } else if (n == 0) {
+            break;
+        } else if (handler) {
+            evt.data_len = n;
+            handler(&evt);
+        }
+    }
+    slot->handler = handler;
+
+    if (*cancel) {
+        ESP_LOGI(TAG, "Request cancelled, dropping the rest of the response");
+    }
+    return err;
+}
+
+esp_err_t api_session_open(esp_http_client_handle_t client, int write_len)
+{
+    api_slot_t *slot = find_slot(client);
+
+    esp_err_t err = esp_http_client_open(client, write_len);
+    if (err != ESP_OK && take_retry(slot)) {
+        err = esp_http_client_open(client, write_len);
+    }
+    return err;
+}
+
+bool api_session_retry(esp_http_client_handle_t client)
+{
+    api_slot_t *slot = find_slot(client);
+    return slot && take_retry(slot);
+}
+
+void api_session_release(esp_http_client_handle_t client, bool keep)
+{
+    api_slot_t *slot = find_slot(client);
+    if (!slot) {
+        return;
+    }
+
+    // Unread response bytes would corrupt the next request on this connection
+    if (!keep || !esp_http_client_is_complete_data_received(client)) {
+        esp_http_client_close(client);
+        slot->connected = false;
+    }
+    slot->last_used_us = esp_timer_get_time();
+    slot->handler = NULL;
+    slot->user_data = NULL;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    slot->busy = false;
+    xSemaphoreGive(s_lock);
+    xSemaphoreGive(s_free);
+}
+
+esp_err_t api_session_prewarm(void)
+{
+    int64_t start_us = esp_timer_get_time();
+
+    esp_http_client_handle_t client = api_session_acquire(HTTP_METHOD_GET, API_PREWARM_PATH, 10000, NULL, NULL);
+    if (!client) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    esp_err_t err = api_session_perform(client);
+    int status = esp_http_client_get_status_code(client);
+    api_session_release(client, err == ESP_OK);
+
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Pre-warmed api.openai.com in %lld ms (status %d)",
+                 (esp_timer_get_time() - start_us) / 1000, status);
+    } else {
+        ESP_LOGW(TAG, "Pre-warm failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
@@ -0,0 +1,90 @@
+/**
+ * Persistent HTTPS sessions to api.openai.com
+ * Keep-alive connection pool shared by the Whisper, Chat and TTS calls
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_http_client.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the pooled HTTP clients (no network traffic)
+ *
+ * @return
+ *      - ESP_OK: Pool created
+ *      - ESP_ERR_NO_MEM: Clients could not be allocated
+ */
+esp_err_t api_session_init(void);
+
+/**
+ * @brief Open a connection with a cheap request so the first real call
+ *        does not pay for the TLS handshake (call once Wi-Fi is up)
+ */
+esp_err_t api_session_prewarm(void);
+
+/**
+ * @brief Take a pooled client for one request, blocking until one is free
+ *
+ * The client is reset for the request: URL, method, timeout and event
+ * handler are set, any body and framing headers from the previous request
+ * are cleared. The Authorization header is already present.
+ *
+ * @param[in] method     HTTP method
+ * @param[in] path       Path on api.openai.com, e.g. "/v1/audio/speech"
+ * @param[in] timeout_ms Network timeout for this request
+ * @param[in] handler    Event handler for this request (may be NULL)
+ * @param[in] user_data  Passed to the handler as evt->user_data
+ * @return Client handle, or NULL if the pool is not initialized
+ */
+esp_http_client_handle_t api_session_acquire(esp_http_client_method_t method, const char *path, int timeout_ms,
+                                             http_event_handle_cb handler, void *user_data);
+
+/**
+ * @brief esp_http_client_perform() that retries once if a kept-alive
+ *        connection turned out to be closed by the server
+ */
+esp_err_t api_session_perform(esp_http_client_handle_t client);
+
+/**
+ * @brief api_session_perform() that stops reading the response once *cancel is set
+ *
+ * The body is read in this call instead of by esp_http_client_perform(),
+ * and handed to the request's handler as HTTP_EVENT_ON_DATA events. A
+ * cancelled request still returns ESP_OK; its unread response makes
+ * api_session_release() drop the connection.
+ */
+esp_err_t api_session_perform_cancellable(esp_http_client_handle_t client, const volatile bool *cancel);
+
+/**
+ * @brief esp_http_client_open() that reconnects once if a kept-alive
+ *        connection turned out to be closed by the server
+ */
+esp_err_t api_session_open(esp_http_client_handle_t client, int write_len);
+
+/**
+ * @brief After a failed write or fetch_headers of an api_session_open() request:
+ *        whether to send it again from the open
+ *
+ * True at most once per request, and only if it went out on a kept-alive
+ * connection and no response arrived - the server had closed it while
+ * idle. The connection is dropped, so the next open reconnects.
+ */
+bool api_session_retry(esp_http_client_handle_t client);
+
+/**
+ * @brief Return a client to the pool
+ *
+ * The connection is kept open for the next request unless keep is false
+ * or the response was not fully consumed.
+ */
+void api_session_release(esp_http_client_handle_t client, bool keep);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,145 @@
+/**
+ * Boot-time audio arena
+ *
+ * Every turn used to malloc the recording, the response text and the
+ * request bodies and free them again. These are the largest allocations
+ * the firmware makes, and after a few hours the heap was too fragmented
+ * for them even with plenty of free memory in total. Each buffer now has a
+ * slab reserved at boot: ring owners keep their slab for good, and per-turn
+ * users bump-allocate from theirs and reset it when the next turn starts.
+ */
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "audio_arena.h"
+#include "mem_policy.h"
+
+static const char *TAG = "audio_arena";
+
+#define ARENA_ALIGN 4
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t used;        // Bump offset (per-turn slabs) or last reported fill (rings)
+    size_t high_water;
+    uint32_t failures;  // Allocations refused since boot
+} slab_t;
+
+static const char *const slab_names[AUDIO_SLAB_COUNT] = {
+    [AUDIO_SLAB_CAPTURE]  = "capture",
+    [AUDIO_SLAB_UPLOAD]   = "upload",
+    [AUDIO_SLAB_TEXT]     = "text",
+    [AUDIO_SLAB_PLAYBACK] = "playback",
+};
+
+// Placement of each slab: only the playback ring is on a real-time path (the
+// I2S feeder drains it every few ms), everything else is streamed through
+static const mem_class_t slab_class[AUDIO_SLAB_COUNT] = {
+    [AUDIO_SLAB_CAPTURE]  = MEM_BULK,
+    [AUDIO_SLAB_UPLOAD]   = MEM_BULK,
+    [AUDIO_SLAB_TEXT]     = MEM_BULK,
+    [AUDIO_SLAB_PLAYBACK] = MEM_INTERNAL,
+};
+
+static slab_t s_slabs[AUDIO_SLAB_COUNT];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_ready = false;
+
+esp_err_t audio_arena_init(const size_t sizes[AUDIO_SLAB_COUNT])
+{
+    if (s_ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t total = 0;
+    size_t psram = 0;
+    for (int i = 0; i < AUDIO_SLAB_COUNT; i++) {
+        slab_t *slab = &s_slabs[i];
+        slab->size = sizes[i];
+        if (slab->size == 0) {
+            continue;
+        }
+        slab->base = mem_policy_alloc(slab_class[i], slab->size);
+        if (!slab->base) {
+            ESP_LOGE(TAG, "Failed to allocate %d byte %s slab", slab->size, slab_names[i]);
+            return ESP_ERR_NO_MEM;
+        }
+        if (mem_policy_is_psram(slab->base)) {
+            psram += slab->size;
+        }
+        total += slab->size;
+    }
+
+    s_ready = true;
+    ESP_LOGI(TAG, "Arena: %d bytes in %d slabs (%d in PSRAM)", total, AUDIO_SLAB_COUNT, psram);
+    return ESP_OK;
+}
+
+void *audio_arena_slab(audio_slab_t slab, size_t *size)
+{
+    if (size) {
+        *size = s_slabs[slab].size;
+    }
+    return s_slabs[slab].base;
+}
+
+void *audio_arena_alloc(audio_slab_t slab, size_t size)
+{
+    slab_t *s = &s_slabs[slab];
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    void *p = NULL;
+
+    taskENTER_CRITICAL(&s_lock);
+    if (s->base && aligned <= s->size - s->used) {
+        p = s->base + s->used;
+        s->used += aligned;
+        if (s->used > s->high_water) {
+            s->high_water = s->used;
+        }
+    } else {
+        s->failures++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    if (!p) {
+        ESP_LOGE(TAG, "%s slab exhausted: %d bytes requested, %d of %d in use",
+                 slab_names[slab], size, s->used, s->size);
+    }
+    return p;
+}
+
+void audio_arena_reset(audio_slab_t slab)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_slabs[slab].used = 0;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void audio_arena_note(audio_slab_t slab, size_t used)
+{
+    slab_t *s = &s_slabs[slab];
+    s->used = used;
+    if (used > s->high_water) {
+        s->high_water = used;
+    }
+}
+
+size_t audio_arena_high_water(audio_slab_t slab)
+{
+    return s_slabs[slab].high_water;
+}
+
+void audio_arena_log_stats(void)
+{
+    for (int i = 0; i < AUDIO_SLAB_COUNT; i++) {
+        const slab_t *s = &s_slabs[i];
+        if (!s->base) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-8s %6d / %6d bytes high-water (%d%%)%s", slab_names[i], s->high_water, s->size,
+                 (int)(s->high_water * 100 / s->size), s->failures ? " - allocations refused!" : "");
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * Boot-time audio arena
+ * Fixed-purpose slabs allocated once, so a turn never touches the heap
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    AUDIO_SLAB_CAPTURE = 0, /*!< Capture ring (pipelined) or whole recording (buffered) - single owner */
+    AUDIO_SLAB_UPLOAD,      /*!< Request bodies - per-turn allocations */
+    AUDIO_SLAB_TEXT,        /*!< Transcription and reply text - per-turn allocations */
+    AUDIO_SLAB_PLAYBACK,    /*!< Playback ring - single owner */
+    AUDIO_SLAB_COUNT,
+} audio_slab_t;
+
+/**
+ * @brief Allocate every slab (call once at boot, before the heap fragments)
+ *
+ * @param[in] sizes Bytes per slab, indexed by audio_slab_t; 0 leaves a slab unused
+ * @return
+ *      - ESP_OK: Arena ready
+ *      - ESP_ERR_INVALID_STATE: Already initialized
+ *      - ESP_ERR_NO_MEM: A slab could not be allocated
+ */
+esp_err_t audio_arena_init(const size_t sizes[AUDIO_SLAB_COUNT]);
+
+/**
+ * @brief Whole slab for a single long-lived owner (ring buffers)
+ *
+ * @param[out] size Slab size in bytes (may be NULL)
+ * @return Slab memory, or NULL if the slab is unused
+ */
+void *audio_arena_slab(audio_slab_t slab, size_t *size);
+
+/**
+ * @brief Carve size bytes off a per-turn slab (thread-safe, 4-byte aligned)
+ *
+ * Memory stays valid until the next audio_arena_reset() of the slab.
+ *
+ * @return Memory, or NULL if the slab is exhausted (never falls back to the heap)
+ */
+void *audio_arena_alloc(audio_slab_t slab, size_t size);
+
+/**
+ * @brief Release every allocation of a per-turn slab (start of a turn)
+ */
+void audio_arena_reset(audio_slab_t slab);
+
+/**
+ * @brief Report the fill level of a ring owned through audio_arena_slab()
+ */
+void audio_arena_note(audio_slab_t slab, size_t used);
+
+/**
+ * @brief Most bytes in use at once since boot
+ */
+size_t audio_arena_high_water(audio_slab_t slab);
+
+/**
+ * @brief Log size and high-water mark of every slab
+ */
+void audio_arena_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
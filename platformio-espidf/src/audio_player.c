@@ -0,0 +1,242 @@
+/**
+ * Streaming audio playback
+ * The HTTP event handler pushes mono PCM16 into a stream buffer, the
+ * playback task drains it into the I2S speaker channel.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "audio_player.h"
+#include "audio_arena.h"
+#include "vc_echo_gate.h"
+#include "vc_pcm.h"
+#include "turn_trace.h"
+
+static const char *TAG = "audio_player";
+
+#define AUDIO_PLAYER_PREROLL_MS     150          // Jitter buffer before the first I2S write
+#define AUDIO_PLAYER_CHUNK_SAMPLES  256          // Mono samples per I2S write
+#define AUDIO_PLAYER_POLL_MS        10
+#define AUDIO_PLAYER_TAIL_CHUNKS    6            // Silence pushed after the stream to flush DMA
+
+static StreamBufferHandle_t s_ring = NULL;
+static StaticStreamBuffer_t s_ring_struct;
+static size_t s_ring_size = 0;
+static SemaphoreHandle_t s_done = NULL;
+static TaskHandle_t s_task = NULL;
+static i2s_chan_handle_t s_chan = NULL;
+static size_t s_preroll_bytes = 0;
+static volatile bool s_active = false;
+static volatile bool s_eos = false;
+static volatile bool s_stop = false;     // Barge-in: discard instead of play
+
+// Stereo staging for one chunk - the only copy of the audio besides the ring
+static uint32_t s_frames[AUDIO_PLAYER_CHUNK_SAMPLES];
+
+// Per-stream statistics
+static int64_t s_begin_us = 0;
+static size_t s_played_bytes = 0;
+static uint32_t s_underruns = 0;
+
+// Envelope of what reached the speaker, for the echo gate on the mic side
+static volatile uint16_t s_level = 0;
+static volatile int64_t s_level_us = 0;
+
+/**
+ * Write one chunk of mono samples as interleaved L/R to the speaker
+ */
+static void play_chunk(const int16_t *mono, size_t samples)
+{
+    vc_pcm_mono_to_stereo(s_frames, mono, samples);
+    size_t bytes_written;
+    i2s_channel_write(s_chan, s_frames, samples * sizeof(uint32_t), &bytes_written, portMAX_DELAY);
+}
+
+/**
+ * Playback task - waits for a stream, pre-rolls, then drains the ring into I2S
+ */
+static void playback_task(void *arg)
+{
+    int16_t mono[AUDIO_PLAYER_CHUNK_SAMPLES];
+    uint8_t *mono_bytes = (uint8_t *)mono;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Pre-roll: absorb network jitter before the first write
+        while (!s_eos && xStreamBufferBytesAvailable(s_ring) < s_preroll_bytes) {
+            vTaskDelay(pdMS_TO_TICKS(AUDIO_PLAYER_POLL_MS));
+        }
+
+        bool started = false;
+        bool starved = false;
+        size_t carry = 0;  // Odd byte left over from the previous receive
+
+        while (1) {
+            size_t got = xStreamBufferReceive(s_ring, mono_bytes + carry, sizeof(mono) - carry,
+                                              pdMS_TO_TICKS(AUDIO_PLAYER_POLL_MS));
+            if (got == 0) {
+                if (s_eos && xStreamBufferIsEmpty(s_ring)) {
+                    break;
+                }
+                if (started && !starved) {
+                    s_underruns++;
+                    starved = true;
+                }
+                continue;
+            }
+            starved = false;
+
+            size_t total = carry + got;
+            size_t samples = total / sizeof(int16_t);
+            carry = total & 1;
+
+            if (s_stop) {
+                continue;  // Drain without playing, so blocked writers return
+            }
+
+            if (!started) {
+                started = true;
+                ESP_LOGI(TAG, "First audio after %lld ms", (esp_timer_get_time() - s_begin_us) / 1000);
+                turn_trace_mark(TRACE_FIRST_SAMPLE);
+            }
+            play_chunk(mono, samples);
+            s_played_bytes += samples * sizeof(int16_t);
+
+            // Peak-hold with a slow decay (~1 dB per chunk)
+            uint16_t level = vc_echo_gate_level(mono, samples);
+            s_level = level > s_level ? level : s_level - (s_level >> 3);
+            s_level_us = esp_timer_get_time();
+
+            if (carry) {
+                mono_bytes[0] = mono_bytes[total - 1];
+            }
+        }
+
+        // Push silence so the last real samples leave the DMA before the channel is torn down
+        if (started) {
+            memset(mono, 0, sizeof(mono));
+            for (int i = 0; i < AUDIO_PLAYER_TAIL_CHUNKS; i++) {
+                play_chunk(mono, AUDIO_PLAYER_CHUNK_SAMPLES);
+            }
+        }
+
+        s_active = false;
+        xSemaphoreGive(s_done);
+    }
+}
+
+esp_err_t audio_player_init(uint32_t sample_rate)
+{
+    if (s_ring) {
+        return ESP_OK;
+    }
+
+    s_preroll_bytes = (sample_rate * AUDIO_PLAYER_PREROLL_MS / 1000) * sizeof(int16_t);
+
+    // Ring storage is the arena's playback slab (one byte is the stream buffer's spare)
+    size_t slab_size;
+    uint8_t *storage = audio_arena_slab(AUDIO_SLAB_PLAYBACK, &slab_size);
+    if (!storage || slab_size <= s_preroll_bytes) {
+        ESP_LOGE(TAG, "No usable playback slab (%d bytes)", slab_size);
+        return ESP_ERR_NO_MEM;
+    }
+    s_ring_size = slab_size - 1;
+    s_ring = xStreamBufferCreateStatic(s_ring_size, 1, storage, &s_ring_struct);
+    s_done = xSemaphoreCreateBinary();
+    if (!s_ring || !s_done) {
+        ESP_LOGE(TAG, "Failed to create playback ring");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Core 1 with the capture task, away from Wi-Fi and TLS on core 0
+    if (xTaskCreatePinnedToCore(playback_task, "playback_task", 4096, NULL, 12, &s_task, 1) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create playback task");
+        return ESP_ERR_NO_MEM;
+    }
+    turn_trace_watch_task(s_task);
+
+    ESP_LOGI(TAG, "Playback ring: %d bytes, pre-roll: %d bytes", s_ring_size, s_preroll_bytes);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_begin(i2s_chan_handle_t chan)
+{
+    if (!s_ring || !chan || s_active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Playback task is parked on its notification, so the ring can be reset safely
+    xStreamBufferReset(s_ring);
+    xSemaphoreTake(s_done, 0);
+
+    s_chan = chan;
+    s_eos = false;
+    s_stop = false;
+    s_active = true;
+    s_begin_us = esp_timer_get_time();
+    s_played_bytes = 0;
+    s_underruns = 0;
+
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+size_t audio_player_write(const void *data, size_t len, TickType_t timeout)
+{
+    if (!s_active || s_eos) {
+        return 0;
+    }
+
+    const uint8_t *src = (const uint8_t *)data;
+    size_t sent = 0;
+    while (sent < len && !s_stop) {
+        size_t n = xStreamBufferSend(s_ring, src + sent, len - sent, timeout);
+        if (n == 0) {
+            ESP_LOGW(TAG, "Playback ring full, dropped %d bytes", len - sent);
+            break;
+        }
+        sent += n;
+    }
+    audio_arena_note(AUDIO_SLAB_PLAYBACK, xStreamBufferBytesAvailable(s_ring));
+    return sent;
+}
+
+esp_err_t audio_player_end(TickType_t timeout)
+{
+    if (!s_active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_eos = true;
+    if (xSemaphoreTake(s_done, timeout) != pdTRUE) {
+        ESP_LOGE(TAG, "Playback did not drain in time");
+        return ESP_ERR_TIMEOUT;
+    }
+    turn_trace_mark(TRACE_PLAYBACK_END);
+
+    ESP_LOGI(TAG, "Played %d samples (%d underruns)%s", s_played_bytes / sizeof(int16_t), s_underruns,
+             s_stop ? ", stopped early" : "");
+    return ESP_OK;
+}
+
+void audio_player_stop(void)
+{
+    if (s_active) {
+        s_stop = true;
+        s_eos = true;
+    }
+}
+
+uint16_t audio_player_recent_level(uint32_t within_ms)
+{
+    if (s_level_us == 0 || esp_timer_get_time() - s_level_us > within_ms * 1000LL) {
+        return 0;
+    }
+    return s_level;
+}
@@ -0,0 +1,84 @@
+/**
+ * Streaming audio playback
+ * Ring buffer between a network producer and a dedicated I2S playback task
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "driver/i2s_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the playback ring buffer and playback task (call once at boot)
+ *
+ * The ring lives in the arena's playback slab, so audio_arena_init() must run first.
+ *
+ * @param[in] sample_rate Sample rate of the mono PCM16 stream, used for pre-roll sizing
+ * @return
+ *      - ESP_OK: Player created
+ *      - ESP_ERR_NO_MEM: No playback slab, or the task could not be allocated
+ */
+esp_err_t audio_player_init(uint32_t sample_rate);
+
+/**
+ * @brief Start a new playback stream
+ *
+ * Playback begins as soon as the pre-roll threshold is buffered (or the
+ * stream is ended early), so time-to-first-audio depends on network RTT
+ * rather than on the length of the reply.
+ *
+ * @param[in] chan Enabled I2S TX channel (stereo, 16-bit)
+ * @return
+ *      - ESP_OK: Stream started
+ *      - ESP_ERR_INVALID_STATE: Player not initialized or a stream is already active
+ */
+esp_err_t audio_player_begin(i2s_chan_handle_t chan);
+
+/**
+ * @brief Queue mono PCM16 bytes for playback
+ *
+ * Blocks while the ring buffer is full, which back-pressures the producer.
+ * Odd byte counts are fine; samples are re-aligned by the playback task.
+ *
+ * @return Number of bytes accepted (less than len only on timeout)
+ */
+size_t audio_player_write(const void *data, size_t len, TickType_t timeout);
+
+/**
+ * @brief Mark the end of the stream and wait until all queued audio has played
+ *
+ * @return
+ *      - ESP_OK: Stream drained
+ *      - ESP_ERR_INVALID_STATE: No stream active
+ *      - ESP_ERR_TIMEOUT: Playback did not finish in time
+ */
+esp_err_t audio_player_end(TickType_t timeout);
+
+/**
+ * @brief Cut the stream short (barge-in), safe from any task or timer callback
+ *
+ * Queued audio is discarded instead of played and further writes are
+ * refused; a writer blocked on a full ring returns promptly. The owner
+ * still closes the stream with audio_player_end(), which then returns as
+ * soon as the ring is drained.
+ */
+void audio_player_stop(void);
+
+/**
+ * @brief Level of the audio played last (mean absolute sample, slowly decaying peak)
+ *
+ * @param[in] within_ms Only count playback that ended at most this long ago
+ * @return Level, or 0 if nothing was played within the window
+ */
+uint16_t audio_player_recent_level(uint32_t within_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+/**
+ * Push button
+ *
+ * The first edge after a quiet period is reported straight from the GPIO
+ * ISR, so a press reaches the turn logic within microseconds instead of on
+ * the next 10 ms poll plus a 50 ms blocking debounce. The ISR then masks
+ * the pin's interrupt and an esp_timer one-shot re-enables it after
+ * debounce_ms, reporting the settled level if it ended up different (a
+ * release inside the window, or a glitch).
+ *
+ * GPIO 36/39 on the ESP32 see ~80 ns false low pulses when some RTC
+ * peripherals power up (Wi-Fi modem sleep among them, errata 3.11). By the
+ * time the ISR reads the pin such a pulse is over, so an edge whose level
+ * matches the current state is ignored.
+ */
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "button.h"
+
+static const char *TAG = "button";
+
+static button_config_t s_config;
+static esp_timer_handle_t s_settle_timer = NULL;
+static volatile bool s_pressed = false;
+static volatile int64_t s_change_us = 0;
+
+static bool read_pressed(void)
+{
+    return gpio_get_level(s_config.pin) == (s_config.active_low ? 0 : 1);
+}
+
+static void edge_isr(void *arg)
+{
+    bool pressed = read_pressed();
+    if (pressed == s_pressed) {
+        return;     // Bounce back to the current state, or a false pulse
+    }
+    s_pressed = pressed;
+    s_change_us = esp_timer_get_time();
+
+    // Lock out the bounces, the timer looks again once they are over
+    gpio_intr_disable(s_config.pin);
+    esp_timer_start_once(s_settle_timer, (uint64_t)s_config.debounce_ms * 1000);
+
+    BaseType_t woken = pdFALSE;
+    s_config.on_change(pressed, &woken, s_config.arg);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void settle_timer_cb(void *arg)
+{
+    bool pressed = read_pressed();
+    if (pressed != s_pressed) {
+        // Changed again inside the window (a short tap, or the edge was noise)
+        s_pressed = pressed;
+        s_change_us = esp_timer_get_time();
+        s_config.on_change(pressed, NULL, s_config.arg);
+    }
+    gpio_intr_enable(s_config.pin);
+}
+
+esp_err_t button_init(const button_config_t *config)
+{
+    if (s_settle_timer || !config->on_change) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_config = *config;
+
+    const esp_timer_create_args_t settle_args = {
+        .callback = settle_timer_cb,
+        .name = "button",
+    };
+    esp_err_t err = esp_timer_create(&settle_args, &s_settle_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << config->pin),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    err = gpio_config(&io_conf);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_pressed = read_pressed();
+
+    // Shared per-pin dispatch; another module may have installed it already
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+    err = gpio_isr_handler_add(config->pin, edge_isr, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Button on GPIO %d, %lu ms debounce%s", config->pin, (unsigned long)config->debounce_ms,
+             s_pressed ? " (held at boot)" : "");
+    return ESP_OK;
+}
+
+bool button_is_pressed(void)
+{
+    return s_pressed;
+}
+
+int64_t button_last_change_us(void)
+{
+    return s_change_us;
+}
@@ -0,0 +1,60 @@
+/**
+ * Push button
+ * Edge interrupt with timer debounce: a press or release is reported from
+ * the GPIO ISR on its first edge, not after a polling interval
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Button state change
+ *
+ * Runs in the GPIO ISR (woken is non-NULL: use the FromISR APIs and set
+ * *woken if a task was woken) or in the esp_timer task when a change only
+ * shows once the contact has settled (woken is NULL). Keep it short.
+ */
+typedef void (*button_cb_t)(bool pressed, BaseType_t *woken, void *arg);
+
+typedef struct {
+    gpio_num_t pin;
+    bool active_low;            /*!< Pressed reads 0 */
+    uint32_t debounce_ms;       /*!< Edges ignored for this long after a reported change */
+    button_cb_t on_change;
+    void *arg;
+} button_config_t;
+
+/**
+ * @brief Configure the pin as an input with an any-edge interrupt
+ *
+ * Pull-ups are left disabled (GPIO 34-39 have none; the ATOM Echo's
+ * button has an external one).
+ *
+ * @return
+ *      - ESP_OK: Button armed
+ *      - Others: GPIO, ISR service or timer setup failed
+ */
+esp_err_t button_init(const button_config_t *config);
+
+/**
+ * @brief Debounced state
+ */
+bool button_is_pressed(void);
+
+/**
+ * @brief esp_timer time of the last reported change, in us
+ */
+int64_t button_last_change_us(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,179 @@
+/**
+ * Shared-pin I2S microphone / speaker switching
+ *
+ * On the ATOM Echo GPIO 33 is both the PDM mic clock (I2S0) and the speaker
+ * word select (I2S1). Rebuilding a channel means freeing and reallocating
+ * its DMA buffers and reprogramming the clock tree, which took tens of ms
+ * per push-to-talk transition. Here both channels are configured once and
+ * stay allocated; a switch only stops one, reconnects the pad to the other
+ * peripheral's clock signal and starts the other.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_gpio.h"
+#include "soc/soc_caps.h"
+#include "soc/i2s_periph.h"
+#include "driver/i2s_std.h"
+#include "driver/i2s_pdm.h"
+#include "i2s_bus.h"
+
+static const char *TAG = "i2s_bus";
+
+#define MIC_PORT I2S_NUM_0  // PDM RX is only available on I2S0
+#define SPK_PORT I2S_NUM_1
+
+// Matrix signal each peripheral drives on the shared pin
+#if SOC_I2S_HW_VERSION_2
+#define MIC_CLK_SIG i2s_periph_signal[MIC_PORT].m_tx_ws_sig
+#else
+#define MIC_CLK_SIG i2s_periph_signal[MIC_PORT].m_rx_ws_sig  // ESP32 outputs the PDM RX clock on WS
+#endif
+#define SPK_WS_SIG  i2s_periph_signal[SPK_PORT].m_tx_ws_sig
+
+static i2s_chan_handle_t s_mic = NULL;
+static i2s_chan_handle_t s_spk = NULL;
+static i2s_bus_mode_t s_mode = I2S_BUS_IDLE;
+static int s_shared_pin = -1;
+
+static const char *mode_name(i2s_bus_mode_t mode)
+{
+    switch (mode) {
+        case I2S_BUS_MIC:     return "mic";
+        case I2S_BUS_SPEAKER: return "speaker";
+        default:              return "idle";
+    }
+}
+
+static esp_err_t init_mic(const i2s_bus_config_t *config)
+{
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(MIC_PORT, I2S_ROLE_MASTER);
+    esp_err_t err = i2s_new_channel(&chan_cfg, NULL, &s_mic);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    i2s_pdm_rx_config_t pdm_rx_cfg = {
+        .clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(config->mic_rate),
+        .slot_cfg = I2S_PDM_RX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .clk = config->mic_clk,
+            .din = config->mic_data,
+            .invert_flags = {
+                .clk_inv = false,
+            },
+        },
+    };
+    return i2s_channel_init_pdm_rx_mode(s_mic, &pdm_rx_cfg);
+}
+
+static esp_err_t init_speaker(const i2s_bus_config_t *config)
+{
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(SPK_PORT, I2S_ROLE_MASTER);
+    chan_cfg.auto_clear = true;  // Output silence instead of stale DMA data on stream underrun
+    esp_err_t err = i2s_new_channel(&chan_cfg, &s_spk, NULL);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Slots stay stereo; audio_player expands mono per chunk so no full stereo copy exists
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(config->spk_rate),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = config->spk_bck,
+            .ws = config->spk_ws,
+            .dout = config->spk_data,
+            .din = I2S_GPIO_UNUSED,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+    return i2s_channel_init_std_mode(s_spk, &std_cfg);
+}
+
+esp_err_t i2s_bus_init(const i2s_bus_config_t *config)
+{
+    if (s_mic || s_spk) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Each init routes its pins; the shared pin ends up on the speaker until the first switch
+    esp_err_t err = init_mic(config);
+    if (err == ESP_OK) {
+        err = init_speaker(config);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure I2S channels: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    s_shared_pin = config->mic_clk == config->spk_ws ? config->mic_clk : -1;
+    s_mode = I2S_BUS_IDLE;
+
+    ESP_LOGI(TAG, "Mic (I2S%d) and speaker (I2S%d) configured, shared pin: %d",
+             MIC_PORT, SPK_PORT, s_shared_pin);
+    return ESP_OK;
+}
+
+esp_err_t i2s_bus_select(i2s_bus_mode_t mode)
+{
+    if (!s_mic || !s_spk) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (mode == s_mode) {
+        return ESP_OK;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    i2s_bus_mode_t from = s_mode;
+
+    // Waits for an in-flight read/write, so the other side never sees a half-switched bus
+    if (s_mode == I2S_BUS_MIC) {
+        i2s_channel_disable(s_mic);
+    } else if (s_mode == I2S_BUS_SPEAKER) {
+        i2s_channel_disable(s_spk);
+    }
+    s_mode = I2S_BUS_IDLE;
+
+    if (mode == I2S_BUS_IDLE) {
+        ESP_LOGI(TAG, "%s -> idle in %lld us", mode_name(from), esp_timer_get_time() - start_us);
+        return ESP_OK;
+    }
+
+    // Only the pad's source changes, the channel configurations are untouched
+    if (s_shared_pin >= 0) {
+        esp_rom_gpio_connect_out_signal(s_shared_pin, mode == I2S_BUS_MIC ? MIC_CLK_SIG : SPK_WS_SIG,
+                                        false, false);
+    }
+
+    esp_err_t err = i2s_channel_enable(mode == I2S_BUS_MIC ? s_mic : s_spk);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start %s: %s", mode_name(mode), esp_err_to_name(err));
+        return err;
+    }
+    s_mode = mode;
+
+    ESP_LOGI(TAG, "%s -> %s in %lld us", mode_name(from), mode_name(mode), esp_timer_get_time() - start_us);
+    return ESP_OK;
+}
+
+i2s_bus_mode_t i2s_bus_mode(void)
+{
+    return s_mode;
+}
+
+i2s_chan_handle_t i2s_bus_mic(void)
+{
+    return s_mic;
+}
+
+i2s_chan_handle_t i2s_bus_speaker(void)
+{
+    return s_spk;
+}
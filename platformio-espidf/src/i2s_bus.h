@@ -0,0 +1,74 @@
+/**
+ * Shared-pin I2S microphone / speaker switching
+ * Both channels are created once; a switch moves the shared clock pin
+ * between them in the GPIO matrix instead of deleting and recreating them
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/i2s_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    I2S_BUS_IDLE = 0,   /*!< Both channels stopped */
+    I2S_BUS_MIC,        /*!< PDM microphone running, speaker stopped */
+    I2S_BUS_SPEAKER,    /*!< Speaker running, microphone stopped */
+} i2s_bus_mode_t;
+
+typedef struct {
+    uint32_t mic_rate;  /*!< PDM microphone sample rate (PDM clock is 64x this) */
+    uint32_t spk_rate;  /*!< Speaker sample rate */
+    int mic_clk;        /*!< PDM clock out (I2S0) */
+    int mic_data;       /*!< PDM data in */
+    int spk_bck;        /*!< Speaker bit clock (I2S1) */
+    int spk_ws;         /*!< Speaker word select, may be the same pin as mic_clk */
+    int spk_data;       /*!< Speaker data out */
+} i2s_bus_config_t;
+
+/**
+ * @brief Create and configure both channels, leaving the bus in I2S_BUS_IDLE
+ *
+ * @return
+ *      - ESP_OK: Channels ready
+ *      - ESP_ERR_INVALID_STATE: Already initialized
+ *      - Others: I2S driver errors
+ */
+esp_err_t i2s_bus_init(const i2s_bus_config_t *config);
+
+/**
+ * @brief Hand the bus to the microphone or the speaker
+ *
+ * Stops the active channel, routes the shared pin to the other peripheral
+ * and starts it. Blocks until an in-flight read or write on the stopped
+ * channel returns. The switch time is logged.
+ *
+ * @return
+ *      - ESP_OK: Switched (or already in that mode)
+ *      - ESP_ERR_INVALID_STATE: Not initialized
+ *      - Others: I2S driver errors
+ */
+esp_err_t i2s_bus_select(i2s_bus_mode_t mode);
+
+/**
+ * @brief Current mode
+ */
+i2s_bus_mode_t i2s_bus_mode(void);
+
+/**
+ * @brief PDM RX channel (valid for the lifetime of the program after init)
+ */
+i2s_chan_handle_t i2s_bus_mic(void);
+
+/**
+ * @brief Standard TX channel, stereo 16-bit (valid for the lifetime of the program after init)
+ */
+i2s_chan_handle_t i2s_bus_speaker(void);
+
+#ifdef __cplusplus
+}
+#endif
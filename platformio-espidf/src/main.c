@@ -13,20 +13,32 @@
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/event_groups.h"
+#include "freertos/queue.h"
 #include "esp_system.h"
-#include "esp_wifi.h"
-#include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "driver/gpio.h"
-#include "driver/i2s_std.h"
-#include "driver/i2s_pdm.h"
-#include "driver/rmt_tx.h"
 #include "esp_http_client.h"
-#include "esp_crt_bundle.h"
-#include "cJSON.h"
-#include "led_strip_encoder.h"
+#include "status_led.h"
+#include "audio_player.h"
+#include "audio_arena.h"
+#include "mem_policy.h"
+#include "i2s_bus.h"
+#include "whisper_client.h"
+#include "api_session.h"
+#include "realtime_client.h"
+#include "prompt_store.h"
+#include "turn_trace.h"
+#include "wifi_link.h"
+#include "button.h"
+#include "wake_word.h"
+#include "vc_json_extract.h"
+#include "vc_chat_stream.h"
+#include "vc_vad.h"
+#include "vc_resample.h"
+#include "vc_echo_gate.h"
+#include "vc_bench.h"
 #include "../credentials.h"
 
 static const char *TAG = "ATOM_ECHO";
@@ -41,183 +53,214 @@ static const char *TAG = "ATOM_ECHO";
 #define I2S_SPK_DATA    22
 
 // Audio configuration
-#define SAMPLE_RATE     24000
+#define MIC_SAMPLE_RATE      24000      // PDM clock 1.536 MHz, mid-range for the SPM1423
+#define PLAYBACK_SAMPLE_RATE 24000      // TTS and Realtime audio are 24kHz PCM16
 #define MIC_BUFFER_SIZE 1024
 #define SPK_BUFFER_SIZE 2048
 
 // Voice assistant configuration
-#define MAX_RECORDING_DURATION_MS 2000   // 2 seconds max recording (96KB at 24kHz)
+#define USE_REALTIME_API 0               // 1 = single Realtime WebSocket, 0 = Whisper -> Chat -> TTS over REST
+#define MAX_RECORDING_DURATION_MS 4000   // 4 seconds max recording (128KB at 16kHz)
+#define PIPELINED_UPLOAD 1               // Upload to Whisper while recording (0 = buffer then upload)
+#define MAX_STREAMED_RECORDING_MS 30000  // Safety cap for streamed recordings (no RAM ceiling)
 #define AUDIO_CHUNK_SIZE 1024            // Samples per chunk for streaming
-#define HTTP_RESPONSE_BUFFER_SIZE 16384  // 16KB buffer for API responses
+#define CHAT_MAX_RESPONSE 2048           // Longest reply kept (150 tokens), from the text slab
+#define STREAMING_CHAT 1                 // Speak each sentence while the rest of the reply is generated
+#define SENTENCE_QUEUE_LEN 8             // Sentences buffered between the Chat stream and TTS
+#define VAD_TRIM 1                       // Upload speech only: silence before, after and in long pauses is dropped
+#define VAD_AUTO_STOP 1                  // End the turn when speech stops, even with the button still held
+#define HANDS_FREE 0                     // Start turns on speech instead of the button (trims and auto-stops)
+#define WAKE_WORD 0                      // HANDS_FREE turns start on an enrolled wake word, not on any speech
+#define WAKE_WORD_MARGIN_Q8 384          // Match threshold, 1.5x how much the enrolled takes differ
+#define WAKE_COMMAND_MS 4000             // After the wake word, the turn is dropped if no speech starts
+#define VAD_PREROLL_CHUNKS 4             // Chunks kept from before the onset (4 x 1024 samples = 170ms)
+#define USE_VAD (!USE_REALTIME_API && (VAD_TRIM || VAD_AUTO_STOP || HANDS_FREE))  // Realtime uses server VAD
+#define BARGE_IN 1                       // A button press during a reply cuts it off and starts the next turn
+#define BUTTON_DEBOUNCE_MS 20            // Edges ignored after a press or release
+#define ECHO_TAIL_MS 250                 // Speaker echo still fading when the mic takes over GPIO 33
+#define ECHO_COUPLING_Q8 256             // Echo level per unit of playback level (Q8)
+#define METRICS_PORT 80                  // GET /metrics for the fleet scraper (0 = off, serial only)
+#define AUDIO_CORE 1                     // Capture and playback tasks
+#define NET_CORE 0                       // Turn, upload and chat tasks, next to Wi-Fi, lwIP and TLS
+#define RUN_BENCHMARKS 0                 // Time the voice_core hot paths at boot (cycle counter), before Wi-Fi
+
+#if USE_REALTIME_API
+#define UPLOAD_SAMPLE_RATE 24000         // The Realtime API only takes 24kHz PCM16
+#else
+#define UPLOAD_SAMPLE_RATE 16000         // Whisper works at 16kHz anyway, a third fewer bytes than 24kHz
+#endif
+#define UPLOAD_CHUNK_MAX (AUDIO_CHUNK_SIZE * UPLOAD_SAMPLE_RATE / MIC_SAMPLE_RATE + 2)  // One resampled chunk
+
+#if HANDS_FREE && USE_REALTIME_API
+#error "HANDS_FREE relies on the on-device VAD of the REST pipeline"
+#endif
+#if WAKE_WORD && !HANDS_FREE
+#error "WAKE_WORD gates the HANDS_FREE listener, set both"
+#endif
+
+// Audio arena - every per-turn buffer is reserved once at boot (see audio_arena.h)
+#if USE_REALTIME_API
+#define ARENA_CAPTURE_SIZE 0                     // Mic frames go straight to the WebSocket
+#define ARENA_UPLOAD_SIZE 0                      // Append frames are built in place
+#define ARENA_TEXT_SIZE (64 * 1024)              // Server message reassembly
+#elif PIPELINED_UPLOAD
+#define ARENA_CAPTURE_SIZE (64 * 1024 + 1)       // Capture ring, ~2s at 16kHz, covers the TLS handshake
+#define ARENA_UPLOAD_SIZE (8 * 1024)             // Chat and TTS request bodies
+#define ARENA_TEXT_SIZE (4 * 1024)               // Transcription and reply
+#else
+#define ARENA_CAPTURE_SIZE ((UPLOAD_SAMPLE_RATE * MAX_RECORDING_DURATION_MS / 1000) * 2)  // Whole recording (needs PSRAM)
+#define ARENA_UPLOAD_SIZE (8 * 1024)
+#define ARENA_TEXT_SIZE (4 * 1024)
+#endif
+#define ARENA_PLAYBACK_SIZE (32 * 1024 + 1)      // Playback ring, ~680ms of 24kHz mono PCM16
+#define TTS_WRITE_TIMEOUT_MS 5000        // Max wait for room in the playback ring
+#define TTS_DRAIN_TIMEOUT_MS 5000        // Max wait for buffered audio to finish playing
 
 // Recording state
 static bool is_recording = false;
 static int16_t *recording_buffer = NULL;
 static size_t recording_buffer_size = 0;
 static size_t recording_position = 0;
+static size_t recording_captured = 0;  // Samples read from the mic (at MIC_SAMPLE_RATE), uploaded or not
+static vc_resampler_t capture_resampler;  // MIC_SAMPLE_RATE -> UPLOAD_SAMPLE_RATE
+static vc_echo_gate_t echo_gate;          // Drops the speaker's tail after each switch to the mic
+
+// Set when a press interrupts a reply; cancels its requests and starts the next turn
+static volatile bool barge_in_requested = false;
 
-// HTTP response buffer
-static char *http_response_buffer = NULL;
-static size_t http_response_len = 0;
+// Turn control: button edges and VAD decisions, handled in order by the turn task
+typedef enum {
+    CONTROL_PRESS,
+    CONTROL_RELEASE,
+    CONTROL_SPEECH_START,   // Speech began while listening (hands-free)
+    CONTROL_SPEECH_END,     // Speech ended or the budget ran out - finish the turn
+    CONTROL_WAKE,           // Wake word spotted while listening
+} control_event_t;
+#define CONTROL_QUEUE_LEN 8
+static QueueHandle_t control_queue = NULL;
+static TaskHandle_t recording_task_handle = NULL;  // Sleeps until a turn (or hands-free listening) starts
 
 // WiFi credentials (from credentials.h)
 #ifndef WIFI_SSID
 #error "Please create credentials.h from credentials.h.example"
 #endif
 
-// I2S handles
+// Optional fixed address from credentials.h (skips DHCP), else DHCP with the last lease restored
+#ifndef WIFI_STATIC_IP
+#define WIFI_STATIC_IP ""
+#define WIFI_GATEWAY ""
+#define WIFI_NETMASK ""
+#endif
+#ifndef WIFI_DNS
+#define WIFI_DNS NULL
+#endif
+
+// I2S handles (created once by i2s_bus, never deleted)
 static i2s_chan_handle_t mic_chan = NULL;
 static i2s_chan_handle_t spk_chan = NULL;
 
-// WiFi event group
-static EventGroupHandle_t wifi_event_group;
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
-
-// LED control
-static rmt_channel_handle_t led_chan = NULL;
-static rmt_encoder_handle_t led_encoder = NULL;
-
 // LED colors (GRB format for SK6812)
-typedef struct {
-    uint8_t g;
-    uint8_t r;
-    uint8_t b;
-} led_color_t;
-
-static const led_color_t LED_OFF     = {0x00, 0x00, 0x00};
-static const led_color_t LED_BLUE    = {0x00, 0x00, 0x20};
-static const led_color_t LED_YELLOW  = {0x20, 0x20, 0x00};
-static const led_color_t LED_GREEN   = {0x20, 0x00, 0x00};
-static const led_color_t LED_CYAN    = {0x20, 0x00, 0x20};
-static const led_color_t LED_MAGENTA = {0x00, 0x20, 0x20};
-static const led_color_t LED_RED     = {0x00, 0x20, 0x00};
+static const status_led_color_t LED_OFF     = {0x00, 0x00, 0x00};
+static const status_led_color_t LED_BLUE    = {0x00, 0x00, 0x20};
+static const status_led_color_t LED_YELLOW  = {0x20, 0x20, 0x00};
+static const status_led_color_t LED_GREEN   = {0x20, 0x00, 0x00};
+static const status_led_color_t LED_CYAN    = {0x20, 0x00, 0x20};
+static const status_led_color_t LED_MAGENTA = {0x00, 0x20, 0x20};
+static const status_led_color_t LED_RED     = {0x00, 0x20, 0x00};
 
 /**
- * Initialize SK6812 RGB LED using RMT peripheral
+ * Set a solid LED color (posted to the LED task, never waits)
  */
-static esp_err_t init_led(void)
+static void set_led(status_led_color_t color)
 {
-    ESP_LOGI(TAG, "Initializing SK6812 LED on GPIO %d", LED_PIN);
-    
-    // RMT TX channel configuration
-    rmt_tx_channel_config_t tx_chan_config = {
-        .clk_src = RMT_CLK_SRC_DEFAULT,
-        .gpio_num = LED_PIN,
-        .mem_block_symbols = 64,
-        .resolution_hz = 10000000, // 10MHz resolution, 1 tick = 0.1us
-        .trans_queue_depth = 4,
-    };
-    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_chan_config, &led_chan));
-    
-    // LED strip encoder configuration
-    led_strip_encoder_config_t encoder_config = {
-        .resolution = 10000000, // 10MHz
-    };
-    ESP_ERROR_CHECK(rmt_new_led_strip_encoder(&encoder_config, &led_encoder));
-    
-    ESP_ERROR_CHECK(rmt_enable(led_chan));
-    
-    return ESP_OK;
+    status_led_set(color, STATUS_LED_SOLID);
 }
 
 /**
- * Set LED color
+ * Wi-Fi link state, from the event loop task
  */
-static void set_led(led_color_t color)
+static void wifi_state_changed(bool connected)
 {
-    if (!led_chan || !led_encoder) {
-        return;  // LED not initialized yet
-    }
-    
-    rmt_transmit_config_t tx_config = {
-        .loop_count = 0,
-    };
-    
-    uint8_t led_data[3] = {color.g, color.r, color.b};
-    esp_err_t ret = rmt_transmit(led_chan, led_encoder, led_data, sizeof(led_data), &tx_config);
-    if (ret == ESP_OK) {
-        // Wait for transmission to complete
-        rmt_tx_wait_all_done(led_chan, 100);
+    if (!connected) {
+        ESP_LOGI(TAG, "WiFi disconnected, reconnecting...");
+        status_led_set(LED_YELLOW, STATUS_LED_BREATHE);
     }
 }
 
+#if !USE_REALTIME_API
 /**
- * WiFi event handler
+ * One-shot: open the API connection while the rest of boot carries on
  */
-static void wifi_event_handler(void* arg, esp_event_base_t event_base,
-                                int32_t event_id, void* event_data)
+static void prewarm_task(void *arg)
 {
-    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        ESP_LOGI(TAG, "WiFi disconnected, retrying...");
-        set_led(LED_YELLOW);
-        esp_wifi_connect();
-        xEventGroupClearBits(wifi_event_group, WIFI_CONNECTED_BIT);
-    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
-        ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "WiFi connected! IP: " IPSTR, IP2STR(&event->ip_info.ip));
-        xEventGroupSetBits(wifi_event_group, WIFI_CONNECTED_BIT);
-    }
+    api_session_prewarm();
+    vTaskDelete(NULL);
 }
+#endif
 
 /**
- * Initialize WiFi
+ * Build a JSON request body as prefix + escaped text + suffix in the upload slab
  */
-static void init_wifi(void)
+static char* build_json_body(const char *prefix, const char *text, const char *suffix)
 {
-    wifi_event_group = xEventGroupCreate();
-    
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    esp_netif_create_default_wifi_sta();
+    size_t prefix_len = strlen(prefix);
+    size_t text_len = strlen(text);
+    size_t escaped_len = vc_json_escape(NULL, 0, text, text_len);
+    size_t suffix_len = strlen(suffix);
     
-    wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
-    ESP_ERROR_CHECK(esp_wifi_init(&cfg));
-    
-    esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
-                                                        ESP_EVENT_ANY_ID,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        &instance_any_id));
-    ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
-                                                        &wifi_event_handler,
-                                                        NULL,
-                                                        &instance_got_ip));
-    
-    wifi_config_t wifi_config = {
-        .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASSWORD,
-            .threshold.authmode = WIFI_AUTH_WPA2_PSK,
-        },
-    };
-    
-    ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
-    
-    ESP_LOGI(TAG, "WiFi init complete, connecting to %s", WIFI_SSID);
-    set_led(LED_YELLOW);
+    char *body = audio_arena_alloc(AUDIO_SLAB_UPLOAD, prefix_len + escaped_len + suffix_len + 1);
+    if (!body) {
+        return NULL;
+    }
+    memcpy(body, prefix, prefix_len);
+    vc_json_escape(body + prefix_len, escaped_len + 1, text, text_len);
+    memcpy(body + prefix_len + escaped_len, suffix, suffix_len + 1);
+    return body;
 }
 
 /**
- * HTTP event handler for API responses
+ * Build the Chat Completions request body (upload slab, valid until the next turn)
+ */
+static char* build_chat_request(const char *transcription, bool stream)
+{
+    static const char prefix[] =
+        "{\"model\":\"gpt-4o-mini\",\"messages\":["
+        "{\"role\":\"system\",\"content\":"
+        "\"You are a helpful voice assistant. Keep responses concise and conversational.\"},"
+        "{\"role\":\"user\",\"content\":\"";
+    
+    return build_json_body(prefix, transcription,
+                           stream ? "\"}],\"temperature\":0.7,\"max_tokens\":150,\"stream\":true}"
+                                  : "\"}],\"temperature\":0.7,\"max_tokens\":150}");
+}
+
+#if !STREAMING_CHAT
+// Context for extracting the reply while the response streams in
+typedef struct {
+    vc_json_extractor_t ex;
+    vc_json_status_t parse;
+    size_t len;
+} chat_response_ctx_t;
+
+/**
+ * HTTP event handler for API responses - feeds the body to the extractor chunk by chunk
  */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
     switch (evt->event_id) {
-        case HTTP_EVENT_ON_DATA:
-            if (http_response_buffer && http_response_len + evt->data_len < HTTP_RESPONSE_BUFFER_SIZE) {
-                memcpy(http_response_buffer + http_response_len, evt->data, evt->data_len);
-                http_response_len += evt->data_len;
-                http_response_buffer[http_response_len] = '\0';
+        case HTTP_EVENT_ON_DATA: {
+            chat_response_ctx_t *ctx = (chat_response_ctx_t*)evt->user_data;
+            if (ctx->len == 0 && esp_http_client_get_status_code(evt->client) != 200) {
+                ESP_LOGE(TAG, "Chat API error: %.*s", evt->data_len, (const char*)evt->data);
+            } else if (ctx->len == 0) {
+                turn_trace_mark(TRACE_FIRST_TOKEN);  // The whole reply arrives at once
+            }
+            ctx->len += evt->data_len;
+            if (ctx->parse == VC_JSON_MORE && esp_http_client_get_status_code(evt->client) == 200) {
+                ctx->parse = vc_json_extractor_feed(&ctx->ex, evt->data, evt->data_len);
             }
             break;
+        }
         default:
             break;
     }
@@ -227,421 +270,387 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 /**
  * Get AI response from OpenAI Chat Completions API
  */
-static char* get_ai_response(const char *transcription)
+static const char* get_ai_response(const char *transcription)
 {
     ESP_LOGI(TAG, "Getting AI response for: %s", transcription);
     
-    // Allocate response buffer
-    http_response_buffer = malloc(HTTP_RESPONSE_BUFFER_SIZE);
-    if (!http_response_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate response buffer");
+    char *request_body = build_chat_request(transcription, false);
+    char *reply = audio_arena_alloc(AUDIO_SLAB_TEXT, CHAT_MAX_RESPONSE + 1);
+    if (!request_body || !reply) {
         return NULL;
     }
-    http_response_len = 0;
-    
-    // Prepare authorization header
-    char auth_header[256];
-    snprintf(auth_header, sizeof(auth_header), "Bearer %s", OPENAI_API_KEY);
-    
-    // Build request body
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "model", "gpt-4o-mini");
-    
-    cJSON *messages = cJSON_CreateArray();
-    cJSON *system_msg = cJSON_CreateObject();
-    cJSON_AddStringToObject(system_msg, "role", "system");
-    cJSON_AddStringToObject(system_msg, "content", 
-        "You are a helpful voice assistant. Keep responses concise and conversational.");
-    cJSON_AddItemToArray(messages, system_msg);
-    
-    cJSON *user_msg = cJSON_CreateObject();
-    cJSON_AddStringToObject(user_msg, "role", "user");
-    cJSON_AddStringToObject(user_msg, "content", transcription);
-    cJSON_AddItemToArray(messages, user_msg);
-    
-    cJSON_AddItemToObject(root, "messages", messages);
-    cJSON_AddNumberToObject(root, "temperature", 0.7);
-    cJSON_AddNumberToObject(root, "max_tokens", 150);
-    
-    char *request_body = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    
-    // Configure HTTP client
-    esp_http_client_config_t config = {
-        .url = "https://api.openai.com/v1/chat/completions",
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 30000,
+    
+    // Only choices[0].message.content is kept, the rest of the response is scanned past
+    chat_response_ctx_t response_ctx = {
+        .parse = VC_JSON_MORE,
+        .len = 0,
     };
+    vc_json_extractor_init_buffer(&response_ctx.ex, "choices[0].message.content", reply, CHAT_MAX_RESPONSE + 1);
     
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    // Reuse the kept-alive connection to api.openai.com
+    esp_http_client_handle_t client = api_session_acquire(HTTP_METHOD_POST, "/v1/chat/completions", 30000,
+                                                          http_event_handler, &response_ctx);
     
     esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "Authorization", auth_header);
     esp_http_client_set_post_field(client, request_body, strlen(request_body));
     
     // Perform request
-    esp_err_t err = esp_http_client_perform(client);
-    char *ai_response = NULL;
+    esp_err_t err = api_session_perform(client);
+    const char *ai_response = NULL;
     
     if (err == ESP_OK) {
         int status = esp_http_client_get_status_code(client);
         ESP_LOGI(TAG, "Chat API Status = %d", status);
         
-        if (status == 200 && http_response_len > 0) {
-            // Parse JSON response
-            cJSON *json = cJSON_Parse(http_response_buffer);
-            if (json) {
-                cJSON *choices = cJSON_GetObjectItem(json, "choices");
-                if (choices && cJSON_GetArraySize(choices) > 0) {
-                    cJSON *choice = cJSON_GetArrayItem(choices, 0);
-                    cJSON *message = cJSON_GetObjectItem(choice, "message");
-                    cJSON *content = cJSON_GetObjectItem(message, "content");
-                    if (content && content->valuestring) {
-                        ai_response = strdup(content->valuestring);
-                        ESP_LOGI(TAG, "AI Response: %s", ai_response);
-                    }
-                }
-                cJSON_Delete(json);
-            }
+        if (status == 200 && response_ctx.parse == VC_JSON_FOUND) {
+            ai_response = reply;
+            ESP_LOGI(TAG, "AI Response: %s", ai_response);
+        } else if (status == 200) {
+            ESP_LOGE(TAG, "No message content in %d byte response", response_ctx.len);
         }
     } else {
         ESP_LOGE(TAG, "Chat API request failed: %s", esp_err_to_name(err));
     }
     
-    free(request_body);
-    free(http_response_buffer);
-    esp_http_client_cleanup(client);
-    
+    api_session_release(client, err == ESP_OK);
     return ai_response;
 }
+#endif
+
+#if BARGE_IN
+static volatile bool barge_in_armed = false;
 
-// Context for TTS audio capture
+/**
+ * Watch the button for the playback that is about to start
+ *
+ * The next press edge then stops the playback (from the button ISR, the
+ * turn task is busy speaking). A button still held from the turn (VAD
+ * auto-stop) has no new edge, so it does not cut off its own reply.
+ */
+static void barge_in_arm(void)
+{
+    barge_in_requested = false;
+    barge_in_armed = true;
+}
+
+/**
+ * Stop watching once the playback is over
+ *
+ * @return true if the reply was cut off
+ */
+static bool barge_in_disarm(void)
+{
+    barge_in_armed = false;
+    if (barge_in_requested) {
+        ESP_LOGI(TAG, "Barge-in - cut off the reply");
+    }
+    return barge_in_requested;
+}
+#endif
+
+/**
+ * Button edges, from the button ISR or its settle timer
+ */
+static void button_changed(bool pressed, BaseType_t *woken, void *arg)
+{
+#if BARGE_IN
+    if (pressed && barge_in_armed && !barge_in_requested) {
+        // The turn task winds the reply down and starts recording for the next turn
+        barge_in_requested = true;
+        audio_player_stop();
+        return;
+    }
+#endif
+    control_event_t event = pressed ? CONTROL_PRESS : CONTROL_RELEASE;
+    if (woken) {
+        xQueueSendFromISR(control_queue, &event, woken);
+    } else {
+        xQueueSend(control_queue, &event, 0);
+    }
+}
+
+// Context for TTS audio streaming
 typedef struct {
-    uint8_t *buffer;
     size_t len;
-    size_t max_size;
 } tts_audio_ctx_t;
 
 /**
- * HTTP event handler for TTS binary audio data
+ * HTTP event handler for TTS binary audio data - streams straight into the player
  */
 static esp_err_t tts_event_handler(esp_http_client_event_t *evt)
 {
     if (evt->event_id == HTTP_EVENT_ON_DATA) {
-        tts_audio_ctx_t *ctx = (tts_audio_ctx_t*)evt->user_data;
-        if (ctx->buffer && ctx->len + evt->data_len < ctx->max_size) {
-            memcpy(ctx->buffer + ctx->len, evt->data, evt->data_len);
-            ctx->len += evt->data_len;
+        // Error bodies are JSON, never feed them to the speaker
+        if (esp_http_client_get_status_code(evt->client) != 200) {
+            return ESP_OK;
         }
+        tts_audio_ctx_t *ctx = (tts_audio_ctx_t*)evt->user_data;
+        turn_trace_mark(TRACE_FIRST_TTS);
+        ctx->len += audio_player_write(evt->data, evt->data_len, pdMS_TO_TICKS(TTS_WRITE_TIMEOUT_MS));
     }
     return ESP_OK;
 }
 
 /**
- * Convert text to speech using OpenAI TTS API and play it
+ * Synthesize text with the OpenAI TTS API into the active playback stream
  */
-static esp_err_t speak_text(const char *text)
+static esp_err_t tts_stream(const char *text)
 {
-    ESP_LOGI(TAG, "Converting text to speech...");
-    set_led(LED_CYAN);
-    
-    // Prepare authorization header
-    char auth_header[256];
-    snprintf(auth_header, sizeof(auth_header), "Bearer %s", OPENAI_API_KEY);
-    
-    // Build request body
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "model", "tts-1");
-    cJSON_AddStringToObject(root, "input", text);
-    cJSON_AddStringToObject(root, "voice", "alloy");
-    cJSON_AddStringToObject(root, "response_format", "pcm");
-    
-    char *request_body = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    
-    // Allocate buffer for audio response
-    size_t audio_buffer_size = 512 * 1024;  // 512KB should be enough
-    uint8_t *audio_buffer = malloc(audio_buffer_size);
-    if (!audio_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate audio buffer");
-        free(request_body);
+    char *request_body = build_json_body("{\"model\":\"tts-1\",\"input\":\"", text,
+                                         "\",\"voice\":\"alloy\",\"response_format\":\"pcm\"}");
+    if (!request_body) {
         return ESP_ERR_NO_MEM;
     }
     
     tts_audio_ctx_t audio_ctx = {
-        .buffer = audio_buffer,
         .len = 0,
-        .max_size = audio_buffer_size
-    };
-    
-    // Configure HTTP client
-    esp_http_client_config_t config = {
-        .url = "https://api.openai.com/v1/audio/speech",
-        .method = HTTP_METHOD_POST,
-        .event_handler = tts_event_handler,
-        .user_data = &audio_ctx,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 60000,
-        .buffer_size = 4096,
     };
     
-    esp_http_client_handle_t client = esp_http_client_init(&config);
+    // Reuse the kept-alive connection to api.openai.com
+    esp_http_client_handle_t client = api_session_acquire(HTTP_METHOD_POST, "/v1/audio/speech", 60000,
+                                                          tts_event_handler, &audio_ctx);
     
     esp_http_client_set_header(client, "Content-Type", "application/json");
-    esp_http_client_set_header(client, "Authorization", auth_header);
     esp_http_client_set_post_field(client, request_body, strlen(request_body));
     
-    // Perform request
-    esp_err_t err = esp_http_client_perform(client);
+    // Perform request - a barge-in stops the download with the playback
+    esp_err_t err = api_session_perform_cancellable(client, &barge_in_requested);
     
     if (err == ESP_OK) {
         int status = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "TTS API Status = %d, received %d bytes", status, audio_ctx.len);
-        
-        if (status == 200 && audio_ctx.len > 0) {
-            // Play audio through speaker
-            // TTS returns mono PCM, convert to stereo
-            size_t sample_count = audio_ctx.len / 2;
-            int16_t *stereo_buffer = (int16_t*)malloc(sample_count * 4);
-            if (stereo_buffer) {
-                int16_t *mono = (int16_t*)audio_buffer;
-                for (size_t i = 0; i < sample_count; i++) {
-                    stereo_buffer[i * 2] = mono[i];
-                    stereo_buffer[i * 2 + 1] = mono[i];
-                }
-                
-                size_t bytes_written;
-                i2s_channel_write(spk_chan, stereo_buffer, sample_count * 4, &bytes_written, portMAX_DELAY);
-                ESP_LOGI(TAG, "✓ Played %d samples", sample_count);
-                
-                free(stereo_buffer);
-            }
-        }
+        ESP_LOGI(TAG, "TTS API Status = %d, streamed %d bytes", status, audio_ctx.len);
     } else {
         ESP_LOGE(TAG, "TTS API request failed: %s", esp_err_to_name(err));
     }
     
-    free(request_body);
-    free(audio_buffer);
-    esp_http_client_cleanup(client);
-    
-    set_led(LED_GREEN);
+    api_session_release(client, err == ESP_OK);
     return err;
 }
 
+#if STREAMING_CHAT
+// Sentences (text slab strings) from the Chat stream task to the speaker, NULL ends the reply
+static QueueHandle_t sentence_queue = NULL;
+static TaskHandle_t chat_stream_task_handle = NULL;
+static char *chat_stream_request = NULL;
+
+// Context for the streamed Chat response
+typedef struct {
+    vc_chat_stream_t parser;
+    size_t len;
+} chat_stream_ctx_t;
+
+static chat_stream_ctx_t chat_stream_ctx;
+
 /**
- * Send audio to OpenAI Whisper API for transcription
+ * Sentence callback - hands each complete sentence to the speaker side
  */
-static char* transcribe_audio(const int16_t *audio_data, size_t sample_count)
+static void chat_sentence_cb(const char *sentence, size_t len, void *arg)
 {
-    ESP_LOGI(TAG, "→ Transcribing %d samples (%.2f seconds) to Whisper API...", 
-             sample_count, (float)sample_count / SAMPLE_RATE);
-    set_led(LED_YELLOW);
-    
-    // Allocate response buffer
-    http_response_buffer = malloc(HTTP_RESPONSE_BUFFER_SIZE);
-    if (!http_response_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate response buffer");
-        return NULL;
+    char *copy = audio_arena_alloc(AUDIO_SLAB_TEXT, len + 1);
+    if (copy) {
+        memcpy(copy, sentence, len + 1);
+        xQueueSend(sentence_queue, &copy, portMAX_DELAY);
     }
-    http_response_len = 0;
-    
-    ESP_LOGI(TAG, "  Building WAV file and multipart form data...");
-    
-    // Prepare authorization header
-    char auth_header[256];
-    snprintf(auth_header, sizeof(auth_header), "Bearer %s", OPENAI_API_KEY);
-    
-    // Configure HTTP client for multipart form data
-    esp_http_client_config_t config = {
-        .url = "https://api.openai.com/v1/audio/transcriptions",
-        .method = HTTP_METHOD_POST,
-        .event_handler = http_event_handler,
-        .crt_bundle_attach = esp_crt_bundle_attach,
-        .timeout_ms = 30000,
-    };
-    
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    
-    // Create multipart boundary
-    const char *boundary = "----WebKitFormBoundary7MA4YWxkTrZu0gW";
-    char content_type[128];
-    snprintf(content_type, sizeof(content_type), "multipart/form-data; boundary=%s", boundary);
-    
-    esp_http_client_set_header(client, "Authorization", auth_header);
-    esp_http_client_set_header(client, "Content-Type", content_type);
-    
-    // Build multipart form data
-    // Note: Sending raw PCM as WAV file with header
-    size_t wav_data_size = sample_count * 2;  // 16-bit samples
-    size_t wav_file_size = wav_data_size + 44;  // WAV header is 44 bytes
-    
-    // Allocate buffer for complete request body
-    size_t body_size = 512 + wav_file_size;
-    char *body = malloc(body_size);
-    if (!body) {
-        ESP_LOGE(TAG, "Failed to allocate request body");
-        free(http_response_buffer);
-        esp_http_client_cleanup(client);
-        return NULL;
+}
+
+/**
+ * HTTP event handler for the Chat SSE stream - parses events as they arrive
+ */
+static esp_err_t chat_stream_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_DATA) {
+        chat_stream_ctx_t *ctx = (chat_stream_ctx_t*)evt->user_data;
+        if (esp_http_client_get_status_code(evt->client) != 200) {
+            if (ctx->len == 0) {
+                ESP_LOGE(TAG, "Chat API error: %.*s", evt->data_len, (const char*)evt->data);
+            }
+        } else {
+            turn_trace_mark(TRACE_FIRST_TOKEN);
+            vc_chat_stream_feed(&ctx->parser, evt->data, evt->data_len);
+        }
+        ctx->len += evt->data_len;
     }
+    return ESP_OK;
+}
+
+/**
+ * Chat stream task - runs one streamed completion per notification, queueing
+ * sentences as they complete
+ *
+ * Always ends the reply with a NULL sentence, so the speaker side never
+ * waits past the HTTP timeout.
+ */
+static void chat_stream_task(void *arg)
+{
+    chat_stream_ctx_t *ctx = &chat_stream_ctx;
     
-    // Build multipart body with WAV file
-    int offset = 0;
-    offset += snprintf(body + offset, body_size - offset,
-        "--%s\r\n"
-        "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n"
-        "Content-Type: audio/wav\r\n\r\n", boundary);
-    
-    // Write WAV header
-    memcpy(body + offset, "RIFF", 4); offset += 4;
-    uint32_t chunk_size = wav_file_size - 8;
-    memcpy(body + offset, &chunk_size, 4); offset += 4;
-    memcpy(body + offset, "WAVE", 4); offset += 4;
-    memcpy(body + offset, "fmt ", 4); offset += 4;
-    uint32_t subchunk1_size = 16;
-    memcpy(body + offset, &subchunk1_size, 4); offset += 4;
-    uint16_t audio_format = 1;  // PCM
-    memcpy(body + offset, &audio_format, 2); offset += 2;
-    uint16_t num_channels = 1;
-    memcpy(body + offset, &num_channels, 2); offset += 2;
-    uint32_t sample_rate = SAMPLE_RATE;
-    memcpy(body + offset, &sample_rate, 4); offset += 4;
-    uint32_t byte_rate = SAMPLE_RATE * 2;
-    memcpy(body + offset, &byte_rate, 4); offset += 4;
-    uint16_t block_align = 2;
-    memcpy(body + offset, &block_align, 2); offset += 2;
-    uint16_t bits_per_sample = 16;
-    memcpy(body + offset, &bits_per_sample, 2); offset += 2;
-    memcpy(body + offset, "data", 4); offset += 4;
-    uint32_t subchunk2_size = wav_data_size;
-    memcpy(body + offset, &subchunk2_size, 4); offset += 4;
-    
-    // Copy audio data
-    memcpy(body + offset, audio_data, wav_data_size); offset += wav_data_size;
-    
-    // Add form fields
-    offset += snprintf(body + offset, body_size - offset,
-        "\r\n--%s\r\n"
-        "Content-Disposition: form-data; name=\"model\"\r\n\r\n"
-        "whisper-1\r\n"
-        "--%s--\r\n", boundary, boundary);
-    
-    esp_http_client_set_post_field(client, body, offset);
-    
-    ESP_LOGI(TAG, "  Sending %d bytes to Whisper API...", offset);
-    
-    // Perform request
-    esp_err_t err = esp_http_client_perform(client);
-    char *transcription = NULL;
-    
-    if (err == ESP_OK) {
-        int status = esp_http_client_get_status_code(client);
-        ESP_LOGI(TAG, "  Whisper API Status = %d, response length = %d", status, http_response_len);
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         
-        if (status == 200 && http_response_len > 0) {
-            ESP_LOGI(TAG, "  Response: %.*s", http_response_len, http_response_buffer);
-            // Parse JSON response
-            cJSON *json = cJSON_Parse(http_response_buffer);
-            if (json) {
-                cJSON *text = cJSON_GetObjectItem(json, "text");
-                if (text && text->valuestring) {
-                    transcription = strdup(text->valuestring);
-                    ESP_LOGI(TAG, "  ✓ Transcription successful");
-                } else {
-                    ESP_LOGE(TAG, "  ✗ No 'text' field in response");
-                }
-                cJSON_Delete(json);
-            } else {
-                ESP_LOGE(TAG, "  ✗ Failed to parse JSON response");
+        ctx->len = 0;
+        vc_chat_stream_init(&ctx->parser, chat_sentence_cb, NULL);
+        
+        // Holds one pooled connection while TTS uses the other
+        esp_http_client_handle_t client = api_session_acquire(HTTP_METHOD_POST, "/v1/chat/completions", 30000,
+                                                              chat_stream_event_handler, ctx);
+        
+        esp_http_client_set_header(client, "Content-Type", "application/json");
+        esp_http_client_set_header(client, "Accept", "text/event-stream");
+        esp_http_client_set_post_field(client, chat_stream_request, strlen(chat_stream_request));
+        
+        // A barge-in ends the reply here too, the sentences after it are not generated
+        esp_err_t err = api_session_perform_cancellable(client, &barge_in_requested);
+        
+        if (err == ESP_OK) {
+            int status = esp_http_client_get_status_code(client);
+            if (status == 200 && !barge_in_requested) {
+                vc_chat_stream_flush(&ctx->parser);
             }
+            ESP_LOGI(TAG, "Chat API Status = %d, %d sentences from %d bytes%s", status,
+                     ctx->parser.sentences, ctx->len, vc_chat_stream_done(&ctx->parser) ? "" : " (no [DONE])");
         } else {
-            ESP_LOGE(TAG, "  ✗ HTTP error: status=%d, response: %.*s", 
-                     status, http_response_len, http_response_buffer);
+            ESP_LOGE(TAG, "Chat API request failed: %s", esp_err_to_name(err));
         }
-    } else {
-        ESP_LOGE(TAG, "  ✗ Whisper API request failed: %s", esp_err_to_name(err));
+        
+        api_session_release(client, err == ESP_OK);
+        vc_chat_stream_free(&ctx->parser);
+        
+        char *end = NULL;
+        xQueueSend(sentence_queue, &end, portMAX_DELAY);
     }
-    
-    free(body);
-    free(http_response_buffer);
-    esp_http_client_cleanup(client);
-    
-    return transcription;
 }
 
 /**
- * Encode audio to Base64 (demo function) - runs in separate task
+ * Stream the Chat reply and speak it sentence by sentence
+ *
+ * The first sentence is synthesized while the model is still generating the
+ * rest, and all sentences play back-to-back in one playback stream.
+ *
+ * @return Number of sentences spoken
  */
+static size_t converse_streaming(const char *transcription)
+{
+    ESP_LOGI(TAG, "Getting AI response for: %s", transcription);
+    
+    chat_stream_request = build_chat_request(transcription, true);
+    if (!chat_stream_request) {
+        return 0;
+    }
+    xTaskNotifyGive(chat_stream_task_handle);
+    
+    size_t spoken = 0;
+    bool playing = false;
+    char *sentence;
+    
+    // No timeout here: the HTTP timeout bounds the chat task, which always sends the NULL
+    while (xQueueReceive(sentence_queue, &sentence, portMAX_DELAY) == pdTRUE && sentence) {
+        if (!playing) {
+            // One playback stream for the whole reply so sentences join without a gap
+            esp_err_t err = audio_player_begin(spk_chan);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to start playback: %s", esp_err_to_name(err));
+            }
+            playing = err == ESP_OK;
+#if BARGE_IN
+            if (playing) {
+                barge_in_arm();
+            }
+#endif
+            set_led(LED_CYAN);
+        }
+        
+        // After a barge-in the queue is only drained until the chat task's NULL
+        if (barge_in_requested) {
+            continue;
+        }
+        ESP_LOGI(TAG, "✓ Sentence %d: %s", spoken + 1, sentence);
+        if (playing) {
+            tts_stream(sentence);
+        }
+        spoken++;
+    }
+    
+    if (playing) {
+        // Wait for the tail of the stream to finish playing
+        audio_player_end(pdMS_TO_TICKS(TTS_DRAIN_TIMEOUT_MS));
+#if BARGE_IN
+        barge_in_disarm();
+#endif
+    }
+    return spoken;
+}
+#else
 /**
- * Initialize PDM microphone on I2S0
+ * Convert text to speech using OpenAI TTS API and play it
  */
-static esp_err_t init_pdm_microphone(void)
+static esp_err_t speak_text(const char *text)
 {
-    ESP_LOGI(TAG, "Initializing PDM microphone...");
+    ESP_LOGI(TAG, "Converting text to speech...");
+    set_led(LED_CYAN);
     
-    // I2S channel configuration for PDM RX
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
-    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, NULL, &mic_chan));
+    // Playback starts as soon as the pre-roll is buffered, while the download continues
+    esp_err_t err = audio_player_begin(spk_chan);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start playback: %s", esp_err_to_name(err));
+        set_led(LED_GREEN);
+        return err;
+    }
+#if BARGE_IN
+    barge_in_arm();
+#endif
     
-    // PDM RX configuration
-    i2s_pdm_rx_config_t pdm_rx_cfg = {
-        .clk_cfg = I2S_PDM_RX_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
-        .slot_cfg = I2S_PDM_RX_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
-        .gpio_cfg = {
-            .clk = PDM_MIC_CLK,
-            .din = PDM_MIC_DATA,
-            .invert_flags = {
-                .clk_inv = false,
-            },
-        },
-    };
+    err = tts_stream(text);
     
-    ESP_ERROR_CHECK(i2s_channel_init_pdm_rx_mode(mic_chan, &pdm_rx_cfg));
-    ESP_ERROR_CHECK(i2s_channel_enable(mic_chan));
+    // Wait for the tail of the stream to finish playing
+    audio_player_end(pdMS_TO_TICKS(TTS_DRAIN_TIMEOUT_MS));
+#if BARGE_IN
+    barge_in_disarm();
+#endif
     
-    ESP_LOGI(TAG, "PDM microphone initialized successfully!");
-    return ESP_OK;
+    set_led(LED_GREEN);
+    return err;
 }
+#endif
 
 /**
- * Initialize I2S speaker on I2S1
+ * Play a canned prompt from flash, blocking until it has played
+ *
+ * @return false if the prompt is not in flash (the LED is the only feedback)
  */
-static esp_err_t init_i2s_speaker(void)
+static bool play_prompt(prompt_id_t id)
 {
-    ESP_LOGI(TAG, "Initializing I2S speaker...");
-    
-    // I2S channel configuration for standard TX
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_1, I2S_ROLE_MASTER);
-    ESP_ERROR_CHECK(i2s_new_channel(&chan_cfg, &spk_chan, NULL));
-    
-    // Standard mode configuration for NS4168
-    i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
-        .gpio_cfg = {
-            .mclk = I2S_GPIO_UNUSED,
-            .bclk = I2S_SPK_BCK,
-            .ws = I2S_SPK_WS,
-            .dout = I2S_SPK_DATA,
-            .din = I2S_GPIO_UNUSED,
-            .invert_flags = {
-                .mclk_inv = false,
-                .bclk_inv = false,
-                .ws_inv = false,
-            },
-        },
-    };
-    
-    ESP_ERROR_CHECK(i2s_channel_init_std_mode(spk_chan, &std_cfg));
-    ESP_ERROR_CHECK(i2s_channel_enable(spk_chan));
+    size_t len;
+    const int16_t *clip = prompt_store_get(id, &len);
+    if (!clip) {
+        return false;
+    }
     
-    ESP_LOGI(TAG, "I2S speaker initialized successfully!");
-    return ESP_OK;
+    esp_err_t err = audio_player_begin(spk_chan);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start playback: %s", esp_err_to_name(err));
+        return false;
+    }
+    audio_player_write(clip, len, pdMS_TO_TICKS(TTS_WRITE_TIMEOUT_MS));
+    audio_player_end(pdMS_TO_TICKS(TTS_DRAIN_TIMEOUT_MS));
+    return true;
+}
+
+/**
+ * Show a failed turn: red LED with a spoken prompt, or a plain pause without one
+ */
+static void signal_failure(prompt_id_t id, uint32_t hold_ms)
+{
+    turn_trace_fail();
+    set_led(LED_RED);
+    if (!play_prompt(id)) {
+        vTaskDelay(pdMS_TO_TICKS(hold_ms));
+    }
+    set_led(LED_GREEN);
 }
 
+/**
+ * Encode audio to Base64 (demo function) - runs in separate task
+ */
 /**
  * Start recording audio from microphone
  */
@@ -652,40 +661,60 @@ static esp_err_t start_recording(void)
         return ESP_ERR_INVALID_STATE;
     }
     
-    // Disable speaker to free GPIO 33
-    if (spk_chan) {
-        ESP_LOGI(TAG, "Disabling speaker for recording...");
-        i2s_channel_disable(spk_chan);
-        i2s_del_channel(spk_chan);
-        spk_chan = NULL;
+#if USE_REALTIME_API
+    // Check the session before touching the channels so the speaker stays up on failure
+    esp_err_t err = realtime_turn_begin();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Realtime session not ready: %s", esp_err_to_name(err));
+        return err;
     }
+#endif
     
-    // Re-initialize microphone (in case it was disabled)
-    if (!mic_chan) {
-        ESP_LOGI(TAG, "Re-initializing microphone...");
-        ESP_ERROR_CHECK(init_pdm_microphone());
+    // Hand GPIO 33 to the microphone (no channel teardown)
+    esp_err_t bus_err = i2s_bus_select(I2S_BUS_MIC);
+    if (bus_err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to switch to microphone: %s", esp_err_to_name(bus_err));
+        return bus_err;
     }
+    vc_echo_gate_arm(&echo_gate, audio_player_recent_level(ECHO_TAIL_MS));
     
-    // Calculate max buffer size (at 24kHz, 16-bit mono)
-    recording_buffer_size = (SAMPLE_RATE * MAX_RECORDING_DURATION_MS) / 1000;  // in samples
-    size_t buffer_bytes = recording_buffer_size * sizeof(int16_t);
-    
-    ESP_LOGI(TAG, "Allocating %d bytes for recording buffer (free heap: %lu bytes)", 
-             buffer_bytes, esp_get_free_heap_size());
+#if !USE_REALTIME_API
+    // Nothing from the last turn is referenced any more
+    audio_arena_reset(AUDIO_SLAB_UPLOAD);
+    audio_arena_reset(AUDIO_SLAB_TEXT);
+#endif
     
-    recording_buffer = (int16_t *)malloc(buffer_bytes);
-    if (!recording_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate recording buffer! Need %d bytes, have %lu free", 
-                 buffer_bytes, esp_get_free_heap_size());
-        return ESP_ERR_NO_MEM;
+#if USE_REALTIME_API
+    // Audio goes straight to the WebSocket, only the sample budget is tracked
+    recording_buffer_size = (UPLOAD_SAMPLE_RATE / 1000) * MAX_STREAMED_RECORDING_MS;  // in samples
+#elif PIPELINED_UPLOAD
+    // Audio goes straight to the uploader, only the sample budget is tracked
+    recording_buffer_size = (UPLOAD_SAMPLE_RATE / 1000) * MAX_STREAMED_RECORDING_MS;  // in samples
+    esp_err_t err = whisper_stream_begin();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start streaming upload: %s", esp_err_to_name(err));
+        i2s_bus_select(I2S_BUS_SPEAKER);
+        return err;
     }
+#else
+    // The whole recording goes to the capture slab reserved at boot
+    size_t buffer_bytes;
+    recording_buffer = (int16_t *)audio_arena_slab(AUDIO_SLAB_CAPTURE, &buffer_bytes);
+    recording_buffer_size = buffer_bytes / sizeof(int16_t);  // in samples
+#endif
     
     recording_position = 0;  // in samples
+    recording_captured = 0;
+    barge_in_requested = false;  // Handled, the new turn's requests must not see it
+    vc_resampler_reset(&capture_resampler);
+    turn_trace_begin();
     is_recording = true;
+    xTaskNotifyGive(recording_task_handle);
     
-    ESP_LOGI(TAG, "Started recording (max %d seconds, %d samples buffer)", 
-             MAX_RECORDING_DURATION_MS / 1000, recording_buffer_size);
-    set_led(LED_MAGENTA);  // Recording
+    ESP_LOGI(TAG, "Started recording (max %d seconds, %d samples)", 
+             recording_buffer_size / UPLOAD_SAMPLE_RATE, recording_buffer_size);
+    status_led_level(0);
+    status_led_set(LED_MAGENTA, STATUS_LED_LEVEL);  // Recording, pulsing with the mic
     
     return ESP_OK;
 }
@@ -701,146 +730,672 @@ static esp_err_t stop_recording(void)
     }
     
     is_recording = false;
+    turn_trace_mark(TRACE_RELEASE);
     
-    float duration_sec = (float)recording_position / SAMPLE_RATE;
+    float duration_sec = (float)recording_position / UPLOAD_SAMPLE_RATE;
     ESP_LOGI(TAG, "Stopped recording: %.2f seconds, %d samples", duration_sec, recording_position);
-    
-    // Disable microphone to free GPIO 33
-    if (mic_chan) {
-        ESP_LOGI(TAG, "Disabling microphone after recording...");
-        i2s_channel_disable(mic_chan);
-        i2s_del_channel(mic_chan);
-        mic_chan = NULL;
+#if USE_VAD
+    uint32_t kept_ms = (uint32_t)((uint64_t)recording_position * 1000 / UPLOAD_SAMPLE_RATE);
+    uint32_t captured_ms = (uint32_t)((uint64_t)recording_captured * 1000 / MIC_SAMPLE_RATE);
+    if (captured_ms > 0) {  // Rounded down, so under 1 ms of capture is 0 too
+        ESP_LOGI(TAG, "Kept %lu of %lu ms captured (%lu%%) after silence trimming",
+                 kept_ms, captured_ms, kept_ms * 100 / captured_ms);
     }
+#endif
     
-    // Re-initialize speaker for playback
-    ESP_LOGI(TAG, "Re-initializing speaker for playback...");
-    ESP_ERROR_CHECK(init_i2s_speaker());
+    // Hand GPIO 33 back to the speaker for playback
+    ESP_ERROR_CHECK(i2s_bus_select(I2S_BUS_SPEAKER));
     
-    set_led(LED_YELLOW);  // Processing
+    status_led_set(LED_YELLOW, STATUS_LED_BREATHE);  // Processing
     
     return ESP_OK;
 }
 
 /**
- * Recording task - captures audio while button is pressed
+ * Hand captured samples (at MIC_SAMPLE_RATE) to the current turn's sink
+ *
+ * @return false once the recording budget is used up
+ */
+static bool capture_push(const int16_t *samples, size_t count)
+{
+    static int16_t upload_chunk[UPLOAD_CHUNK_MAX];  // Recording task only
+    
+    // A no-op copy while the rates match
+    count = vc_resampler_process(&capture_resampler, samples, count, upload_chunk);
+    if (recording_position + count > recording_buffer_size) {
+        return false;
+    }
+#if USE_REALTIME_API
+    realtime_send_audio(upload_chunk, count);
+#elif PIPELINED_UPLOAD
+    whisper_stream_push(upload_chunk, count);
+#else
+    memcpy(&recording_buffer[recording_position], upload_chunk, count * sizeof(int16_t));
+#endif
+    recording_position += count;
+    return true;
+}
+
+/**
+ * Hand a turn decision from the recording or wake task to the turn task
+ */
+static void post_control(control_event_t event)
+{
+    xQueueSend(control_queue, &event, 0);
+}
+
+#if USE_VAD
+// Owned by the recording task, except the flags and the handle
+static vc_vad_t vad;
+static int16_t vad_preroll[VAD_PREROLL_CHUNKS][AUDIO_CHUNK_SIZE];
+static size_t vad_preroll_len[VAD_PREROLL_CHUNKS];
+static int vad_preroll_head = 0;
+static int vad_preroll_count = 0;
+static bool vad_listening = false;          // HANDS_FREE: mic open between turns, waiting for speech
+
+/**
+ * Keep a chunk that may turn out to be the start of speech (oldest is dropped)
+ */
+static void vad_preroll_keep(const int16_t *samples, size_t count)
+{
+    int slot = (vad_preroll_head + vad_preroll_count) % VAD_PREROLL_CHUNKS;
+    if (vad_preroll_count == VAD_PREROLL_CHUNKS) {
+        vad_preroll_head = (vad_preroll_head + 1) % VAD_PREROLL_CHUNKS;
+    } else {
+        vad_preroll_count++;
+    }
+    memcpy(vad_preroll[slot], samples, count * sizeof(int16_t));
+    vad_preroll_len[slot] = count;
+}
+
+/**
+ * Speech started - the onset and a little lead-in go out before the current chunk
+ */
+static bool vad_preroll_flush(void)
+{
+    bool ok = true;
+    while (vad_preroll_count > 0 && ok) {
+        ok = capture_push(vad_preroll[vad_preroll_head], vad_preroll_len[vad_preroll_head]);
+        vad_preroll_head = (vad_preroll_head + 1) % VAD_PREROLL_CHUNKS;
+        vad_preroll_count--;
+    }
+    return ok;
+}
+
+#if WAKE_WORD
+static volatile uint32_t wake_end_sample = 0;   // Set by the wake task before CONTROL_WAKE
+static uint32_t wake_fed = 0;                   // Samples fed to the spotter since listening began
+
+/**
+ * Keep only the newest count samples of the pre-roll (what followed the wake word)
+ */
+static void vad_preroll_keep_last(size_t count)
+{
+    size_t total = 0;
+    for (int i = 0; i < vad_preroll_count; i++) {
+        total += vad_preroll_len[(vad_preroll_head + i) % VAD_PREROLL_CHUNKS];
+    }
+    while (vad_preroll_count > 0 && total > count) {
+        int slot = vad_preroll_head;
+        size_t excess = total - count;
+        if (excess >= vad_preroll_len[slot]) {
+            total -= vad_preroll_len[slot];
+            vad_preroll_head = (vad_preroll_head + 1) % VAD_PREROLL_CHUNKS;
+            vad_preroll_count--;
+        } else {
+            memmove(vad_preroll[slot], &vad_preroll[slot][excess], (vad_preroll_len[slot] - excess) * sizeof(int16_t));
+            vad_preroll_len[slot] -= excess;
+            total -= excess;
+        }
+    }
+}
+
+/**
+ * Wake word spotted (wake task) - the turn task starts the turn
+ */
+static void wake_spotted(uint32_t end_sample)
+{
+    wake_end_sample = end_sample;
+    post_control(CONTROL_WAKE);
+}
+
+/**
+ * Enrollment progress (wake task) - blue until every take is in
+ */
+static void wake_enroll_progress(int taken, int needed)
+{
+    set_led(taken < needed ? LED_BLUE : LED_GREEN);
+}
+#endif
+#endif
+
+/**
+ * Recording task - captures audio while a turn is recording
+ * (or, hands-free, listens for speech between turns)
+ *
+ * Sleeps on its task notification while idle; VAD events go back to the
+ * turn task through the control queue.
  */
 static void recording_task(void *arg)
 {
     int16_t audio_chunk[AUDIO_CHUNK_SIZE];
     size_t bytes_read = 0;
+#if USE_VAD
+    vc_vad_config_t vad_cfg = vc_vad_default_config(MIC_SAMPLE_RATE);
+    vc_vad_init(&vad, &vad_cfg);
+#endif
+    bool was_active = false;
+    bool ended = false;  // End reported, nothing more goes out this turn
+#if WAKE_WORD
+    bool was_recording = false;
+    bool awaiting_command = false;  // Woken, no speech since
+#endif
     
     while (1) {
-        if (is_recording) {
+#if USE_VAD
+        bool active = is_recording || vad_listening;
+#if WAKE_WORD
+        if (is_recording && !was_recording && was_active) {
+            // The wake word started this turn: what followed it opens the recording at once,
+            // then the VAD waits for the command afresh (a pause after the wake word is fine)
+            vad_preroll_keep_last(wake_fed > wake_end_sample ? wake_fed - wake_end_sample : 0);
+            vad_preroll_flush();
+            vc_vad_reset(&vad);
+            awaiting_command = true;
+        }
+        was_recording = is_recording;
+#endif
+        if (active && !was_active) {
+            // New turn (push-to-talk) or listening again (hands-free); the noise floor is kept
+            vc_vad_reset(&vad);
+            vad_preroll_head = 0;
+            vad_preroll_count = 0;
+            ended = false;
+#if WAKE_WORD
+            wake_fed = 0;
+            wake_word_listen();
+#endif
+        }
+        was_active = active;
+#else
+        bool active = is_recording;
+        if (active && !was_active) {
+            ended = false;  // New turn
+        }
+        was_active = active;
+#endif
+        if (active) {
             // Read audio from microphone
             esp_err_t ret = i2s_channel_read(mic_chan, audio_chunk, sizeof(audio_chunk), &bytes_read, 100);
             
             if (ret == ESP_OK && bytes_read > 0) {
                 size_t samples_read = bytes_read / sizeof(int16_t);
+                if (vc_echo_gate_is_echo(&echo_gate, audio_chunk, samples_read)) {
+                    continue;  // The reply still ringing, not the user
+                }
+                if (is_recording) {
+                    status_led_level(vc_echo_gate_level(audio_chunk, samples_read));
+                }
+#if USE_VAD
+                vc_vad_event_t event = vc_vad_process(&vad, audio_chunk, samples_read);
                 
-                // Check if we have space in buffer
-                if (recording_position + samples_read <= recording_buffer_size) {
-                    memcpy(&recording_buffer[recording_position], audio_chunk, bytes_read);
-                    recording_position += samples_read;
+                if (!is_recording) {
+                    // Hands-free and idle: the turn task starts the turn, this chunk leads it in
+                    vad_preroll_keep(audio_chunk, samples_read);
+#if WAKE_WORD
+                    // Only the wake word starts it, nothing leaves the device before
+                    wake_word_feed(audio_chunk, samples_read);
+                    wake_fed += samples_read;
+#else
+                    if (event == VC_VAD_START) {
+                        post_control(CONTROL_SPEECH_START);
+                    }
+#endif
+                    continue;
+                }
+                if (ended) {
+                    continue;
+                }
+                recording_captured += samples_read;
+#if WAKE_WORD
+                if (event == VC_VAD_START) {
+                    awaiting_command = false;
+                } else if (awaiting_command &&
+                           recording_captured > (size_t)(MIC_SAMPLE_RATE / 1000) * WAKE_COMMAND_MS) {
+                    // Woken but nothing followed: drop the lead-in, the turn ends unheard
+                    ESP_LOGW(TAG, "Nothing said after the wake word");
+                    awaiting_command = false;
+                    recording_position = 0;
+                    ended = true;
+                    post_control(CONTROL_SPEECH_END);
+                    continue;
+                }
+#endif
+                
+                bool ok = true;
+                bool trim = VAD_TRIM || HANDS_FREE;
+                if (event == VC_VAD_END && (VAD_AUTO_STOP || HANDS_FREE)) {
+                    ESP_LOGI(TAG, "End of speech detected");
+                    ended = true;
+                    post_control(CONTROL_SPEECH_END);
+                } else if (!trim) {
+                    ok = capture_push(audio_chunk, samples_read);
+                } else if (event == VC_VAD_START || event == VC_VAD_SPEECH) {
+                    // In hands-free mode the onset chunks are still in the pre-roll when the turn begins
+                    ok = vad_preroll_flush() && capture_push(audio_chunk, samples_read);
                 } else {
-                    // Buffer full - stop recording
+                    vad_preroll_keep(audio_chunk, samples_read);
+                }
+                
+                if (!ok) {
+                    // Buffer full - the turn task ends the turn like an end of speech
+                    ESP_LOGW(TAG, "Recording buffer full!");
+                    ended = true;
+                    set_led(LED_RED);
+                    post_control(CONTROL_SPEECH_END);
+                }
+#else
+                if (ended) {
+                    continue;
+                }
+                recording_captured += samples_read;
+                
+                // Check if we have space in buffer
+                if (!capture_push(audio_chunk, samples_read)) {
                     ESP_LOGW(TAG, "Recording buffer full!");
-                    is_recording = false;
                     set_led(LED_RED);
+                    // The turn task ends the turn with what was kept, as on a release
+                    ended = true;
+                    post_control(CONTROL_SPEECH_END);
                 }
+#endif
+            } else if (ret != ESP_OK && ret != ESP_ERR_TIMEOUT) {
+                vTaskDelay(pdMS_TO_TICKS(10));  // Channel switched away under the read
             }
         } else {
-            vTaskDelay(pdMS_TO_TICKS(100));  // Sleep when not recording
+            // Woken by start_recording() or hands_free_listen(), the first read follows at once
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         }
     }
 }
 
+#if USE_REALTIME_API
+// Realtime turn state, owned by the button task
+static bool realtime_turn_active = false;
+static bool realtime_speech_heard = false;
+static bool realtime_playing = false;
+
 /**
- * Send recorded audio to OpenAI
+ * Switch from microphone to speaker and let the response audio through
  */
+static void realtime_start_playback(void)
+{
+    if (is_recording) {
+        stop_recording();
+    }
+    if (realtime_playing) {
+        return;
+    }
+    
+    esp_err_t err = audio_player_begin(spk_chan);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start playback: %s", esp_err_to_name(err));
+        return;
+    }
+    realtime_playing = true;
+    realtime_playback_ready();
+#if BARGE_IN
+    barge_in_arm();
+#endif
+    set_led(LED_CYAN);
+}
+
 /**
- * Button task - Push-to-Talk interface
+ * Close out the current turn, draining any response audio still buffered
  */
-static void button_task(void *arg)
+static void realtime_finish_turn(status_led_color_t color)
 {
-    // GPIO 39 is input-only and has external pull-up, so don't enable internal pull-up
-    gpio_config_t io_conf = {
-        .pin_bit_mask = (1ULL << BUTTON_PIN),
-        .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,  // External pull-up on GPIO 39
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    gpio_config(&io_conf);
+    if (is_recording) {
+        stop_recording();
+    }
+    if (realtime_playing) {
+        audio_player_end(pdMS_TO_TICKS(TTS_DRAIN_TIMEOUT_MS));
+        realtime_playing = false;
+#if BARGE_IN
+        if (barge_in_disarm()) {
+            realtime_response_cancel();
+        }
+#endif
+    }
+    realtime_turn_active = false;
+    realtime_speech_heard = false;
+    set_led(color);
+    turn_trace_end();
+    audio_arena_log_stats();
+    turn_trace_log_stats();
+}
+
+/**
+ * Stop capturing before the server VAD did: commit what was said, or drop a silent turn
+ */
+static void realtime_end_capture(const char *reason)
+{
+    if (realtime_speech_heard) {
+        ESP_LOGI(TAG, "%s - committing turn...", reason);
+        realtime_turn_commit();
+        realtime_start_playback();
+    } else {
+        ESP_LOGW(TAG, "No speech detected!");
+        realtime_turn_cancel();
+        realtime_finish_turn(LED_RED);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+        set_led(LED_GREEN);
+    }
+}
+
+/**
+ * Apply session events from the Realtime client (non-blocking)
+ */
+static void realtime_handle_events(void)
+{
+    realtime_event_t event;
+    while (realtime_get_event(&event, 0) == pdTRUE) {
+        switch (event) {
+            case REALTIME_EVENT_READY:
+                ESP_LOGI(TAG, "Realtime session ready");
+                if (!realtime_turn_active) {
+                    set_led(LED_GREEN);
+                }
+                break;
+            case REALTIME_EVENT_SPEECH_STARTED:
+                realtime_speech_heard = true;
+                break;
+            case REALTIME_EVENT_SPEECH_STOPPED:
+                // Server VAD ended the turn, the response is already being generated
+                if (realtime_turn_active) {
+                    ESP_LOGI(TAG, "End of speech detected by server");
+                    realtime_start_playback();
+                }
+                break;
+            case REALTIME_EVENT_RESPONSE_DONE:
+                if (realtime_turn_active) {
+                    realtime_finish_turn(LED_GREEN);
+                }
+                break;
+            case REALTIME_EVENT_ERROR:
+                if (realtime_turn_active) {
+                    turn_trace_fail();
+                    realtime_finish_turn(LED_RED);
+                    signal_failure(PROMPT_ERROR, 1000);
+                }
+                break;
+            case REALTIME_EVENT_DISCONNECTED:
+                if (realtime_turn_active) {
+                    turn_trace_fail();
+                }
+                realtime_finish_turn(LED_YELLOW);
+                break;
+        }
+    }
+}
+#endif
+
+#if !USE_REALTIME_API
+/**
+ * End the recording and run it through Whisper, Chat and TTS
+ */
+static void finish_turn(void)
+{
+    stop_recording();
+    
+    // Check if we have audio
+    if (recording_position == 0) {
+#if USE_VAD
+        ESP_LOGW(TAG, "No speech detected, nothing uploaded");
+#else
+        ESP_LOGW(TAG, "No audio recorded!");
+#endif
+#if PIPELINED_UPLOAD
+        whisper_stream_abort();
+#endif
+        signal_failure(PROMPT_NOT_HEARD, 1000);
+        turn_trace_end();
+        return;
+    }
     
-    bool last_state = true;
+    ESP_LOGI(TAG, "Processing %d samples...", recording_position);
+    status_led_set(LED_YELLOW, STATUS_LED_BREATHE);  // Processing
     
-    while (1) {
-        bool current_state = gpio_get_level(BUTTON_PIN);
+    // Step 1: Transcribe audio
+    ESP_LOGI(TAG, "Step 1: Calling Whisper API...");
+#if PIPELINED_UPLOAD
+    // Most of the audio is already uploaded, only the tail and trailer remain
+    const char *transcription = whisper_stream_finish();
+#else
+    const char *transcription = whisper_transcribe(recording_buffer, recording_position);
+#endif
+    if (transcription) {
+        turn_trace_mark(TRACE_TRANSCRIPT);
+    }
+    if (transcription && transcription[0] == '\0') {
+        ESP_LOGW(TAG, "Nothing transcribed");
+        signal_failure(PROMPT_NOT_HEARD, 1000);
+    } else if (transcription) {
+        ESP_LOGI(TAG, "✓ Transcription: %s", transcription);
         
-        // Button pressed (active low)
-        if (last_state == true && current_state == false) {
-            vTaskDelay(pdMS_TO_TICKS(50)); // Debounce
-            if (gpio_get_level(BUTTON_PIN) == false) {
-                ESP_LOGI(TAG, "Button pressed - starting recording...");
-                start_recording();
-            }
+#if STREAMING_CHAT
+        // Steps 2 and 3 overlap: each sentence is spoken while the next is generated
+        ESP_LOGI(TAG, "Step 2+3: Streaming Chat API into TTS...");
+        if (converse_streaming(transcription) > 0) {
+            set_led(LED_GREEN);
+        } else {
+            ESP_LOGE(TAG, "✗ Failed to get AI response");
+            signal_failure(PROMPT_ERROR, 2000);
         }
-        // Button released
-        else if (last_state == false && current_state == true) {
-            vTaskDelay(pdMS_TO_TICKS(50)); // Debounce
-            if (gpio_get_level(BUTTON_PIN) == true) {
-                ESP_LOGI(TAG, "Button released - processing...");
-                stop_recording();
-                
-                // Check if we have audio
-                if (recording_position == 0) {
-                    ESP_LOGW(TAG, "No audio recorded!");
-                    set_led(LED_RED);
-                    vTaskDelay(pdMS_TO_TICKS(1000));
-                    set_led(LED_GREEN);
-                    continue;
-                }
-                
-                ESP_LOGI(TAG, "Processing %d samples...", recording_position);
-                set_led(LED_YELLOW);  // Processing
-                
-                // Step 1: Transcribe audio
-                ESP_LOGI(TAG, "Step 1: Calling Whisper API...");
-                char *transcription = transcribe_audio(recording_buffer, recording_position);
-                if (transcription) {
-                    ESP_LOGI(TAG, "✓ Transcription: %s", transcription);
-                    
-                    // Step 2: Get AI response
-                    ESP_LOGI(TAG, "Step 2: Calling Chat API...");
-                    char *response = get_ai_response(transcription);
-                    if (response) {
-                        ESP_LOGI(TAG, "✓ AI Response: %s", response);
-                        
-                        // Step 3: Convert to speech and play
-                        ESP_LOGI(TAG, "Step 3: Calling TTS API...");
-                        speak_text(response);
-                        
-                        free(response);
-                    } else {
-                        ESP_LOGE(TAG, "✗ Failed to get AI response");
-                        set_led(LED_RED);
-                        vTaskDelay(pdMS_TO_TICKS(2000));
-                        set_led(LED_GREEN);
+#else
+        // Step 2: Get AI response
+        ESP_LOGI(TAG, "Step 2: Calling Chat API...");
+        const char *response = get_ai_response(transcription);
+        if (response) {
+            ESP_LOGI(TAG, "✓ AI Response: %s", response);
+            
+            // Step 3: Convert to speech and play
+            ESP_LOGI(TAG, "Step 3: Calling TTS API...");
+            speak_text(response);
+        } else {
+            ESP_LOGE(TAG, "✗ Failed to get AI response");
+            signal_failure(PROMPT_ERROR, 2000);
+        }
+#endif
+    } else {
+        ESP_LOGE(TAG, "✗ Failed to transcribe audio");
+        signal_failure(PROMPT_ERROR, 2000);
+    }
+    turn_trace_end();
+    audio_arena_log_stats();
+    turn_trace_log_stats();
+}
+#endif
+
+#if HANDS_FREE
+/**
+ * Give GPIO 33 to the microphone and wait for the next utterance
+ */
+static void hands_free_listen(void)
+{
+    esp_err_t err = i2s_bus_select(I2S_BUS_MIC);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to switch to microphone: %s", esp_err_to_name(err));
+        return;
+    }
+    vc_echo_gate_arm(&echo_gate, audio_player_recent_level(ECHO_TAIL_MS));
+    vad_listening = true;
+    xTaskNotifyGive(recording_task_handle);
+    set_led(LED_GREEN);
+}
+#endif
+
+#if BARGE_IN
+/**
+ * Start the next turn right away if a press cut off the reply
+ *
+ * @return true if recording started (the button is being held)
+ */
+static bool barge_in_restart(void)
+{
+    if (!barge_in_requested) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Barge-in - starting recording...");
+#if USE_REALTIME_API
+    realtime_turn_active = start_recording() == ESP_OK;
+    return realtime_turn_active;
+#else
+    return start_recording() == ESP_OK;
+#endif
+}
+#endif
+
+#if !HANDS_FREE
+/**
+ * Push-to-talk press: start a turn
+ */
+static void handle_press(void)
+{
+    if (!button_is_pressed()) {
+        return;  // A tap while the last turn was still busy
+    }
+#if USE_REALTIME_API
+    if (realtime_turn_active) {
+        ESP_LOGW(TAG, "Response still playing, ignoring button");
+        return;
+    }
+    ESP_LOGI(TAG, "Button pressed - streaming to Realtime API...");
+    realtime_turn_active = start_recording() == ESP_OK;
+#else
+    if (is_recording) {
+        return;  // Already started by a barge-in
+    }
+    ESP_LOGI(TAG, "Button pressed - starting recording...");
+    if (start_recording() != ESP_OK) {
+        return;
+    }
+#endif
+    ESP_LOGI(TAG, "Mic live %lld us after the press", esp_timer_get_time() - button_last_change_us());
+}
+
+/**
+ * Push-to-talk release: end the turn
+ */
+static void handle_release(void)
+{
+#if USE_REALTIME_API
+    // Server VAD normally ends the turn first; otherwise end it here
+    if (realtime_turn_active && !realtime_playing) {
+        realtime_end_capture("Button released");
+    }
+#else
+    // With VAD_AUTO_STOP the turn may already be over
+    if (is_recording) {
+        ESP_LOGI(TAG, "Button released - processing...");
+        finish_turn();
+#if BARGE_IN
+        barge_in_restart();  // Its release is still to come
+#endif
+    }
+#endif
+}
+#endif
+
+/**
+ * Turn task - runs each turn from the control events
+ * (push-to-talk edges from the button ISR, or the recording task's VAD)
+ *
+ * Whisper, Chat and TTS run here, so it sits on the network core with the
+ * stack the TLS calls need. It blocks on the control queue between
+ * events; only Realtime mode also wakes every 10 ms for session events.
+ */
+static void turn_task(void *arg)
+{
+#if HANDS_FREE
+    hands_free_listen();
+#endif
+#if USE_REALTIME_API
+    const TickType_t wait = pdMS_TO_TICKS(10);
+#else
+    const TickType_t wait = portMAX_DELAY;
+#endif
+    
+    while (1) {
+        control_event_t event;
+        if (xQueueReceive(control_queue, &event, wait) == pdTRUE) {
+            switch (event) {
+#if !HANDS_FREE
+                case CONTROL_PRESS:
+                    handle_press();
+                    break;
+                case CONTROL_RELEASE:
+                    handle_release();
+                    break;
+#endif
+#if USE_VAD
+#if HANDS_FREE
+#if WAKE_WORD
+                case CONTROL_WAKE:
+#else
+                case CONTROL_SPEECH_START:
+#endif
+                    if (vad_listening && !is_recording) {
+                        ESP_LOGI(TAG, WAKE_WORD ? "Wake word - starting turn..." : "Speech detected - starting turn...");
+                        // The mic keeps running, is_recording takes over from vad_listening
+                        if (start_recording() == ESP_OK) {
+                            vad_listening = false;
+                        } else {
+                            hands_free_listen();
+                        }
                     }
-                    
-                    free(transcription);
-                } else {
-                    ESP_LOGE(TAG, "✗ Failed to transcribe audio");
-                    set_led(LED_RED);
-                    vTaskDelay(pdMS_TO_TICKS(2000));
-                    set_led(LED_GREEN);
-                }
+                    break;
+#endif
+#endif
+                case CONTROL_SPEECH_END:
+#if USE_REALTIME_API
+                    // Buffer full: the mic stays open until this task stops it
+                    if (realtime_turn_active && !realtime_playing && is_recording) {
+                        realtime_end_capture("Recording buffer full");
+                    }
+#else
+                    if (is_recording) {
+                        ESP_LOGI(TAG, "Speech ended - processing...");
+                        finish_turn();
+#if HANDS_FREE && BARGE_IN
+                        if (!barge_in_restart()) {
+                            hands_free_listen();
+                        }
+#elif HANDS_FREE
+                        hands_free_listen();
+#elif BARGE_IN
+                        barge_in_restart();  // Held, its release ends the new turn
+#endif
+                    }
+#endif
+                    break;
+                default:
+                    break;
             }
         }
         
-        last_state = current_state;
-        vTaskDelay(pdMS_TO_TICKS(10));
+#if USE_REALTIME_API
+        realtime_handle_events();
+#if BARGE_IN
+        // Cut off mid-response: cancel it and hand the bus back to the mic
+        if (realtime_playing && barge_in_requested) {
+            realtime_finish_turn(LED_GREEN);
+        }
+        if (!realtime_turn_active) {
+            barge_in_restart();  // Held, its release ends the new turn
+        }
+#endif
+#endif
     }
 }
 
@@ -853,6 +1408,10 @@ void app_main(void)
     ESP_LOGI(TAG, "Build: PlatformIO + ESP-IDF");
     ESP_LOGI(TAG, "ESP-IDF Version: %s", esp_get_idf_version());
     
+#if RUN_BENCHMARKS
+    vc_bench_run(NULL);
+#endif
+    
     // Initialize NVS
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -861,49 +1420,184 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
     
-    // Initialize LED
+    // Every large audio and text buffer, reserved before Wi-Fi and TLS fragment the heap.
+    // Bulk slabs go to PSRAM when the board has it, leaving internal RAM for TLS.
+    static const size_t arena_sizes[AUDIO_SLAB_COUNT] = {
+        [AUDIO_SLAB_CAPTURE]  = ARENA_CAPTURE_SIZE,
+        [AUDIO_SLAB_UPLOAD]   = ARENA_UPLOAD_SIZE,
+        [AUDIO_SLAB_TEXT]     = ARENA_TEXT_SIZE,
+        [AUDIO_SLAB_PLAYBACK] = ARENA_PLAYBACK_SIZE,
+    };
+    ESP_ERROR_CHECK(audio_arena_init(arena_sizes));
+    
+    // LED task first, so every later step can show its state without waiting on it
+    const status_led_config_t led_cfg = {
+        .gpio = LED_PIN,
+        .priority = 2,
+        .core = NET_CORE,
+    };
+    ESP_ERROR_CHECK(status_led_init(&led_cfg));
     set_led(LED_BLUE);
-    ESP_ERROR_CHECK(init_led());
     
-    // Initialize WiFi
-    init_wifi();
+    // Start associating now; everything up to the wait below is local and runs meanwhile
+    static const wifi_link_config_t wifi_cfg = {
+        .ssid = WIFI_SSID,
+        .password = WIFI_PASSWORD,
+        .static_ip = WIFI_STATIC_IP,
+        .gateway = WIFI_GATEWAY,
+        .netmask = WIFI_NETMASK,
+        .dns = WIFI_DNS,
+        .on_state = wifi_state_changed,
+    };
+    ESP_ERROR_CHECK(wifi_link_start(&wifi_cfg));
+    status_led_set(LED_YELLOW, STATUS_LED_BREATHE);
+    
+    // Both I2S channels are created once - they share GPIO 33!
+    // Microphone uses GPIO 33 for PDM CLK
+    // Speaker uses GPIO 33 for I2S WS
+    // Switching only reroutes the pin, so nothing is reallocated per turn
+    i2s_bus_config_t bus_cfg = {
+        .mic_rate = MIC_SAMPLE_RATE,
+        .spk_rate = PLAYBACK_SAMPLE_RATE,
+        .mic_clk = PDM_MIC_CLK,
+        .mic_data = PDM_MIC_DATA,
+        .spk_bck = I2S_SPK_BCK,
+        .spk_ws = I2S_SPK_WS,
+        .spk_data = I2S_SPK_DATA,
+    };
+    ESP_ERROR_CHECK(i2s_bus_init(&bus_cfg));
+    mic_chan = i2s_bus_mic();
+    spk_chan = i2s_bus_speaker();
+    ESP_ERROR_CHECK(i2s_bus_select(I2S_BUS_SPEAKER));
+    
+    // The mic keeps its PDM rate, uploads go out at the rate the API wants
+    if (!vc_resampler_init(&capture_resampler, MIC_SAMPLE_RATE, UPLOAD_SAMPLE_RATE)) {
+        ESP_LOGE(TAG, "Unsupported resampling ratio %d -> %d Hz", MIC_SAMPLE_RATE, UPLOAD_SAMPLE_RATE);
+        return;
+    }
+    ESP_LOGI(TAG, "Audio: mic %d Hz, upload %d Hz, playback %d Hz",
+             MIC_SAMPLE_RATE, UPLOAD_SAMPLE_RATE, PLAYBACK_SAMPLE_RATE);
+    
+    // Streaming TTS playback (ring buffer + playback task)
+    ESP_ERROR_CHECK(audio_player_init(PLAYBACK_SAMPLE_RATE));
+    
+    // Error and status prompts from flash, optional (without an image they stay LED only)
+    prompt_store_init(PLAYBACK_SAMPLE_RATE);
+    
+#if !USE_REALTIME_API
+    // Shared keep-alive connection pool to api.openai.com (no traffic yet)
+    ESP_ERROR_CHECK(api_session_init());
+    
+    // Whisper uploader (capture ring + upload task for pipelined mode)
+    ESP_ERROR_CHECK(whisper_init(UPLOAD_SAMPLE_RATE, PIPELINED_UPLOAD));
+#if STREAMING_CHAT
+    // TLS handshake may run on the chat task, so it gets the same stack as the REST calls
+    sentence_queue = xQueueCreate(SENTENCE_QUEUE_LEN, sizeof(char*));
+    if (!sentence_queue ||
+        xTaskCreatePinnedToCore(chat_stream_task, "chat_stream_task", 8192, NULL, 6,
+                                &chat_stream_task_handle, NET_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create chat stream task");
+        return;
+    }
+    turn_trace_watch_task(chat_stream_task_handle);
+#endif
+#endif
+    
+    // Mic frames no louder than the last reply's fading echo are dropped
+    vc_echo_gate_init(&echo_gate, MIC_SAMPLE_RATE, ECHO_TAIL_MS, ECHO_COUPLING_Q8);
     
     // Wait for WiFi connection
-    EventBits_t bits = xEventGroupWaitBits(wifi_event_group,
-                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                           pdFALSE,
-                                           pdFALSE,
-                                           portMAX_DELAY);
-    
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "WiFi connected!");
-        set_led(LED_CYAN);
-    } else {
+    if (!wifi_link_wait(UINT32_MAX)) {
         ESP_LOGE(TAG, "WiFi connection failed!");
         set_led(LED_RED);
         return;
     }
+    ESP_LOGI(TAG, "WiFi connected!");
+    set_led(LED_CYAN);
     
-    // DON'T initialize both I2S channels at boot - they share GPIO 33!
-    // Microphone uses GPIO 33 for PDM CLK
-    // Speaker uses GPIO 33 for I2S WS
-    // We'll dynamically init/deinit based on whether we're recording or playing
-    ESP_LOGI(TAG, "I2S channels will be initialized dynamically (GPIO 33 sharing)");
+#if METRICS_PORT
+    // Turn latencies, heap and stack watermarks for the fleet scraper (not needed to run)
+    turn_trace_start_server(METRICS_PORT);
+#endif
+    
+#if USE_REALTIME_API
+    // Realtime WebSocket - response audio is decoded into the playback ring
+    ESP_ERROR_CHECK(realtime_init(UPLOAD_SAMPLE_RATE));
+#else
+    // TLS handshake to api.openai.com in the background, so it does not hold up ready
+    xTaskCreatePinnedToCore(prewarm_task, "prewarm_task", 8192, NULL, 4, NULL, NET_CORE);
+#endif
     
     // Ready!
     ESP_LOGI(TAG, "Setup complete - Ready!");
     ESP_LOGI(TAG, "Free heap: %lu bytes", esp_get_free_heap_size());
+    mem_policy_log_stats();
     set_led(LED_GREEN);
+    play_prompt(PROMPT_READY);
+    
+#if WAKE_WORD
+    // Spots the wake word in what the recording task hears between turns, in the audio core's idle time
+    const wake_word_config_t wake_cfg = {
+        .sample_rate = MIC_SAMPLE_RATE,
+        .priority = 3,
+        .core = AUDIO_CORE,
+        .margin_q8 = WAKE_WORD_MARGIN_Q8,
+        .on_wake = wake_spotted,
+        .on_enroll = wake_enroll_progress,
+    };
+    ESP_ERROR_CHECK(wake_word_init(&wake_cfg));
+#endif
     
-    // Start recording task
-    xTaskCreate(recording_task, "recording_task", 4096, NULL, 10, NULL);
+    // Audio on its own core, the turn task (TLS) next to Wi-Fi: a handshake never delays a mic read
+    TaskHandle_t turn_task_handle = NULL;
+    control_queue = xQueueCreate(CONTROL_QUEUE_LEN, sizeof(control_event_t));
+    if (!control_queue ||
+        xTaskCreatePinnedToCore(recording_task, "recording_task", 4096, NULL, 10,
+                                &recording_task_handle, AUDIO_CORE) != pdPASS ||
+        xTaskCreatePinnedToCore(turn_task, "turn_task", 8192, NULL, 5,
+                                &turn_task_handle, NET_CORE) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create turn tasks");
+        set_led(LED_RED);
+        return;
+    }
+    turn_trace_watch_task(recording_task_handle);
+    turn_trace_watch_task(turn_task_handle);
+    
+    // Press and release edges interrupt straight into the control queue (also barge-in when hands-free)
+    const button_config_t button_cfg = {
+        .pin = BUTTON_PIN,
+        .active_low = true,
+        .debounce_ms = BUTTON_DEBOUNCE_MS,
+        .on_change = button_changed,
+    };
+    ESP_ERROR_CHECK(button_init(&button_cfg));
     
-    // Start button task (reduced stack for REST API sequential processing)
-    xTaskCreate(button_task, "button_task", 8192, NULL, 5, NULL);
+#if WAKE_WORD
+    if (!wake_word_enrolled() || button_is_pressed()) {
+        // First boot, or the button held through reset: say the wake word three times
+        wake_word_enroll();
+    }
+#endif
     
+    ESP_LOGI(TAG, "Boot to ready: %lld ms (WiFi %lld ms, %s)", esp_timer_get_time() / 1000,
+             wifi_link_connect_time_us() / 1000, wifi_link_fast_connected() ? "cached AP" : "full scan");
+#if WAKE_WORD
+    ESP_LOGI(TAG, "Voice assistant ready! Say the wake word, then your request.");
+#elif HANDS_FREE
+    ESP_LOGI(TAG, "Voice assistant ready! Just start speaking.");
+#else
     ESP_LOGI(TAG, "Voice assistant ready! Press and hold button to speak.");
+#endif
+#if USE_REALTIME_API
+    ESP_LOGI(TAG, "Mode: Realtime API (server VAD ends the turn, max %d seconds)",
+             MAX_STREAMED_RECORDING_MS / 1000);
+#elif PIPELINED_UPLOAD
+    ESP_LOGI(TAG, "Max recording: %d seconds (streamed to Whisper while recording)",
+             MAX_STREAMED_RECORDING_MS / 1000);
+#else
     ESP_LOGI(TAG, "Max recording: %d seconds (%d samples = %d bytes)",
              MAX_RECORDING_DURATION_MS / 1000,
-             (SAMPLE_RATE * MAX_RECORDING_DURATION_MS) / 1000,
-             (SAMPLE_RATE * MAX_RECORDING_DURATION_MS * 2) / 1000);
+             (UPLOAD_SAMPLE_RATE * MAX_RECORDING_DURATION_MS) / 1000,
+             (UPLOAD_SAMPLE_RATE * MAX_RECORDING_DURATION_MS * 2) / 1000);
+#endif
 }
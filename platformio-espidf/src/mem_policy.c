@@ -0,0 +1,72 @@
+/**
+ * Memory placement policy
+ *
+ * The ATOM Echo's ESP32-PICO-D4 has no PSRAM, but modules that have it run
+ * the same code once CONFIG_SPIRAM is enabled. Internal RAM is what runs
+ * out first - a TLS handshake needs tens of KB of it at once - so anything
+ * large that is only streamed through goes to PSRAM whenever there is
+ * some, and only buffers on real-time or DMA paths insist on internal RAM.
+ */
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "mem_policy.h"
+
+static const char *TAG = "mem_policy";
+
+#define CAPS_PSRAM    (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#define CAPS_INTERNAL (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#define CAPS_DMA      (MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA | MALLOC_CAP_8BIT)
+
+bool mem_policy_has_psram(void)
+{
+    return heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+}
+
+void *mem_policy_alloc(mem_class_t cls, size_t size)
+{
+    void *ptr;
+    switch (cls) {
+        case MEM_BULK:
+            // Tries PSRAM first; without PSRAM this is a plain internal allocation
+            ptr = heap_caps_malloc_prefer(size, 2, CAPS_PSRAM, CAPS_INTERNAL);
+            break;
+        case MEM_DMA:
+            ptr = heap_caps_malloc(size, CAPS_DMA);
+            break;
+        case MEM_INTERNAL:
+        default:
+            ptr = heap_caps_malloc(size, CAPS_INTERNAL);
+            break;
+    }
+
+    if (!ptr) {
+        ESP_LOGE(TAG, "Failed to allocate %d bytes (class %d, largest internal block: %d)",
+                 size, cls, heap_caps_get_largest_free_block(CAPS_INTERNAL));
+    }
+    return ptr;
+}
+
+void mem_policy_free(void *ptr)
+{
+    heap_caps_free(ptr);
+}
+
+bool mem_policy_is_psram(const void *ptr)
+{
+    return ptr && esp_ptr_external_ram(ptr);
+}
+
+void mem_policy_log_stats(void)
+{
+    ESP_LOGI(TAG, "Internal: %d free, %d largest block, %d minimum ever",
+             heap_caps_get_free_size(CAPS_INTERNAL), heap_caps_get_largest_free_block(CAPS_INTERNAL),
+             heap_caps_get_minimum_free_size(CAPS_INTERNAL));
+    if (mem_policy_has_psram()) {
+        ESP_LOGI(TAG, "PSRAM: %d free, %d largest block",
+                 heap_caps_get_free_size(CAPS_PSRAM), heap_caps_get_largest_free_block(CAPS_PSRAM));
+    } else {
+        ESP_LOGI(TAG, "PSRAM: none, bulk buffers use internal RAM");
+    }
+}
@@ -0,0 +1,53 @@
+/**
+ * Memory placement policy
+ * Picks internal RAM or PSRAM by what a buffer is used for
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    MEM_BULK = 0,   /*!< Large, sequentially accessed buffers - PSRAM when present, else internal */
+    MEM_INTERNAL,   /*!< Hot state and buffers on real-time paths - internal only */
+    MEM_DMA,        /*!< Buffers handed straight to a DMA engine - internal, DMA-capable */
+} mem_class_t;
+
+/**
+ * @brief true if the heap has PSRAM (CONFIG_SPIRAM and the chip was found)
+ */
+bool mem_policy_has_psram(void);
+
+/**
+ * @brief Allocate size bytes placed according to cls
+ *
+ * MEM_BULK falls back to internal RAM when PSRAM is absent or full, so
+ * callers never need to know which board they run on.
+ *
+ * @return Memory (free with mem_policy_free()), or NULL if nothing fits
+ */
+void *mem_policy_alloc(mem_class_t cls, size_t size);
+
+/**
+ * @brief Free memory from mem_policy_alloc()
+ */
+void mem_policy_free(void *ptr);
+
+/**
+ * @brief true if ptr is in PSRAM
+ */
+bool mem_policy_is_psram(const void *ptr);
+
+/**
+ * @brief Log free and largest-block sizes of internal RAM and PSRAM
+ */
+void mem_policy_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
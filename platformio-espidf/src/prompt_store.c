@@ -0,0 +1,119 @@
+/**
+ * Canned voice prompts
+ *
+ * The wrong-turn feedback used to be a red LED for a second or two, which is
+ * easy to miss on a device you talk to rather than look at. Synthesizing the
+ * prompts through TTS would need the very network that usually just failed,
+ * so they are rendered once on a PC and flashed into their own partition.
+ *
+ * Image layout (little-endian, offsets from the start of the partition):
+ *   header  magic "VCPR", u16 version, u16 count, u32 sample_rate
+ *   entries count x { char name[16], u32 offset, u32 length }
+ *   clips   mono PCM16, each 4-byte aligned
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "prompt_store.h"
+
+static const char *TAG = "prompt_store";
+
+#define PROMPT_PARTITION_SUBTYPE 0x40   // Custom data subtype, see partitions.csv
+#define PROMPT_MAGIC 0x52504356         // "VCPR"
+#define PROMPT_VERSION 1
+#define PROMPT_NAME_LEN 16
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t sample_rate;
+} prompt_header_t;
+
+typedef struct {
+    char name[PROMPT_NAME_LEN];     // NUL-padded
+    uint32_t offset;
+    uint32_t length;
+} prompt_entry_t;
+
+// Names in the image, indexed by prompt_id_t (the renderer's PROMPTS keys)
+static const char *const prompt_names[PROMPT_COUNT] = {
+    [PROMPT_READY]     = "ready",
+    [PROMPT_NOT_HEARD] = "not_heard",
+    [PROMPT_ERROR]     = "error",
+};
+
+static const int16_t *s_clips[PROMPT_COUNT];
+static size_t s_lengths[PROMPT_COUNT];
+
+esp_err_t prompt_store_init(uint32_t sample_rate)
+{
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           PROMPT_PARTITION_SUBTYPE, "prompts");
+    if (!part) {
+        ESP_LOGW(TAG, "No prompts partition, prompts are LED only");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Mapped once for good: clips are played straight from flash
+    const uint8_t *base;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA,
+                                       (const void **)&base, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to map prompts partition: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    prompt_header_t header;
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != PROMPT_MAGIC || header.version != PROMPT_VERSION ||
+        sizeof(header) + header.count * sizeof(prompt_entry_t) > part->size) {
+        ESP_LOGW(TAG, "Prompts partition holds no prompt image (flash one with render_prompts.py)");
+        esp_partition_munmap(handle);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (header.sample_rate != sample_rate) {
+        ESP_LOGE(TAG, "Prompts rendered at %lu Hz, playback runs at %lu Hz",
+                 (unsigned long)header.sample_rate, (unsigned long)sample_rate);
+        esp_partition_munmap(handle);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    const prompt_entry_t *entries = (const prompt_entry_t *)(base + sizeof(header));
+    size_t found = 0;
+    for (int id = 0; id < PROMPT_COUNT; id++) {
+        for (int i = 0; i < header.count; i++) {
+            prompt_entry_t entry;
+            memcpy(&entry, &entries[i], sizeof(entry));
+            if (strncmp(entry.name, prompt_names[id], PROMPT_NAME_LEN) != 0) {
+                continue;
+            }
+            if ((entry.offset & 3) || entry.offset > part->size || entry.length > part->size - entry.offset) {
+                ESP_LOGW(TAG, "Prompt \"%s\" lies outside the partition", prompt_names[id]);
+                break;
+            }
+            s_clips[id] = (const int16_t *)(base + entry.offset);
+            s_lengths[id] = entry.length & ~(size_t)1;
+            found++;
+            break;
+        }
+        if (!s_clips[id]) {
+            ESP_LOGW(TAG, "Prompt \"%s\" missing from image", prompt_names[id]);
+        }
+    }
+
+    ESP_LOGI(TAG, "%d of %d prompts mapped from flash (%lu Hz)", found, PROMPT_COUNT,
+             (unsigned long)sample_rate);
+    return ESP_OK;
+}
+
+const int16_t *prompt_store_get(prompt_id_t id, size_t *len)
+{
+    if (id >= PROMPT_COUNT || !s_clips[id]) {
+        return NULL;
+    }
+    *len = s_lengths[id];
+    return s_clips[id];
+}
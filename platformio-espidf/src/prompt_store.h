@@ -0,0 +1,48 @@
+/**
+ * Canned voice prompts
+ * Pre-rendered PCM16 clips in the "prompts" flash partition, so error and
+ * status prompts play without the network (image built by server/render_prompts.py)
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PROMPT_READY = 0,   /*!< "ready" - setup finished */
+    PROMPT_NOT_HEARD,   /*!< "not_heard" - no speech, or nothing transcribed */
+    PROMPT_ERROR,       /*!< "error" - a request failed */
+    PROMPT_COUNT,
+} prompt_id_t;
+
+/**
+ * @brief Map the prompts partition and index its clips (call once at boot)
+ *
+ * A missing partition or a blank/foreign image is not fatal: every prompt
+ * is then absent and callers fall back to the LED alone.
+ *
+ * @param[in] sample_rate Playback rate the clips must have been rendered at
+ * @return
+ *      - ESP_OK: Store mapped (some prompts may still be absent)
+ *      - ESP_ERR_NOT_FOUND: No prompts partition
+ *      - ESP_ERR_INVALID_VERSION: Partition holds no valid image, or one at another rate
+ */
+esp_err_t prompt_store_init(uint32_t sample_rate);
+
+/**
+ * @brief Look up a clip, straight from memory-mapped flash (no copy)
+ *
+ * @param[out] len Clip length in bytes (mono PCM16)
+ * @return Clip samples, or NULL if the image has no such prompt
+ */
+const int16_t *prompt_store_get(prompt_id_t id, size_t *len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,544 @@
+/**
+ * OpenAI Realtime API client
+ *
+ * Replaces the Whisper -> Chat -> TTS chain with a single WebSocket: mic
+ * frames are appended to the server's input buffer as they are captured,
+ * server VAD decides when the user has finished, and the response audio
+ * comes back as base64 deltas that are decoded straight into the playback
+ * ring. A turn costs one round trip instead of three serial requests.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "esp_websocket_client.h"
+#include "cJSON.h"
+#include "vc_base64.h"
+#include "vc_realtime.h"
+#include "realtime_client.h"
+#include "audio_player.h"
+#include "audio_arena.h"
+#include "turn_trace.h"
+#include "../credentials.h"
+
+static const char *TAG = "realtime";
+
+#ifndef REALTIME_MODEL
+#define REALTIME_MODEL "gpt-4o-realtime-preview-2024-10-01"
+#endif
+
+#define REALTIME_URL                "wss://api.openai.com/v1/realtime?model=" REALTIME_MODEL
+#define REALTIME_VOICE              "alloy"
+#define REALTIME_INSTRUCTIONS       "You are a helpful voice assistant. Keep responses concise and conversational."
+#define REALTIME_BUFFER_SIZE        4096         // Per-direction WebSocket buffer
+#define REALTIME_SEND_TIMEOUT_MS    200          // Mic frames are dropped rather than stalling capture
+#define REALTIME_PLAYBACK_WAIT_MS   1000         // Max wait for the mic-to-speaker switch
+#define REALTIME_WRITE_TIMEOUT_MS   5000         // Max wait for room in the playback ring
+#define REALTIME_EVENT_QUEUE_LEN    8
+#define REALTIME_FRAME_SAMPLES      1024         // Larger captures are sent as several appends
+#define REALTIME_B64_CHUNK          2048         // Streamed delta characters decoded per step
+
+#define SESSION_READY_BIT   BIT0
+#define PLAYBACK_READY_BIT  BIT1
+
+static esp_websocket_client_handle_t s_client = NULL;
+static QueueHandle_t s_events = NULL;
+static EventGroupHandle_t s_state = NULL;
+static uint32_t s_sample_rate = 0;
+
+// Reassembly of server messages that arrive in several fragments
+typedef enum {
+    MSG_COLLECT,        // Copying into s_msg, dispatched once complete
+    MSG_STREAM_AUDIO,   // Audio delta: the base64 value is decoded as it arrives
+    MSG_SKIP,           // Ignore the rest of the message
+} msg_state_t;
+
+static char *s_msg = NULL;      // Arena text slab; larger server messages are skipped
+static size_t s_msg_cap = 0;
+static size_t s_msg_len = 0;
+static msg_state_t s_msg_state = MSG_COLLECT;
+
+// Audio deltas larger than one fragment never need the whole message in memory
+static vc_base64_decoder_t s_b64;
+static uint8_t s_pcm[VC_BASE64_DECODED_MAX(REALTIME_B64_CHUNK + 3)];
+
+// input_audio_buffer.append template - the prefix is written once, the capture
+// task encodes each frame's audio behind it and closes the JSON in place
+static char s_frame[VC_RT_APPEND_FRAME_SIZE(REALTIME_FRAME_SAMPLES * sizeof(int16_t))];
+
+// Per-turn state, reset by realtime_turn_begin() and otherwise owned by the WebSocket task
+static bool s_drop_audio = false;
+static int64_t s_turn_end_us = 0;
+static bool s_first_delta = false;
+static size_t s_audio_bytes = 0;
+
+// Response state - s_cancelling outlives the turn that set it, until the server confirms
+static bool s_response_active = false;      // response.created seen, response.done not yet
+static volatile bool s_cancelling = false;  // Barge-in: drop the rest of the response
+
+static void post_event(realtime_event_t event)
+{
+    if (xQueueSend(s_events, &event, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Event queue full, dropped event %d", event);
+    }
+}
+
+/**
+ * Serialize and send one client event, consuming the cJSON object
+ */
+static esp_err_t send_json(cJSON *root, int timeout_ms)
+{
+    char *text = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!text) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int sent = esp_websocket_client_send_text(s_client, text, strlen(text), pdMS_TO_TICKS(timeout_ms));
+    free(text);
+    return sent < 0 ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t send_type(const char *type)
+{
+    if (!esp_websocket_client_is_connected(s_client)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", type);
+    return send_json(root, 1000);
+}
+
+/**
+ * session.update - pcm16 both ways, server VAD, Whisper transcription for the logs
+ */
+static void send_session_update(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "type", "session.update");
+
+    cJSON *session = cJSON_AddObjectToObject(root, "session");
+    cJSON *modalities = cJSON_AddArrayToObject(session, "modalities");
+    cJSON_AddItemToArray(modalities, cJSON_CreateString("text"));
+    cJSON_AddItemToArray(modalities, cJSON_CreateString("audio"));
+    cJSON_AddStringToObject(session, "instructions", REALTIME_INSTRUCTIONS);
+    cJSON_AddStringToObject(session, "voice", REALTIME_VOICE);
+    cJSON_AddStringToObject(session, "input_audio_format", "pcm16");
+    cJSON_AddStringToObject(session, "output_audio_format", "pcm16");
+
+    cJSON *transcription = cJSON_AddObjectToObject(session, "input_audio_transcription");
+    cJSON_AddStringToObject(transcription, "model", "whisper-1");
+
+    cJSON *vad = cJSON_AddObjectToObject(session, "turn_detection");
+    cJSON_AddStringToObject(vad, "type", "server_vad");
+    cJSON_AddNumberToObject(vad, "threshold", 0.5);
+    cJSON_AddNumberToObject(vad, "prefix_padding_ms", 300);
+    cJSON_AddNumberToObject(vad, "silence_duration_ms", 500);
+
+    if (send_json(root, 5000) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send session.update");
+    }
+}
+
+/**
+ * Whether response audio should be played, waiting for the player if needed
+ */
+static bool audio_wanted(void)
+{
+    if (s_drop_audio || s_cancelling) {
+        return false;
+    }
+
+    // Deltas can beat the mic-to-speaker switch, hold them until the player is running
+    if (!(xEventGroupWaitBits(s_state, PLAYBACK_READY_BIT, pdFALSE, pdTRUE,
+                              pdMS_TO_TICKS(REALTIME_PLAYBACK_WAIT_MS)) & PLAYBACK_READY_BIT)) {
+        ESP_LOGW(TAG, "Playback not ready, dropping response audio");
+        s_drop_audio = true;
+        return false;
+    }
+    return true;
+}
+
+static void play_audio(const uint8_t *pcm, size_t pcm_len)
+{
+    if (s_drop_audio || s_cancelling || pcm_len == 0) {
+        return;  // A barge-in can land in the middle of a streamed delta
+    }
+    if (!s_first_delta) {
+        s_first_delta = true;
+        turn_trace_mark(TRACE_FIRST_TTS);
+        ESP_LOGI(TAG, "First audio delta %lld ms after end of speech",
+                 (esp_timer_get_time() - s_turn_end_us) / 1000);
+    }
+    s_audio_bytes += audio_player_write(pcm, pcm_len, pdMS_TO_TICKS(REALTIME_WRITE_TIMEOUT_MS));
+}
+
+/**
+ * Decode one complete response.audio.delta into the playback ring
+ */
+static void handle_audio_delta(char *b64, size_t b64_len)
+{
+    if (!audio_wanted()) {
+        return;
+    }
+
+    // The characters live in the reassembly buffer, so they are decoded in place
+    uint8_t *pcm = (uint8_t *)b64;
+    size_t pcm_len = vc_base64_decode(pcm, b64_len, b64, b64_len);
+    if (pcm_len != VC_BASE64_ERROR) {
+        play_audio(pcm, pcm_len);
+    } else {
+        ESP_LOGW(TAG, "Malformed audio delta (%d chars)", b64_len);
+    }
+}
+
+/**
+ * Decode the next characters of a streamed delta, up to the closing quote
+ */
+static void stream_audio_delta(const char *b64, size_t len)
+{
+    const char *close = memchr(b64, '"', len);
+    size_t remaining = close ? (size_t)(close - b64) : len;
+
+    while (remaining) {
+        size_t n = remaining < REALTIME_B64_CHUNK ? remaining : REALTIME_B64_CHUNK;
+        size_t pcm_len = vc_base64_decoder_update(&s_b64, s_pcm, sizeof(s_pcm), b64, n);
+        if (pcm_len == VC_BASE64_ERROR) {
+            ESP_LOGW(TAG, "Malformed streamed audio delta");
+            s_msg_state = MSG_SKIP;
+            return;
+        }
+        play_audio(s_pcm, pcm_len);
+        b64 += n;
+        remaining -= n;
+    }
+
+    if (close) {
+        if (!vc_base64_decoder_finish(&s_b64)) {
+            ESP_LOGW(TAG, "Streamed audio delta ended mid-group");
+        }
+        s_msg_state = MSG_SKIP;  // Only the closing brace is left
+    }
+}
+
+/**
+ * Route one complete server message
+ */
+static void handle_message(char *text, size_t len)
+{
+    // Audio deltas are most of the traffic - route them without building a DOM
+    switch (vc_rt_sniff(text, len)) {
+        case VC_RT_EVENT_AUDIO_DELTA: {
+            size_t b64_len;
+            char *b64 = (char *)vc_rt_find_string(text, len, "delta", &b64_len);
+            if (b64) {
+                handle_audio_delta(b64, b64_len);
+                return;
+            }
+            break;  // Unusual encoding, let cJSON handle it
+        }
+        case VC_RT_EVENT_AUDIO_TRANSCRIPT_DELTA:
+            turn_trace_mark(TRACE_FIRST_TOKEN);
+            return;  // The full transcript is logged from response.audio_transcript.done
+        default:
+            break;
+    }
+
+    cJSON *json = cJSON_Parse(text);
+    if (!json) {
+        ESP_LOGW(TAG, "Unparseable server message");
+        return;
+    }
+
+    cJSON *type_item = cJSON_GetObjectItem(json, "type");
+    const char *type = cJSON_IsString(type_item) ? type_item->valuestring : "";
+
+    if (strcmp(type, "response.audio.delta") == 0 || strcmp(type, "response.output_audio.delta") == 0) {
+        cJSON *delta = cJSON_GetObjectItem(json, "delta");
+        if (cJSON_IsString(delta)) {
+            handle_audio_delta(delta->valuestring, strlen(delta->valuestring));
+        }
+    } else if (strcmp(type, "response.created") == 0) {
+        s_response_active = true;
+    } else if (strcmp(type, "session.updated") == 0) {
+        ESP_LOGI(TAG, "Session configured");
+        xEventGroupSetBits(s_state, SESSION_READY_BIT);
+        post_event(REALTIME_EVENT_READY);
+    } else if (strcmp(type, "input_audio_buffer.speech_started") == 0) {
+        post_event(REALTIME_EVENT_SPEECH_STARTED);
+    } else if (strcmp(type, "input_audio_buffer.speech_stopped") == 0 ||
+               strcmp(type, "input_audio_buffer.committed") == 0) {
+        // A manual commit follows a button release, server VAD sends speech_stopped first
+        if (s_turn_end_us == 0) {
+            s_turn_end_us = esp_timer_get_time();
+            post_event(REALTIME_EVENT_SPEECH_STOPPED);
+        }
+    } else if (strcmp(type, "conversation.item.input_audio_transcription.completed") == 0) {
+        turn_trace_mark(TRACE_TRANSCRIPT);
+        cJSON *transcript = cJSON_GetObjectItem(json, "transcript");
+        if (cJSON_IsString(transcript)) {
+            ESP_LOGI(TAG, "User: %s", transcript->valuestring);
+        }
+    } else if (strcmp(type, "response.audio_transcript.done") == 0) {
+        cJSON *transcript = cJSON_GetObjectItem(json, "transcript");
+        if (cJSON_IsString(transcript)) {
+            ESP_LOGI(TAG, "Assistant: %s", transcript->valuestring);
+        }
+    } else if (strcmp(type, "response.done") == 0) {
+        s_response_active = false;
+        if (s_cancelling) {
+            // The turn it belonged to is already over
+            s_cancelling = false;
+            ESP_LOGI(TAG, "Response cancelled after %d bytes of audio", s_audio_bytes);
+        } else {
+            ESP_LOGI(TAG, "Response done, %d bytes of audio in %lld ms", s_audio_bytes,
+                     s_turn_end_us ? (esp_timer_get_time() - s_turn_end_us) / 1000 : 0);
+            post_event(REALTIME_EVENT_RESPONSE_DONE);
+        }
+    } else if (strcmp(type, "error") == 0) {
+        cJSON *error = cJSON_GetObjectItem(json, "error");
+        cJSON *message = error ? cJSON_GetObjectItem(error, "message") : NULL;
+        cJSON *code = error ? cJSON_GetObjectItem(error, "code") : NULL;
+        if (cJSON_IsString(code) && strcmp(code->valuestring, "response_cancel_not_active") == 0) {
+            // The response finished before the cancel arrived, nothing was lost
+            s_cancelling = false;
+            ESP_LOGI(TAG, "Response already done when cancelled");
+        } else {
+            ESP_LOGE(TAG, "Server error: %s", cJSON_IsString(message) ? message->valuestring : "unknown");
+            post_event(REALTIME_EVENT_ERROR);
+        }
+    }
+
+    cJSON_Delete(json);
+}
+
+/**
+ * Switch an incomplete audio delta to streaming once the start of its value is in
+ */
+static void try_stream_audio(void)
+{
+    if (vc_rt_sniff(s_msg, s_msg_len) != VC_RT_EVENT_AUDIO_DELTA) {
+        return;
+    }
+    const char *value = vc_rt_find_string_start(s_msg, s_msg_len, "delta");
+    if (!value) {
+        return;  // Keep collecting the head
+    }
+
+    s_msg_state = MSG_STREAM_AUDIO;
+    vc_base64_decoder_init(&s_b64);
+    audio_arena_note(AUDIO_SLAB_TEXT, s_msg_len + 1);
+    audio_wanted();     // The wait for the player happens once per delta, not per piece
+    stream_audio_delta(value, (size_t)(s_msg + s_msg_len - value));
+}
+
+/**
+ * Streaming receive callback: collect or decode each fragment straight from the rx buffer
+ */
+static void handle_fragment(const esp_websocket_fragment_t *fragment, void *user_context)
+{
+    if (fragment->op_code != WS_TRANSPORT_OPCODES_TEXT) {
+        return;  // The Realtime API only sends text
+    }
+    if (fragment->message_offset == 0) {
+        s_msg_len = 0;
+        s_msg_state = MSG_COLLECT;
+    }
+
+    bool message_done = fragment->fin && fragment->payload_offset + fragment->data_len >= fragment->payload_len;
+    switch (s_msg_state) {
+        case MSG_COLLECT:
+            if (s_msg_len + fragment->data_len >= s_msg_cap) {
+                ESP_LOGW(TAG, "Server message larger than %d bytes, skipped", s_msg_cap);
+                s_msg_state = MSG_SKIP;
+                break;
+            }
+            memcpy(s_msg + s_msg_len, fragment->data_ptr, fragment->data_len);
+            s_msg_len += fragment->data_len;
+            if (!message_done) {
+                try_stream_audio();
+            }
+            break;
+        case MSG_STREAM_AUDIO:
+            stream_audio_delta(fragment->data_ptr, fragment->data_len);
+            break;
+        case MSG_SKIP:
+            break;
+    }
+
+    if (message_done) {
+        if (s_msg_state == MSG_COLLECT) {
+            s_msg[s_msg_len] = '\0';
+            audio_arena_note(AUDIO_SLAB_TEXT, s_msg_len + 1);
+            handle_message(s_msg, s_msg_len);
+        } else if (s_msg_state == MSG_STREAM_AUDIO) {
+            ESP_LOGW(TAG, "Audio delta ended inside its value");
+        }
+        s_msg_len = 0;
+        s_msg_state = MSG_COLLECT;
+    }
+}
+
+static void websocket_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    esp_websocket_event_data_t *data = (esp_websocket_event_data_t *)event_data;
+
+    switch (event_id) {
+        case WEBSOCKET_EVENT_CONNECTED:
+            ESP_LOGI(TAG, "Connected to Realtime API, configuring session...");
+            s_msg_len = 0;
+            s_msg_state = MSG_COLLECT;
+            send_session_update();
+            break;
+        case WEBSOCKET_EVENT_DISCONNECTED:
+            ESP_LOGW(TAG, "Disconnected from Realtime API");
+            xEventGroupClearBits(s_state, SESSION_READY_BIT);
+            s_response_active = false;  // A new session has no response to cancel
+            s_cancelling = false;
+            post_event(REALTIME_EVENT_DISCONNECTED);
+            break;
+        case WEBSOCKET_EVENT_DATA:
+            break;  // Only control frames, text arrives through handle_fragment()
+        case WEBSOCKET_EVENT_ERROR:
+            ESP_LOGE(TAG, "WebSocket error (handshake status %d)", data->error_handle.esp_ws_handshake_status_code);
+            break;
+        default:
+            break;
+    }
+}
+
+esp_err_t realtime_init(uint32_t sample_rate)
+{
+    if (s_client) {
+        return ESP_OK;
+    }
+    s_sample_rate = sample_rate;
+
+    vc_rt_append_init(s_frame);
+
+    s_msg = audio_arena_slab(AUDIO_SLAB_TEXT, &s_msg_cap);
+    s_events = xQueueCreate(REALTIME_EVENT_QUEUE_LEN, sizeof(realtime_event_t));
+    s_state = xEventGroupCreate();
+    if (!s_msg || !s_events || !s_state) {
+        ESP_LOGE(TAG, "Failed to allocate Realtime client state");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_websocket_client_config_t config = {
+        .uri = REALTIME_URL,
+        .headers = "Authorization: Bearer " OPENAI_API_KEY "\r\n"
+                   "OpenAI-Beta: realtime=v1\r\n",
+        .crt_bundle_attach = esp_crt_bundle_attach,
+        .buffer_size = REALTIME_BUFFER_SIZE,
+        .task_stack = 6144,
+        .task_prio = 11,     // Between capture (10) and playback (12)
+        .reconnect_timeout_ms = 5000,
+        .network_timeout_ms = 10000,
+        .ping_interval_sec = 20,
+        .keep_alive_enable = true,
+        .data_cb = handle_fragment,
+    };
+
+    s_client = esp_websocket_client_init(&config);
+    if (!s_client) {
+        ESP_LOGE(TAG, "Failed to create WebSocket client");
+        return ESP_ERR_NO_MEM;
+    }
+    esp_websocket_register_events(s_client, WEBSOCKET_EVENT_ANY, websocket_event_handler, NULL);
+
+    esp_err_t err = esp_websocket_client_start(s_client);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start WebSocket client: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Connecting to %s (%lu Hz pcm16)", REALTIME_URL, s_sample_rate);
+    return ESP_OK;
+}
+
+BaseType_t realtime_get_event(realtime_event_t *event, TickType_t timeout)
+{
+    if (!s_events) {
+        return pdFALSE;
+    }
+    return xQueueReceive(s_events, event, timeout);
+}
+
+esp_err_t realtime_turn_begin(void)
+{
+    if (!(xEventGroupGetBits(s_state) & SESSION_READY_BIT)) {
+        ESP_LOGW(TAG, "Session not ready");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xEventGroupClearBits(s_state, PLAYBACK_READY_BIT);
+    s_drop_audio = false;
+    s_turn_end_us = 0;
+    s_first_delta = false;
+    s_audio_bytes = 0;
+
+    // Leftovers from an abandoned turn would be prepended to this one
+    return send_type("input_audio_buffer.clear");
+}
+
+esp_err_t realtime_send_audio(const int16_t *samples, size_t sample_count)
+{
+    if (!(xEventGroupGetBits(s_state) & SESSION_READY_BIT)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = ESP_OK;
+    while (sample_count && err == ESP_OK) {
+        size_t n = sample_count < REALTIME_FRAME_SAMPLES ? sample_count : REALTIME_FRAME_SAMPLES;
+        size_t frame_len = vc_rt_append_fill(s_frame, sizeof(s_frame), samples, n * sizeof(int16_t));
+
+        // Header and masked payload are built in the client's tx buffer and leave as one record
+        esp_websocket_iov_t seg = { .data = s_frame, .len = frame_len };
+        if (esp_websocket_client_send_iov(s_client, WS_TRANSPORT_OPCODES_TEXT, &seg, 1,
+                                          pdMS_TO_TICKS(REALTIME_SEND_TIMEOUT_MS)) < 0) {
+            err = ESP_FAIL;
+            ESP_LOGW(TAG, "Dropped %d-sample mic frame", n);
+        } else {
+            turn_trace_mark(TRACE_FIRST_UPLOAD);
+        }
+        samples += n;
+        sample_count -= n;
+    }
+    return err;
+}
+
+esp_err_t realtime_turn_commit(void)
+{
+    if (s_turn_end_us == 0) {
+        s_turn_end_us = esp_timer_get_time();
+    }
+    esp_err_t err = send_type("input_audio_buffer.commit");
+    if (err == ESP_OK) {
+        err = send_type("response.create");
+    }
+    return err;
+}
+
+esp_err_t realtime_turn_cancel(void)
+{
+    return send_type("input_audio_buffer.clear");
+}
+
+esp_err_t realtime_response_cancel(void)
+{
+    if (!s_response_active) {
+        return ESP_OK;  // Fully received, only local playback was left
+    }
+    s_cancelling = true;
+    return send_type("response.cancel");
+}
+
+void realtime_playback_ready(void)
+{
+    xEventGroupSetBits(s_state, PLAYBACK_READY_BIT);
+}
@@ -0,0 +1,96 @@
+/**
+ * OpenAI Realtime API client
+ * One WebSocket carries mic audio up and response audio down, turn
+ * boundaries come from server-side VAD
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Session events reported to the application
+ */
+typedef enum {
+    REALTIME_EVENT_READY,           /*!< Session configured, audio can be sent */
+    REALTIME_EVENT_SPEECH_STARTED,  /*!< Server VAD heard the user start talking */
+    REALTIME_EVENT_SPEECH_STOPPED,  /*!< Server VAD committed the turn, a response follows */
+    REALTIME_EVENT_RESPONSE_DONE,   /*!< Last audio delta of the response has been queued */
+    REALTIME_EVENT_ERROR,           /*!< Server reported an error for the current turn */
+    REALTIME_EVENT_DISCONNECTED,    /*!< WebSocket dropped, the client reconnects on its own */
+} realtime_event_t;
+
+/**
+ * @brief Connect to the Realtime API and configure the session (call once Wi-Fi is up)
+ *
+ * Audio deltas are decoded straight into audio_player, so audio_player_init()
+ * must have been called with the same sample rate. Server messages are
+ * reassembled in the arena's text slab, which sets the largest message kept.
+ *
+ * @param[in] sample_rate Sample rate of the PCM16 audio in both directions (24000 for pcm16)
+ * @return
+ *      - ESP_OK: Client started, REALTIME_EVENT_READY follows once the session is configured
+ *      - ESP_ERR_NO_MEM: Client, queue or buffers could not be allocated
+ */
+esp_err_t realtime_init(uint32_t sample_rate);
+
+/**
+ * @brief Wait for the next session event
+ *
+ * @return pdTRUE if an event was received before the timeout
+ */
+BaseType_t realtime_get_event(realtime_event_t *event, TickType_t timeout);
+
+/**
+ * @brief Start a user turn - clears any audio the server has buffered
+ *        and holds incoming response audio until playback is ready
+ */
+esp_err_t realtime_turn_begin(void);
+
+/**
+ * @brief Append captured mic samples to the server's input buffer
+ *
+ * @return ESP_OK, or ESP_FAIL if the frame could not be sent in time
+ */
+esp_err_t realtime_send_audio(const int16_t *samples, size_t sample_count);
+
+/**
+ * @brief End the turn manually (button released before server VAD did)
+ *
+ * Commits the input buffer and requests a response.
+ */
+esp_err_t realtime_turn_commit(void);
+
+/**
+ * @brief Drop the turn without a response (nothing was said)
+ */
+esp_err_t realtime_turn_cancel(void);
+
+/**
+ * @brief Stop the response being generated (barge-in)
+ *
+ * Sends response.cancel if the server is still producing the response.
+ * Audio deltas of that response still in flight are dropped, and its
+ * response.done does not raise REALTIME_EVENT_RESPONSE_DONE, so the next
+ * turn can begin immediately.
+ */
+esp_err_t realtime_response_cancel(void);
+
+/**
+ * @brief Tell the client the speaker is up and audio_player_begin() has been called
+ *
+ * Response audio that arrived during the mic-to-speaker switch is released
+ * to the player once this is called.
+ */
+void realtime_playback_ready(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,180 @@
+/**
+ * Status LED
+ *
+ * Turn and link state changes happen on the turn task, the recording task
+ * and the Wi-Fi event loop, none of which should wait ~100 us per colour
+ * for an RMT transfer, let alone animate. They post {colour, effect} into
+ * a one-slot queue with xQueueOverwrite() instead, and this task shows
+ * the latest one: once for a solid colour, every frame for an effect.
+ * States that were replaced before the task got to them are never shown,
+ * which is what matters for a status light.
+ *
+ * The task is the only RMT user, so it can wait for each transfer to end
+ * before reusing the pixel buffer.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/rmt_tx.h"
+#include "led_strip_encoder.h"
+#include "status_led.h"
+
+static const char *TAG = "status_led";
+
+#define LED_RMT_RESOLUTION_HZ   10000000    // 1 tick = 0.1 us
+#define LED_FRAME_MS            20          // Animation frame period
+#define LED_TX_TIMEOUT_MS       100
+#define BREATHE_PERIOD_MS       2000
+#define BREATHE_FLOOR_Q8        24          // Never quite off, so it does not look like a fault
+#define LEVEL_FLOOR_Q8          48          // Dim but visible while the room is quiet
+#define LEVEL_FULL              2048        // Mean absolute sample that lights it fully (close speech)
+
+typedef struct {
+    status_led_color_t color;
+    status_led_effect_t effect;
+} led_state_t;
+
+static rmt_channel_handle_t s_chan = NULL;
+static rmt_encoder_handle_t s_encoder = NULL;
+static QueueHandle_t s_queue = NULL;
+static volatile uint16_t s_level = 0;
+
+static void show(status_led_color_t color)
+{
+    static uint8_t pixel[3];    // Read by the RMT driver until the transfer is done
+
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
+    pixel[0] = color.g;
+    pixel[1] = color.r;
+    pixel[2] = color.b;
+    if (rmt_transmit(s_chan, s_encoder, pixel, sizeof(pixel), &tx_config) == ESP_OK) {
+        rmt_tx_wait_all_done(s_chan, LED_TX_TIMEOUT_MS);
+    }
+}
+
+static status_led_color_t scale(status_led_color_t color, uint32_t q8)
+{
+    status_led_color_t out = {
+        .g = (uint8_t)(color.g * q8 >> 8),
+        .r = (uint8_t)(color.r * q8 >> 8),
+        .b = (uint8_t)(color.b * q8 >> 8),
+    };
+    return out;
+}
+
+/**
+ * Brightness of a breathing frame: a squared triangle, so the LED lingers dim
+ * and swells quickly, which reads as smoother than a linear ramp
+ */
+static uint32_t breathe_q8(int64_t elapsed_ms)
+{
+    uint32_t phase = (uint32_t)(elapsed_ms % BREATHE_PERIOD_MS) * 512 / BREATHE_PERIOD_MS;
+    uint32_t tri = phase < 256 ? phase : 511 - phase;
+    return BREATHE_FLOOR_Q8 + (256 - BREATHE_FLOOR_Q8) * (tri * tri) / (255 * 255);
+}
+
+/**
+ * Brightness of a level-meter frame: jumps up with the mic level, falls back
+ * by an eighth per frame, so syllables show as pulses
+ */
+static uint32_t level_q8(uint16_t *meter)
+{
+    uint16_t level = s_level;
+    *meter = level > *meter ? level : *meter - (*meter >> 3);
+    uint32_t clipped = *meter < LEVEL_FULL ? *meter : LEVEL_FULL;
+    return LEVEL_FLOOR_Q8 + (256 - LEVEL_FLOOR_Q8) * clipped / LEVEL_FULL;
+}
+
+static void led_task(void *arg)
+{
+    led_state_t state = { .effect = STATUS_LED_SOLID };
+    status_led_color_t shown = { 0 };
+    int64_t effect_start_ms = 0;
+    uint16_t meter = 0;
+
+    show(shown);
+    while (1) {
+        TickType_t wait = state.effect == STATUS_LED_SOLID ? portMAX_DELAY : pdMS_TO_TICKS(LED_FRAME_MS);
+        led_state_t next;
+        if (xQueueReceive(s_queue, &next, wait) == pdTRUE) {
+            if (next.effect != state.effect) {
+                effect_start_ms = esp_timer_get_time() / 1000;
+                meter = 0;
+            }
+            state = next;
+        }
+
+        status_led_color_t color = state.color;
+        if (state.effect == STATUS_LED_BREATHE) {
+            color = scale(state.color, breathe_q8(esp_timer_get_time() / 1000 - effect_start_ms));
+        } else if (state.effect == STATUS_LED_LEVEL) {
+            color = scale(state.color, level_q8(&meter));
+        }
+        if (memcmp(&color, &shown, sizeof(color)) != 0) {
+            show(color);
+            shown = color;
+        }
+    }
+}
+
+esp_err_t status_led_init(const status_led_config_t *config)
+{
+    if (s_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "SK6812 on GPIO %d", config->gpio);
+
+    rmt_tx_channel_config_t tx_chan_config = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .gpio_num = config->gpio,
+        .mem_block_symbols = 64,
+        .resolution_hz = LED_RMT_RESOLUTION_HZ,
+        .trans_queue_depth = 4,
+    };
+    esp_err_t err = rmt_new_tx_channel(&tx_chan_config, &s_chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+    led_strip_encoder_config_t encoder_config = {
+        .resolution = LED_RMT_RESOLUTION_HZ,
+    };
+    err = rmt_new_led_strip_encoder(&encoder_config, &s_encoder);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = rmt_enable(s_chan);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    s_queue = xQueueCreate(1, sizeof(led_state_t));
+    if (!s_queue) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(led_task, "led_task", 2048, NULL, config->priority, NULL,
+                                config->core) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create LED task");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void status_led_set(status_led_color_t color, status_led_effect_t effect)
+{
+    if (!s_queue) {
+        return;     // Not initialized yet
+    }
+    led_state_t state = { .color = color, .effect = effect };
+    xQueueOverwrite(s_queue, &state);
+}
+
+void status_led_level(uint16_t level)
+{
+    s_level = level;
+}
@@ -0,0 +1,64 @@
+/**
+ * Status LED
+ * The SK6812 driven from its own task: callers post the state they want
+ * and return, animations run without anyone waiting on the RMT transfer
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Colour in the LED's own GRB byte order
+ */
+typedef struct {
+    uint8_t g;
+    uint8_t r;
+    uint8_t b;
+} status_led_color_t;
+
+typedef enum {
+    STATUS_LED_SOLID = 0,   /*!< Steady colour */
+    STATUS_LED_BREATHE,     /*!< Slow fade in and out (working on it) */
+    STATUS_LED_LEVEL,       /*!< Brightness follows status_led_level() (mic open) */
+} status_led_effect_t;
+
+typedef struct {
+    int gpio;
+    UBaseType_t priority;   /*!< Low: a late animation frame does no harm */
+    BaseType_t core;
+} status_led_config_t;
+
+/**
+ * @brief Create the RMT channel and encoder and start the LED task (LED off)
+ *
+ * @return
+ *      - ESP_OK: Running
+ *      - ESP_ERR_INVALID_STATE: Already initialized
+ *      - ESP_ERR_NO_MEM: Queue or task could not be created
+ *      - Others: RMT driver errors
+ */
+esp_err_t status_led_init(const status_led_config_t *config);
+
+/**
+ * @brief Show a colour and effect from now on
+ *
+ * Never blocks: the LED task has one slot and a newer state replaces one
+ * it has not picked up yet. Safe from any task, a no-op before init.
+ */
+void status_led_set(status_led_color_t color, status_led_effect_t effect);
+
+/**
+ * @brief Latest mic level (mean absolute sample) for STATUS_LED_LEVEL
+ */
+void status_led_level(uint16_t level);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,363 @@
+/**
+ * Turn latency tracing
+ *
+ * "The assistant feels slow" could mean Wi-Fi, the TLS handshake, Whisper,
+ * the model, the TTS download or playback. Each stage boundary of a turn is
+ * timestamped with esp_timer, and the last TRACE_WINDOW turns are kept so
+ * a histogram of every stage is available on demand: percentiles over
+ * serial after each turn, Prometheus buckets on /metrics for the fleet
+ * scraper. The stages up to the release are timed from the start of the
+ * turn, everything after it from the release - the wait the user hears.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_http_server.h"
+#include "turn_trace.h"
+
+static const char *TAG = "turn_trace";
+
+#define TRACE_WINDOW        32      // Turns kept for the histograms
+#define TRACE_MAX_TASKS     8
+#define TRACE_UNSET         (-1)
+
+static const char *const stage_names[TRACE_STAGE_COUNT] = {
+    [TRACE_RELEASE]      = "release",
+    [TRACE_FIRST_UPLOAD] = "first_upload",
+    [TRACE_TRANSCRIPT]   = "transcript",
+    [TRACE_FIRST_TOKEN]  = "first_token",
+    [TRACE_FIRST_TTS]    = "first_tts",
+    [TRACE_FIRST_SAMPLE] = "first_sample",
+    [TRACE_PLAYBACK_END] = "playback_end",
+};
+
+// Stages timed from the start of the turn rather than from the release
+#define TIMED_FROM_BEGIN(stage) ((stage) == TRACE_RELEASE || (stage) == TRACE_FIRST_UPLOAD)
+
+// Histogram bucket bounds in ms (Prometheus "le"), +Inf is implied
+static const int32_t bucket_ms[] = { 50, 100, 250, 500, 1000, 2000, 4000, 8000 };
+#define BUCKET_COUNT (sizeof(bucket_ms) / sizeof(bucket_ms[0]))
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Current turn
+static bool s_active = false;
+static bool s_failed = false;
+static int64_t s_begin_us = 0;
+static int64_t s_marks_us[TRACE_STAGE_COUNT];
+
+// Completed turns, stage durations in ms (TRACE_UNSET where a stage never happened)
+static int32_t s_window[TRACE_WINDOW][TRACE_STAGE_COUNT];
+static int s_window_head = 0;
+static int s_window_count = 0;
+static uint32_t s_turns = 0;
+static uint32_t s_turns_failed = 0;
+
+// Wake word detections, latency in ms (same window length, its own ring)
+static int32_t s_wake_window[TRACE_WINDOW];
+static int s_wake_head = 0;
+static int s_wake_count = 0;
+static uint32_t s_wakes = 0;
+static int32_t s_wake_load = TRACE_UNSET;   // Permille
+
+static TaskHandle_t s_tasks[TRACE_MAX_TASKS];
+static int s_task_count = 0;
+
+static httpd_handle_t s_server = NULL;
+
+void turn_trace_begin(void)
+{
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&s_lock);
+    s_active = true;
+    s_failed = false;
+    s_begin_us = now;
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        s_marks_us[i] = 0;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void turn_trace_mark(trace_stage_t stage)
+{
+    int64_t now = esp_timer_get_time();
+    taskENTER_CRITICAL(&s_lock);
+    if (s_active && s_marks_us[stage] == 0) {
+        s_marks_us[stage] = now;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void turn_trace_fail(void)
+{
+    s_failed = true;
+}
+
+void turn_trace_end(void)
+{
+    int32_t row[TRACE_STAGE_COUNT];
+
+    taskENTER_CRITICAL(&s_lock);
+    if (!s_active) {
+        taskEXIT_CRITICAL(&s_lock);
+        return;
+    }
+    s_active = false;
+
+    int64_t release_us = s_marks_us[TRACE_RELEASE];
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        int64_t from_us = TIMED_FROM_BEGIN(i) ? s_begin_us : release_us;
+        if (s_marks_us[i] == 0 || from_us == 0 || s_marks_us[i] < from_us) {
+            row[i] = TRACE_UNSET;
+        } else {
+            row[i] = (int32_t)((s_marks_us[i] - from_us) / 1000);
+        }
+    }
+
+    memcpy(s_window[s_window_head], row, sizeof(row));
+    s_window_head = (s_window_head + 1) % TRACE_WINDOW;
+    if (s_window_count < TRACE_WINDOW) {
+        s_window_count++;
+    }
+    s_turns++;
+    if (s_failed) {
+        s_turns_failed++;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+
+    char line[160];
+    int len = snprintf(line, sizeof(line), "Turn %lu%s:", (unsigned long)s_turns, s_failed ? " (failed)" : "");
+    for (int i = 0; i < TRACE_STAGE_COUNT && len < (int)sizeof(line); i++) {
+        if (row[i] != TRACE_UNSET) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %s%ld", stage_names[i],
+                            TIMED_FROM_BEGIN(i) ? "" : "+", (long)row[i]);
+        }
+    }
+    ESP_LOGI(TAG, "%s ms", line);
+}
+
+void turn_trace_wake(int32_t latency_ms)
+{
+    taskENTER_CRITICAL(&s_lock);
+    s_wake_window[s_wake_head] = latency_ms < 0 ? 0 : latency_ms;
+    s_wake_head = (s_wake_head + 1) % TRACE_WINDOW;
+    if (s_wake_count < TRACE_WINDOW) {
+        s_wake_count++;
+    }
+    s_wakes++;
+    taskEXIT_CRITICAL(&s_lock);
+}
+
+void turn_trace_wake_load(uint16_t permille)
+{
+    s_wake_load = permille;
+}
+
+void turn_trace_watch_task(TaskHandle_t task)
+{
+    if (task && s_task_count < TRACE_MAX_TASKS) {
+        s_tasks[s_task_count++] = task;
+    }
+}
+
+/**
+ * Insertion sort: at most TRACE_WINDOW values
+ */
+static void sort_samples(int32_t *out, int n)
+{
+    for (int i = 1; i < n; i++) {
+        int32_t v = out[i];
+        int j = i - 1;
+        for (; j >= 0 && out[j] > v; j--) {
+            out[j + 1] = out[j];
+        }
+        out[j + 1] = v;
+    }
+}
+
+/**
+ * One stage's durations over the window, sorted (returns the count)
+ */
+static int stage_samples(trace_stage_t stage, int32_t *out)
+{
+    int n = 0;
+    taskENTER_CRITICAL(&s_lock);
+    for (int t = 0; t < s_window_count; t++) {
+        if (s_window[t][stage] != TRACE_UNSET) {
+            out[n++] = s_window[t][stage];
+        }
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    sort_samples(out, n);
+    return n;
+}
+
+/**
+ * Wake word latencies over the window, sorted (returns the count)
+ */
+static int wake_samples(int32_t *out)
+{
+    taskENTER_CRITICAL(&s_lock);
+    int n = s_wake_count;
+    memcpy(out, s_wake_window, n * sizeof(int32_t));
+    taskEXIT_CRITICAL(&s_lock);
+    sort_samples(out, n);
+    return n;
+}
+
+void turn_trace_log_stats(void)
+{
+    int32_t samples[TRACE_WINDOW];
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        int n = stage_samples(i, samples);
+        if (n == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-12s %s p50 %5ld  p90 %5ld  max %5ld ms (%d turns)", stage_names[i],
+                 TIMED_FROM_BEGIN(i) ? "from start  " : "from release",
+                 (long)samples[n / 2], (long)samples[n * 9 / 10], (long)samples[n - 1], n);
+    }
+
+    int n = wake_samples(samples);
+    if (n > 0) {
+        ESP_LOGI(TAG, "  %-12s %s p50 %5ld  p90 %5ld  max %5ld ms (%d detections)", "wake_word", "from word end",
+                 (long)samples[n / 2], (long)samples[n * 9 / 10], (long)samples[n - 1], n);
+    }
+    if (s_wake_load != TRACE_UNSET) {
+        ESP_LOGI(TAG, "  wake word CPU %ld.%ld%%", (long)(s_wake_load / 10), (long)(s_wake_load % 10));
+    }
+
+    ESP_LOGI(TAG, "  heap: %d free, %d minimum, %d largest block (internal)",
+             heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+             heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+    for (int i = 0; i < s_task_count; i++) {
+        ESP_LOGI(TAG, "  %-16s %5d bytes of stack never used", pcTaskGetName(s_tasks[i]),
+                 uxTaskGetStackHighWaterMark(s_tasks[i]));
+    }
+}
+
+/**
+ * printf into one chunk of the response
+ */
+static esp_err_t metrics_printf(httpd_req_t *req, const char *format, ...)
+{
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+    }
+    return httpd_resp_send_chunk(req, line, len);
+}
+
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+
+    metrics_printf(req, "# HELP voice_stage_ms Turn stage latency over the last %d turns "
+                   "(release and first_upload from turn start, the rest from release)\n", TRACE_WINDOW);
+    metrics_printf(req, "# TYPE voice_stage_ms histogram\n");
+    int32_t samples[TRACE_WINDOW];
+    for (int i = 0; i < TRACE_STAGE_COUNT; i++) {
+        int n = stage_samples(i, samples);
+        int below = 0;
+        int64_t sum = 0;
+        for (int b = 0; b < (int)BUCKET_COUNT; b++) {
+            for (; below < n && samples[below] <= bucket_ms[b]; below++) {
+                sum += samples[below];
+            }
+            metrics_printf(req, "voice_stage_ms_bucket{stage=\"%s\",le=\"%ld\"} %d\n",
+                           stage_names[i], (long)bucket_ms[b], below);
+        }
+        for (; below < n; below++) {
+            sum += samples[below];
+        }
+        metrics_printf(req, "voice_stage_ms_bucket{stage=\"%s\",le=\"+Inf\"} %d\n", stage_names[i], n);
+        metrics_printf(req, "voice_stage_ms_sum{stage=\"%s\"} %lld\n", stage_names[i], sum);
+        metrics_printf(req, "voice_stage_ms_count{stage=\"%s\"} %d\n", stage_names[i], n);
+    }
+
+    metrics_printf(req, "# TYPE voice_turns_total counter\nvoice_turns_total %lu\n", (unsigned long)s_turns);
+    metrics_printf(req, "# TYPE voice_turns_failed_total counter\nvoice_turns_failed_total %lu\n",
+                   (unsigned long)s_turns_failed);
+
+    if (s_wake_load != TRACE_UNSET) {
+        // Only with the wake word spotter running
+        metrics_printf(req, "# HELP voice_wake_latency_ms End of the wake word to its detection, last %d\n"
+                       "# TYPE voice_wake_latency_ms histogram\n", TRACE_WINDOW);
+        int n = wake_samples(samples);
+        int below = 0;
+        int64_t sum = 0;
+        for (int b = 0; b < (int)BUCKET_COUNT; b++) {
+            for (; below < n && samples[below] <= bucket_ms[b]; below++) {
+                sum += samples[below];
+            }
+            metrics_printf(req, "voice_wake_latency_ms_bucket{le=\"%ld\"} %d\n", (long)bucket_ms[b], below);
+        }
+        for (; below < n; below++) {
+            sum += samples[below];
+        }
+        metrics_printf(req, "voice_wake_latency_ms_bucket{le=\"+Inf\"} %d\n", n);
+        metrics_printf(req, "voice_wake_latency_ms_sum %lld\nvoice_wake_latency_ms_count %d\n", sum, n);
+        metrics_printf(req, "# TYPE voice_wake_detections_total counter\nvoice_wake_detections_total %lu\n",
+                       (unsigned long)s_wakes);
+        metrics_printf(req, "# HELP voice_wake_cpu_ratio Wake word task busy time per second of audio\n"
+                       "# TYPE voice_wake_cpu_ratio gauge\nvoice_wake_cpu_ratio %ld.%03ld\n",
+                       (long)(s_wake_load / 1000), (long)(s_wake_load % 1000));
+    }
+
+    metrics_printf(req, "# TYPE voice_heap_free_bytes gauge\nvoice_heap_free_bytes %d\n",
+                   heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    metrics_printf(req, "# TYPE voice_heap_min_free_bytes gauge\nvoice_heap_min_free_bytes %d\n",
+                   heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+    metrics_printf(req, "# TYPE voice_heap_largest_block_bytes gauge\nvoice_heap_largest_block_bytes %d\n",
+                   heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+
+    metrics_printf(req, "# HELP voice_task_stack_unused_bytes Stack high-water mark (least free ever)\n"
+                   "# TYPE voice_task_stack_unused_bytes gauge\n");
+    for (int i = 0; i < s_task_count; i++) {
+        metrics_printf(req, "voice_task_stack_unused_bytes{task=\"%s\"} %d\n", pcTaskGetName(s_tasks[i]),
+                       uxTaskGetStackHighWaterMark(s_tasks[i]));
+    }
+
+    metrics_printf(req, "# TYPE voice_uptime_seconds gauge\nvoice_uptime_seconds %lld\n",
+                   esp_timer_get_time() / 1000000);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t turn_trace_start_server(uint16_t port)
+{
+    if (s_server) {
+        return ESP_OK;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = port;
+    config.max_open_sockets = 2;    // One scraper at a time is plenty
+    config.max_uri_handlers = 1;
+    config.task_priority = 2;       // Below every audio task
+
+    esp_err_t err = httpd_start(&s_server, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start metrics server: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    static const httpd_uri_t metrics_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_handler,
+    };
+    httpd_register_uri_handler(s_server, &metrics_uri);
+    ESP_LOGI(TAG, "Metrics on http://<device>:%u/metrics", port);
+    return ESP_OK;
+}
@@ -0,0 +1,82 @@
+/**
+ * Turn latency tracing
+ * Stage timestamps per turn, a rolling window of recent turns, heap and
+ * stack watermarks - logged over serial and served as /metrics
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    TRACE_RELEASE = 0,      /*!< Recording stopped (button released or end of speech) */
+    TRACE_FIRST_UPLOAD,     /*!< First request byte written upstream (after DNS, TCP and TLS) */
+    TRACE_TRANSCRIPT,       /*!< Transcription received */
+    TRACE_FIRST_TOKEN,      /*!< First reply text from the model */
+    TRACE_FIRST_TTS,        /*!< First reply audio byte received */
+    TRACE_FIRST_SAMPLE,     /*!< First reply sample written to I2S */
+    TRACE_PLAYBACK_END,     /*!< Reply finished playing */
+    TRACE_STAGE_COUNT,
+} trace_stage_t;
+
+/**
+ * @brief Start tracing a turn (recording has just started)
+ */
+void turn_trace_begin(void);
+
+/**
+ * @brief Timestamp a stage of the current turn (any task, only the first mark counts)
+ *
+ * Marks outside a turn (e.g. the boot prompt) are ignored.
+ */
+void turn_trace_mark(trace_stage_t stage);
+
+/**
+ * @brief Count the current turn as failed
+ */
+void turn_trace_fail(void);
+
+/**
+ * @brief Close the current turn: add it to the window and log its stages
+ */
+void turn_trace_end(void);
+
+/**
+ * @brief Report the stack high-water mark of a task (up to 8 tasks)
+ */
+void turn_trace_watch_task(TaskHandle_t task);
+
+/**
+ * @brief Count a wake word detection, latency_ms after the word ended (any task)
+ */
+void turn_trace_wake(int32_t latency_ms);
+
+/**
+ * @brief Wake word task CPU use over its last second of audio, in permille
+ */
+void turn_trace_wake_load(uint16_t permille);
+
+/**
+ * @brief Log percentiles of every stage over the window, heap and stack watermarks
+ */
+void turn_trace_log_stats(void);
+
+/**
+ * @brief Serve GET /metrics (Prometheus text format) on port
+ *
+ * @return
+ *      - ESP_OK: Server started
+ *      - Others: httpd_start() failed
+ */
+esp_err_t turn_trace_start_server(uint16_t port);
+
+#ifdef __cplusplus
+}
+#endif
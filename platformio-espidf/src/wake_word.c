@@ -0,0 +1,427 @@
+/**
+ * Wake word
+ *
+ * Hands-free mode on its own starts a turn on any speech, and the only
+ * alternative that needs no button, the Realtime server VAD, would keep
+ * the mic streaming to the cloud. Here the capture task copies what it
+ * hears between turns into a small ring (it never waits on this module),
+ * and a low-priority task converts it to 16 kHz, runs the MFCC front end
+ * and the keyword spotter (vc_mfcc, vc_kws) and reports a match with
+ * where the word ended, so the turn can begin right after it.
+ *
+ * Nothing is trained off the device: wake_word_enroll() turns the next
+ * three utterances into the examples, segmented by a VAD of their own,
+ * and the match threshold follows from how much those takes differ.
+ * Examples and threshold live in NVS.
+ *
+ * Detection latency (end of the word to the report: ring, the spotter's
+ * confirmation frames and processing) and the task's CPU use go to
+ * turn_trace for the log and /metrics.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/stream_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "vc_kws.h"
+#include "vc_mfcc.h"
+#include "vc_resample.h"
+#include "vc_vad.h"
+#include "mem_policy.h"
+#include "turn_trace.h"
+#include "wake_word.h"
+
+static const char *TAG = "wake_word";
+
+#define WAKE_RATE           16000
+#define WAKE_NVS_NAMESPACE  "wake_word"
+#define WAKE_NVS_KEY        "examples"
+#define WAKE_STORE_VERSION  1
+#define WAKE_RING_BYTES     4096    // ~85 ms at 24 kHz, the task keeps up with real time
+#define WAKE_READ_SAMPLES   256
+#define WAKE_CONFIRM_FRAMES 5       // 50 ms without a closer match
+#define WAKE_LEAD_IN_FRAMES 10      // Before VAD confirms a take (its onset time and a little)
+#define WAKE_TAKE_HANGOVER  300     // ms of silence that end a take
+#define WAKE_TAKE_TAIL      5       // Frames of that silence kept
+#define WAKE_LOAD_PERIOD_S  1       // CPU use is reported per second of audio
+
+// What NVS keeps
+typedef struct {
+    uint32_t version;
+    uint16_t threshold;
+    uint16_t count;
+    vc_kws_example_t examples[VC_KWS_MAX_EXAMPLES];
+} wake_store_t;
+
+// Wake task state, allocated once
+typedef struct {
+    vc_resampler_t resampler;
+    vc_mfcc_t mfcc;
+    vc_kws_t kws;
+    vc_vad_t vad;                   // Enrollment only
+    int8_t lead_in[WAKE_LEAD_IN_FRAMES][VC_KWS_DIM];
+    int lead_in_head;
+    int lead_in_count;
+    bool enrolling;
+    bool in_take;
+    int taken;
+    uint32_t frames;                // Since the last restart
+    uint32_t consumed;              // Input samples since the last restart
+} wake_state_t;
+
+static wake_word_config_t s_config;
+static wake_state_t *s_state = NULL;
+static wake_store_t *s_store = NULL;
+static StreamBufferHandle_t s_ring = NULL;
+static StaticStreamBuffer_t s_ring_struct;
+static TaskHandle_t s_task = NULL;
+
+static volatile bool s_enrolled = false;
+static volatile bool s_enroll_requested = false;
+static volatile uint32_t s_generation = 0;      // Bumped by wake_word_listen()
+
+// Feeding side: position and time of the newest sample
+static portMUX_TYPE s_feed_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t s_fed = 0;
+static int64_t s_fed_us = 0;
+static volatile uint32_t s_dropped = 0;
+
+static bool store_load(wake_store_t *store)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(WAKE_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(*store);
+    esp_err_t err = nvs_get_blob(nvs, WAKE_NVS_KEY, store, &len);
+    nvs_close(nvs);
+    return err == ESP_OK && len == sizeof(*store) && store->version == WAKE_STORE_VERSION &&
+           store->count > 0 && store->count <= VC_KWS_MAX_EXAMPLES;
+}
+
+static esp_err_t store_save(const wake_store_t *store)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(WAKE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = nvs_set_blob(nvs, WAKE_NVS_KEY, store, sizeof(*store));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err;
+}
+
+/**
+ * Point the spotter at the examples in s_store
+ */
+static void spotter_load(wake_state_t *st)
+{
+    vc_kws_config_t cfg = {
+        .threshold = s_store->threshold,
+        .confirm_frames = WAKE_CONFIRM_FRAMES,
+    };
+    vc_kws_init(&st->kws, &cfg);
+    for (int i = 0; i < s_store->count; i++) {
+        vc_kws_add_example(&st->kws, &s_store->examples[i]);
+    }
+    s_enrolled = true;
+}
+
+static void restart(wake_state_t *st)
+{
+    vc_resampler_reset(&st->resampler);
+    vc_mfcc_reset(&st->mfcc);
+    vc_kws_reset(&st->kws);
+    vc_vad_reset(&st->vad);
+    st->in_take = false;
+    st->lead_in_count = 0;
+    st->frames = 0;
+    st->consumed = 0;
+}
+
+/**
+ * Enrollment: collect one frame of the take in progress
+ */
+static void enroll_frame(wake_state_t *st, vc_vad_event_t event, const int8_t *feat)
+{
+    vc_kws_example_t *take = &s_store->examples[st->taken];
+
+    if (event == VC_VAD_START) {
+        // The onset was heard before it was confirmed, it leads the take in
+        st->in_take = true;
+        take->frames = 0;
+        for (int i = 0; i < st->lead_in_count; i++) {
+            int slot = (st->lead_in_head + i) % WAKE_LEAD_IN_FRAMES;
+            memcpy(take->feat[take->frames++], st->lead_in[slot], VC_KWS_DIM);
+        }
+        st->lead_in_count = 0;
+    }
+
+    if (!st->in_take) {
+        int slot = (st->lead_in_head + st->lead_in_count) % WAKE_LEAD_IN_FRAMES;
+        if (st->lead_in_count == WAKE_LEAD_IN_FRAMES) {
+            st->lead_in_head = (st->lead_in_head + 1) % WAKE_LEAD_IN_FRAMES;
+        } else {
+            st->lead_in_count++;
+        }
+        memcpy(st->lead_in[slot], feat, VC_KWS_DIM);
+        return;
+    }
+
+    if (event != VC_VAD_END) {
+        if (take->frames < VC_KWS_MAX_FRAMES) {
+            memcpy(take->feat[take->frames], feat, VC_KWS_DIM);
+        }
+        take->frames++;     // Counted past the end, so a long take is rejected below
+        return;
+    }
+
+    st->in_take = false;
+    int trailing = WAKE_TAKE_HANGOVER / 10 - WAKE_TAKE_TAIL;
+    int frames = take->frames > trailing ? take->frames - trailing : 0;
+    if (frames < VC_KWS_MIN_FRAMES || frames > VC_KWS_MAX_FRAMES) {
+        ESP_LOGW(TAG, "Take of %d ms ignored (%d-%d ms), say just the wake word", frames * 10,
+                 VC_KWS_MIN_FRAMES * 10, VC_KWS_MAX_FRAMES * 10);
+        return;
+    }
+    take->frames = frames;
+
+    // Every pair of takes enters the threshold, so each must align with the ones before
+    for (int p = 0; p < st->taken; p++) {
+        const vc_kws_example_t *prev = &s_store->examples[p];
+        if (vc_kws_calibrate(take, prev) == UINT16_MAX || vc_kws_calibrate(prev, take) == UINT16_MAX) {
+            ESP_LOGW(TAG, "Take of %d ms too unlike take %d (%d ms) to align, say it again", frames * 10,
+                     p + 1, prev->frames * 10);
+            return;
+        }
+    }
+    st->taken++;
+    ESP_LOGI(TAG, "Take %d/%d: %d ms", st->taken, VC_KWS_MAX_EXAMPLES, frames * 10);
+
+    if (st->taken < VC_KWS_MAX_EXAMPLES) {
+        if (s_config.on_enroll) {
+            s_config.on_enroll(st->taken, VC_KWS_MAX_EXAMPLES);
+        }
+        return;
+    }
+
+    // Threshold: the takes' mean distance to each other, plus the margin
+    uint32_t sum = 0;
+    int pairs = 0;
+    for (int a = 0; a < VC_KWS_MAX_EXAMPLES; a++) {
+        for (int b = 0; b < VC_KWS_MAX_EXAMPLES; b++) {
+            uint16_t d = a != b ? vc_kws_calibrate(&s_store->examples[a], &s_store->examples[b]) : UINT16_MAX;
+            if (d != UINT16_MAX) {  // Unalignable pairs were turned away above, this is a backstop
+                sum += d;
+                pairs++;
+            }
+        }
+    }
+    if (pairs == 0) {
+        pairs = 1;
+    }
+    uint32_t threshold = (sum / pairs) * s_config.margin_q8 / 256;
+    s_store->version = WAKE_STORE_VERSION;
+    s_store->count = VC_KWS_MAX_EXAMPLES;
+    s_store->threshold = (uint16_t)(threshold < UINT16_MAX ? threshold : UINT16_MAX);
+    esp_err_t err = store_save(s_store);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Examples not saved (%s), enrolled until reboot", esp_err_to_name(err));
+    }
+    ESP_LOGI(TAG, "Enrolled: %d takes, takes differ by %lu, threshold %u", VC_KWS_MAX_EXAMPLES,
+             (unsigned long)(sum / pairs), s_store->threshold);
+
+    st->enrolling = false;
+    spotter_load(st);
+    if (s_config.on_enroll) {
+        s_config.on_enroll(VC_KWS_MAX_EXAMPLES, VC_KWS_MAX_EXAMPLES);
+    }
+}
+
+/**
+ * Spotting: report a match with where the word ended
+ */
+static void detect_frame(wake_state_t *st, const int8_t *feat)
+{
+    int ago = vc_kws_process(&st->kws, feat);
+    if (ago < 0) {
+        return;
+    }
+
+    // Convert the word's last frame to a position in the caller's stream
+    uint32_t end_frame = st->frames - 1 - ago;
+    uint32_t end_16k = end_frame * st->mfcc.hop + st->mfcc.frame_len;
+    uint32_t end_sample = (uint32_t)((uint64_t)end_16k * s_config.sample_rate / WAKE_RATE);
+
+    taskENTER_CRITICAL(&s_feed_lock);
+    uint32_t fed = s_fed;
+    int64_t fed_us = s_fed_us;
+    taskEXIT_CRITICAL(&s_feed_lock);
+    int64_t end_us = fed_us - (int64_t)(fed - end_sample) * 1000000 / s_config.sample_rate;
+    int32_t latency_ms = (int32_t)((esp_timer_get_time() - end_us) / 1000);
+
+    ESP_LOGI(TAG, "Wake word (score %u, threshold %u), %ld ms after it ended", st->kws.best,
+             st->kws.cfg.threshold, (long)latency_ms);
+    turn_trace_wake(latency_ms);
+    s_config.on_wake(end_sample);
+}
+
+static void wake_task(void *arg)
+{
+    wake_state_t *st = s_state;
+    int16_t in[WAKE_READ_SAMPLES];
+    int16_t pcm[WAKE_READ_SAMPLES];     // Never more than in, the rate only goes down
+    uint32_t generation = s_generation;
+    int64_t busy_us = 0;
+    uint32_t audio_samples = 0;
+
+    while (1) {
+        size_t got = xStreamBufferReceive(s_ring, in, sizeof(in), portMAX_DELAY) / sizeof(int16_t);
+        if (got == 0) {
+            continue;
+        }
+        int64_t start_us = esp_timer_get_time();
+
+        if (generation != s_generation) {
+            generation = s_generation;
+            restart(st);
+        }
+        if (s_enroll_requested) {
+            s_enroll_requested = false;
+            s_enrolled = false;
+            restart(st);
+            st->enrolling = true;
+            st->taken = 0;
+            ESP_LOGI(TAG, "Enrolling: say the wake word %d times, pausing after each", VC_KWS_MAX_EXAMPLES);
+            if (s_config.on_enroll) {
+                s_config.on_enroll(0, VC_KWS_MAX_EXAMPLES);
+            }
+        }
+        bool enrolling = st->enrolling;
+        if (!enrolling && !s_enrolled) {
+            continue;   // Nothing to listen for yet
+        }
+
+        size_t count = vc_resampler_process(&st->resampler, in, got, pcm);
+        st->consumed += got;
+        vc_vad_event_t event = enrolling ? vc_vad_process(&st->vad, pcm, count) : VC_VAD_SILENCE;
+
+        const int16_t *p = pcm;
+        float mfcc[VC_MFCC_COEFFS];
+        while (vc_mfcc_frame(&st->mfcc, &p, &count, mfcc)) {
+            int8_t feat[VC_KWS_DIM];
+            vc_kws_features(&st->kws, mfcc, feat);
+            st->frames++;
+            if (enrolling) {
+                enroll_frame(st, event, feat);
+                event = vc_vad_in_speech(&st->vad) ? VC_VAD_SPEECH : VC_VAD_SILENCE;
+            } else {
+                detect_frame(st, feat);
+            }
+        }
+
+        // CPU use: time spent here against the audio it covered
+        busy_us += esp_timer_get_time() - start_us;
+        audio_samples += got;
+        if (audio_samples >= s_config.sample_rate * WAKE_LOAD_PERIOD_S) {
+            int64_t audio_us = (int64_t)audio_samples * 1000000 / s_config.sample_rate;
+            turn_trace_wake_load((uint16_t)(busy_us * 1000 / audio_us));
+            busy_us = 0;
+            audio_samples = 0;
+            if (s_dropped) {
+                ESP_LOGW(TAG, "Fell behind, %lu samples dropped", (unsigned long)s_dropped);
+                s_dropped = 0;
+            }
+        }
+    }
+}
+
+esp_err_t wake_word_init(const wake_word_config_t *config)
+{
+    if (s_task || !config->on_wake) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_config = *config;
+
+    s_state = mem_policy_alloc(MEM_INTERNAL, sizeof(wake_state_t));
+    s_store = mem_policy_alloc(MEM_BULK, sizeof(wake_store_t));
+    uint8_t *storage = mem_policy_alloc(MEM_INTERNAL, WAKE_RING_BYTES + 1);
+    if (!s_state || !s_store || !storage) {
+        ESP_LOGE(TAG, "No memory for the spotter");
+        return ESP_ERR_NO_MEM;
+    }
+    memset(s_state, 0, sizeof(*s_state));
+    if (!vc_resampler_init(&s_state->resampler, config->sample_rate, WAKE_RATE) ||
+        !vc_mfcc_init(&s_state->mfcc, WAKE_RATE)) {
+        ESP_LOGE(TAG, "Unsupported sample rate %lu Hz", (unsigned long)config->sample_rate);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    vc_vad_config_t vad_cfg = vc_vad_default_config(WAKE_RATE);
+    vad_cfg.hangover_ms = WAKE_TAKE_HANGOVER;
+    vc_vad_init(&s_state->vad, &vad_cfg);
+
+    if (store_load(s_store)) {
+        spotter_load(s_state);
+        ESP_LOGI(TAG, "%u examples loaded, threshold %u", s_store->count, s_store->threshold);
+    } else {
+        vc_kws_config_t cfg = { .threshold = 0, .confirm_frames = WAKE_CONFIRM_FRAMES };
+        vc_kws_init(&s_state->kws, &cfg);
+        ESP_LOGW(TAG, "No wake word enrolled");
+    }
+    restart(s_state);
+
+    s_ring = xStreamBufferCreateStatic(WAKE_RING_BYTES, sizeof(int16_t), storage, &s_ring_struct);
+    if (!s_ring) {
+        return ESP_ERR_NO_MEM;
+    }
+    // Uses the FPU, which ties a task to its core on the ESP32 anyway
+    if (xTaskCreatePinnedToCore(wake_task, "wake_task", 4096, NULL, config->priority, &s_task,
+                                config->core) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create wake task");
+        return ESP_ERR_NO_MEM;
+    }
+    turn_trace_watch_task(s_task);
+    return ESP_OK;
+}
+
+bool wake_word_enrolled(void)
+{
+    return s_enrolled;
+}
+
+void wake_word_enroll(void)
+{
+    s_enroll_requested = true;
+}
+
+void wake_word_listen(void)
+{
+    taskENTER_CRITICAL(&s_feed_lock);
+    s_fed = 0;
+    s_fed_us = esp_timer_get_time();
+    taskEXIT_CRITICAL(&s_feed_lock);
+    // The ring is empty by now (nothing is fed during a turn), the task restarts on its next read
+    s_generation++;
+}
+
+void wake_word_feed(const int16_t *samples, size_t count)
+{
+    if (!s_ring) {
+        return;
+    }
+    size_t bytes = count * sizeof(int16_t);
+    size_t sent = xStreamBufferSend(s_ring, samples, bytes, 0);
+    if (sent < bytes) {
+        s_dropped += (bytes - sent) / sizeof(int16_t);
+    }
+    taskENTER_CRITICAL(&s_feed_lock);
+    s_fed += count;
+    s_fed_us = esp_timer_get_time();
+    taskEXIT_CRITICAL(&s_feed_lock);
+}
@@ -0,0 +1,77 @@
+/**
+ * Wake word
+ * Keyword spotting on the mic stream in a low-priority task, with the
+ * examples enrolled on the device and kept in NVS
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Wake word spotted, run on the wake task
+ *
+ * @param end_sample Where the word ended, in samples fed since wake_word_listen()
+ */
+typedef void (*wake_word_cb_t)(uint32_t end_sample);
+
+/**
+ * @brief Enrollment progress, run on the wake task (taken == needed: done and saved)
+ */
+typedef void (*wake_word_enroll_cb_t)(int taken, int needed);
+
+typedef struct {
+    uint32_t sample_rate;           /*!< Rate of the samples fed in (converted to 16 kHz) */
+    UBaseType_t priority;           /*!< Below the capture task, it only looks at copies */
+    BaseType_t core;
+    uint16_t margin_q8;             /*!< Threshold over the spread between the enrolled takes (256 = 1x) */
+    wake_word_cb_t on_wake;
+    wake_word_enroll_cb_t on_enroll;    /*!< May be NULL */
+} wake_word_config_t;
+
+/**
+ * @brief Load the enrolled examples and start the wake task
+ *
+ * @return
+ *      - ESP_OK: Running (spotting if enrolled, waiting for wake_word_enroll() if not)
+ *      - ESP_ERR_NO_MEM: State, ring or task could not be allocated
+ *      - Others: Unsupported sample rate
+ */
+esp_err_t wake_word_init(const wake_word_config_t *config);
+
+/**
+ * @brief Whether examples are loaded (spotting is on)
+ */
+bool wake_word_enrolled(void);
+
+/**
+ * @brief Turn the next few utterances into the wake word
+ *
+ * Spotting stops until every take is in; then they replace the old
+ * examples in NVS.
+ */
+void wake_word_enroll(void);
+
+/**
+ * @brief The mic opened for listening: restart matching and the sample count
+ *
+ * Call from the task that feeds, before the first wake_word_feed().
+ */
+void wake_word_listen(void);
+
+/**
+ * @brief Copy captured samples to the wake task (never blocks; drops if it fell behind)
+ */
+void wake_word_feed(const int16_t *samples, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
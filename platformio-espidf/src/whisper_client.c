@@ -0,0 +1,350 @@
+/**
+ * OpenAI Whisper transcription client
+ *
+ * Both paths stream the multipart body: preamble, WAV header, PCM, trailer.
+ * The pipelined path additionally uses chunked transfer encoding so the
+ * upload can start on button press, fed from a capture ring by the
+ * recording task.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "vc_json_extract.h"
+#include "vc_upload.h"
+#include "whisper_client.h"
+#include "api_session.h"
+#include "audio_arena.h"
+#include "turn_trace.h"
+
+static const char *TAG = "whisper";
+
+#define WHISPER_PATH              "/v1/audio/transcriptions"
+#define WHISPER_TIMEOUT_MS        30000
+#define WHISPER_READ_CHUNK        512    // Response is scanned through this, never buffered whole
+#define WHISPER_MAX_TEXT          1024   // Longest transcription kept (~170 words), from the text slab
+#define STREAM_CHUNK_BYTES        2048         // PCM bytes per HTTP chunk
+#define STREAM_POLL_MS            20
+
+static uint32_t s_sample_rate = 0;
+
+// Pipelined upload state
+static StreamBufferHandle_t s_ring = NULL;
+static StaticStreamBuffer_t s_ring_struct;
+static SemaphoreHandle_t s_done = NULL;
+static TaskHandle_t s_task = NULL;
+static volatile bool s_active = false;
+static volatile bool s_finishing = false;
+static volatile bool s_aborted = false;
+static const char *s_result = NULL;
+static size_t s_dropped = 0;
+
+/**
+ * Write a whole buffer to an open HTTP request body
+ */
+static esp_err_t http_write_all(esp_http_client_handle_t client, const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    while (len > 0) {
+        int written = esp_http_client_write(client, p, len);
+        if (written <= 0) {
+            return ESP_FAIL;
+        }
+        p += written;
+        len -= written;
+    }
+    turn_trace_mark(TRACE_FIRST_UPLOAD);  // Only the first write of a turn counts
+    return ESP_OK;
+}
+
+/**
+ * Write one chunked-transfer chunk, framed in place (see vc_chunk_frame())
+ */
+static esp_err_t write_http_chunk(esp_http_client_handle_t client, char *buf, size_t len)
+{
+    return http_write_all(client, buf, vc_chunk_frame(buf, len));
+}
+
+/**
+ * Take a pooled client set up for the transcription endpoint
+ */
+static esp_http_client_handle_t create_client(void)
+{
+    esp_http_client_handle_t client = api_session_acquire(HTTP_METHOD_POST, WHISPER_PATH, WHISPER_TIMEOUT_MS, NULL, NULL);
+    if (!client) {
+        return NULL;
+    }
+    esp_http_client_set_header(client, "Content-Type", VC_UPLOAD_CONTENT_TYPE);
+    return client;
+}
+
+/**
+ * Read the response headers of a fully written request
+ */
+static esp_err_t fetch_response(esp_http_client_handle_t client)
+{
+    if (esp_http_client_fetch_headers(client) < 0) {
+        ESP_LOGE(TAG, "  ✗ No response from Whisper API");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Read the response body (headers already fetched) and extract the "text" field
+ */
+static const char *read_transcription(esp_http_client_handle_t client)
+{
+    char *text = audio_arena_alloc(AUDIO_SLAB_TEXT, WHISPER_MAX_TEXT + 1);
+    if (!text) {
+        return NULL;
+    }
+    vc_json_extractor_t ex;
+    vc_json_extractor_init_buffer(&ex, "text", text, WHISPER_MAX_TEXT + 1);
+
+    int status = esp_http_client_get_status_code(client);
+    char chunk[WHISPER_READ_CHUNK];
+    int response_len = 0;
+    vc_json_status_t parse = VC_JSON_MORE;
+
+    // Read to the end even once "text" is found so the connection can be reused
+    int n;
+    while ((n = esp_http_client_read(client, chunk, sizeof(chunk))) > 0) {
+        response_len += n;
+        if (status != 200) {
+            ESP_LOGE(TAG, "  ✗ HTTP error: status=%d, response: %.*s", status, n, chunk);
+            break;
+        }
+        if (parse == VC_JSON_MORE) {
+            parse = vc_json_extractor_feed(&ex, chunk, n);
+        }
+    }
+    ESP_LOGI(TAG, "  Whisper API Status = %d, response length = %d", status, response_len);
+
+    const char *transcription = NULL;
+    if (parse == VC_JSON_FOUND) {
+        transcription = vc_json_extractor_value(&ex, NULL);
+        ESP_LOGI(TAG, "  ✓ Transcription successful%s", ex.truncated ? " (truncated)" : "");
+    } else if (status == 200) {
+        ESP_LOGE(TAG, "  ✗ No 'text' field in response");
+    }
+    return transcription;
+}
+
+const char *whisper_transcribe(const int16_t *audio_data, size_t sample_count)
+{
+    ESP_LOGI(TAG, "→ Transcribing %d samples (%.2f seconds) to Whisper API...",
+             sample_count, (float)sample_count / s_sample_rate);
+
+    esp_http_client_handle_t client = create_client();
+    if (!client) {
+        return NULL;
+    }
+
+    size_t wav_data_size = sample_count * 2;  // 16-bit samples
+    uint8_t wav_header[VC_WAV_HEADER_SIZE];
+    vc_wav_header(wav_header, wav_data_size, s_sample_rate);
+
+    size_t content_length = VC_UPLOAD_PREAMBLE_LEN + VC_WAV_HEADER_SIZE + wav_data_size + VC_UPLOAD_TRAILER_LEN;
+    ESP_LOGI(TAG, "  Sending %d bytes to Whisper API...", content_length);
+
+    // The whole body is at hand, so a kept-alive connection the server closed
+    // (it only shows at the write or the headers) is retried on a new one
+    const char *transcription = NULL;
+    esp_err_t err;
+    do {
+        err = api_session_open(client, content_length);
+        if (err == ESP_OK) {
+            if (http_write_all(client, VC_UPLOAD_PREAMBLE, VC_UPLOAD_PREAMBLE_LEN) != ESP_OK ||
+                http_write_all(client, wav_header, VC_WAV_HEADER_SIZE) != ESP_OK ||
+                http_write_all(client, audio_data, wav_data_size) != ESP_OK ||
+                http_write_all(client, VC_UPLOAD_TRAILER, VC_UPLOAD_TRAILER_LEN) != ESP_OK) {
+                err = ESP_FAIL;
+            }
+        }
+        if (err == ESP_OK) {
+            err = fetch_response(client);
+        }
+    } while (err != ESP_OK && api_session_retry(client));
+
+    if (err == ESP_OK) {
+        transcription = read_transcription(client);
+    } else {
+        ESP_LOGE(TAG, "  ✗ Whisper API request failed: %s", esp_err_to_name(err));
+    }
+
+    api_session_release(client, err == ESP_OK);
+    return transcription;
+}
+
+/**
+ * Upload task - owns the HTTP connection of a pipelined transcription
+ */
+static void upload_task(void *arg)
+{
+    static char chunk[VC_CHUNK_HEADER + STREAM_CHUNK_BYTES + VC_CHUNK_TRAILER];
+    char *payload = chunk + VC_CHUNK_HEADER;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        size_t uploaded = 0;
+        esp_http_client_handle_t client = create_client();
+        esp_err_t err = client ? api_session_open(client, -1) : ESP_FAIL;  // -1: chunked
+
+        if (err == ESP_OK) {
+            // Preamble and a streaming WAV header (sizes unknown until release)
+            memcpy(payload, VC_UPLOAD_PREAMBLE, VC_UPLOAD_PREAMBLE_LEN);
+            vc_wav_header((uint8_t *)payload + VC_UPLOAD_PREAMBLE_LEN, VC_WAV_STREAMING_SIZE, s_sample_rate);
+            err = write_http_chunk(client, chunk, VC_UPLOAD_PREAMBLE_LEN + VC_WAV_HEADER_SIZE);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "  ✗ Failed to open streaming upload");
+        }
+
+        // Drain the capture ring; on error keep draining so capture never blocks
+        while (1) {
+            size_t got = xStreamBufferReceive(s_ring, payload, STREAM_CHUNK_BYTES, pdMS_TO_TICKS(STREAM_POLL_MS));
+            if (got > 0) {
+                if (err == ESP_OK && !s_aborted) {
+                    err = write_http_chunk(client, chunk, got);
+                    uploaded += got;
+                }
+            } else if (s_finishing && xStreamBufferIsEmpty(s_ring)) {
+                break;
+            }
+        }
+
+        const char *transcription = NULL;
+        if (err == ESP_OK && !s_aborted) {
+            memcpy(payload, VC_UPLOAD_TRAILER, VC_UPLOAD_TRAILER_LEN);
+            err = write_http_chunk(client, chunk, VC_UPLOAD_TRAILER_LEN);
+            if (err == ESP_OK) {
+                err = http_write_all(client, "0\r\n\r\n", 5);
+            }
+            if (err == ESP_OK) {
+                ESP_LOGI(TAG, "  Streamed %d audio bytes (%d dropped)", uploaded, s_dropped);
+                err = fetch_response(client);
+            }
+            if (err == ESP_OK) {
+                transcription = read_transcription(client);
+            } else {
+                ESP_LOGE(TAG, "  ✗ Streaming upload failed after %d bytes", uploaded);
+            }
+        }
+
+        if (client) {
+            // An aborted or failed upload leaves the request half-sent, never reuse it
+            api_session_release(client, err == ESP_OK && !s_aborted);
+        }
+
+        s_result = transcription;
+        s_active = false;
+        xSemaphoreGive(s_done);
+    }
+}
+
+esp_err_t whisper_init(uint32_t sample_rate, bool streaming)
+{
+    s_sample_rate = sample_rate;
+    if (s_ring || !streaming) {
+        return ESP_OK;
+    }
+
+    // Ring storage is the arena's capture slab (one byte is the stream buffer's spare)
+    size_t slab_size;
+    uint8_t *storage = audio_arena_slab(AUDIO_SLAB_CAPTURE, &slab_size);
+    if (!storage || slab_size <= STREAM_CHUNK_BYTES) {
+        ESP_LOGE(TAG, "No usable capture slab (%d bytes)", slab_size);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Trigger level batches the receive into full HTTP chunks
+    s_ring = xStreamBufferCreateStatic(slab_size - 1, STREAM_CHUNK_BYTES, storage, &s_ring_struct);
+    s_done = xSemaphoreCreateBinary();
+    if (!s_ring || !s_done) {
+        ESP_LOGE(TAG, "Failed to create capture ring");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // TLS handshake runs on this task, so it needs the same stack as the REST calls,
+    // and it stays on core 0 with Wi-Fi and lwIP, clear of the audio tasks
+    if (xTaskCreatePinnedToCore(upload_task, "upload_task", 8192, NULL, 6, &s_task, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create upload task");
+        return ESP_ERR_NO_MEM;
+    }
+    turn_trace_watch_task(s_task);
+    return ESP_OK;
+}
+
+esp_err_t whisper_stream_begin(void)
+{
+    if (!s_ring || s_active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Upload task is parked on its notification, so the ring can be reset safely
+    xStreamBufferReset(s_ring);
+    xSemaphoreTake(s_done, 0);
+
+    s_result = NULL;  // Left over from a stream whose finish timed out
+    s_dropped = 0;
+    s_finishing = false;
+    s_aborted = false;
+    s_active = true;
+
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+size_t whisper_stream_push(const int16_t *samples, size_t sample_count)
+{
+    if (!s_active || s_finishing) {
+        return 0;
+    }
+
+    // Drop whole chunks on overflow so the byte stream stays sample-aligned
+    size_t bytes = sample_count * sizeof(int16_t);
+    if (xStreamBufferSpacesAvailable(s_ring) < bytes) {
+        if (s_dropped == 0) {
+            ESP_LOGW(TAG, "Capture ring overflow - upload is falling behind");
+        }
+        s_dropped += bytes;
+        return 0;
+    }
+    xStreamBufferSend(s_ring, samples, bytes, 0);
+    audio_arena_note(AUDIO_SLAB_CAPTURE, xStreamBufferBytesAvailable(s_ring));
+    return sample_count;
+}
+
+const char *whisper_stream_finish(void)
+{
+    if (!s_active) {
+        return NULL;
+    }
+
+    s_finishing = true;
+    if (xSemaphoreTake(s_done, pdMS_TO_TICKS(WHISPER_TIMEOUT_MS * 2)) != pdTRUE) {
+        ESP_LOGE(TAG, "  ✗ Streaming transcription timed out");
+        return NULL;
+    }
+
+    const char *transcription = s_result;
+    s_result = NULL;
+    return transcription;
+}
+
+void whisper_stream_abort(void)
+{
+    if (!s_active) {
+        return;
+    }
+
+    s_aborted = true;
+    whisper_stream_finish();
+}
@@ -0,0 +1,73 @@
+/**
+ * OpenAI Whisper transcription client
+ * Buffered one-shot upload and pipelined upload while recording
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Set up the client, and for the streaming path the capture ring and upload task
+ *
+ * The capture ring lives in the arena's capture slab, so audio_arena_init()
+ * must run first when streaming is enabled.
+ *
+ * @param[in] sample_rate Sample rate of the mono PCM16 audio being uploaded
+ * @param[in] streaming   Create the capture ring and upload task for whisper_stream_*()
+ * @return
+ *      - ESP_OK: Client ready
+ *      - ESP_ERR_NO_MEM: No capture slab, or the task could not be allocated
+ */
+esp_err_t whisper_init(uint32_t sample_rate, bool streaming);
+
+/**
+ * @brief Upload a complete recording and wait for the transcription
+ *
+ * The multipart body is streamed from audio_data without copying it.
+ *
+ * @return Transcription (in the arena's text slab, valid until it is reset) or NULL on failure
+ */
+const char *whisper_transcribe(const int16_t *audio_data, size_t sample_count);
+
+/**
+ * @brief Open a chunked upload so audio can be sent while it is captured
+ *
+ * The TLS handshake and multipart preamble happen on the upload task while
+ * the user is still talking.
+ *
+ * @return
+ *      - ESP_OK: Stream started
+ *      - ESP_ERR_INVALID_STATE: Not initialized or a stream is already active
+ */
+esp_err_t whisper_stream_begin(void);
+
+/**
+ * @brief Queue captured samples for upload (non-blocking, safe from the capture task)
+ *
+ * @return Number of samples accepted; fewer than sample_count if the ring overflowed
+ */
+size_t whisper_stream_push(const int16_t *samples, size_t sample_count);
+
+/**
+ * @brief Flush the tail and multipart trailer, then wait for the transcription
+ *
+ * @return Transcription (in the arena's text slab, valid until it is reset) or NULL on failure
+ */
+const char *whisper_stream_finish(void);
+
+/**
+ * @brief Abandon the current stream without requesting a transcription
+ */
+void whisper_stream_abort(void);
+
+#ifdef __cplusplus
+}
+#endif
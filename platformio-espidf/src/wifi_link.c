@@ -0,0 +1,323 @@
+/**
+ * Wi-Fi station link
+ *
+ * A cold connect scans every channel before it even starts to associate,
+ * which is most of the time a device takes to come back after a power
+ * blip. The BSSID and channel of the last AP that gave us an address are
+ * kept in NVS, so the next boot probes that one channel only; DHCP is
+ * shortened the same way by CONFIG_LWIP_DHCP_RESTORE_LAST_IP (or skipped
+ * with a static address). If the cached AP does not answer, the cache is
+ * dropped and a normal scan follows straight away.
+ *
+ * Reconnects back off exponentially with jitter instead of calling
+ * esp_wifi_connect() again from the disconnect event, which spun the radio
+ * and flooded the log while an AP rebooted.
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "nvs.h"
+#include "wifi_link.h"
+
+static const char *TAG = "wifi_link";
+
+#define WIFI_NVS_NAMESPACE      "wifi_link"
+#define WIFI_NVS_KEY            "ap"
+#define WIFI_CACHE_VERSION      1
+#define WIFI_BACKOFF_MIN_MS     250     // First retry after a drop
+#define WIFI_BACKOFF_MAX_MS     30000   // Ceiling while the AP stays away
+
+#define LINK_UP_BIT BIT0
+
+// Last AP that gave us an address
+typedef struct {
+    uint32_t version;
+    uint32_t ssid_hash;     // Only valid for the SSID it was learned on
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_cache_t;
+
+static EventGroupHandle_t s_events = NULL;
+static esp_timer_handle_t s_retry_timer = NULL;
+static wifi_config_t s_wifi_config;
+static wifi_cache_t s_cache;
+static wifi_link_state_cb_t s_on_state = NULL;
+
+static bool s_pinned = false;           // Config points at the cached AP
+static bool s_fast = false;             // First connection came from the cache
+static bool s_ever_connected = false;   // Since boot
+static uint32_t s_attempt = 0;          // Failed attempts since the last connection
+static int64_t s_start_us = 0;
+static int64_t s_connect_us = -1;
+
+static uint32_t fnv1a(const char *s)
+{
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h = (h ^ (uint8_t)*s) * 16777619u;
+    }
+    return h;
+}
+
+static bool cache_load(const char *ssid)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    size_t len = sizeof(s_cache);
+    esp_err_t err = nvs_get_blob(nvs, WIFI_NVS_KEY, &s_cache, &len);
+    nvs_close(nvs);
+    return err == ESP_OK && len == sizeof(s_cache) && s_cache.version == WIFI_CACHE_VERSION &&
+           s_cache.ssid_hash == fnv1a(ssid) && s_cache.channel != 0;
+}
+
+static void cache_store(const wifi_cache_t *cache)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(WIFI_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    if (cache) {
+        nvs_set_blob(nvs, WIFI_NVS_KEY, cache, sizeof(*cache));
+    } else {
+        nvs_erase_key(nvs, WIFI_NVS_KEY);
+    }
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+/**
+ * Stop pointing the config at the cached AP, so the next connect scans
+ */
+static void unpin(void)
+{
+    s_pinned = false;
+    s_wifi_config.sta.bssid_set = false;
+    s_wifi_config.sta.channel = 0;
+    esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+}
+
+static void retry_timer_cb(void *arg)
+{
+    esp_wifi_connect();
+}
+
+/**
+ * Next reconnect delay: doubling from WIFI_BACKOFF_MIN_MS, half of it random
+ */
+static uint32_t backoff_ms(void)
+{
+    uint32_t shift = s_attempt < 8 ? s_attempt : 8;
+    uint32_t delay = WIFI_BACKOFF_MIN_MS << shift;
+    if (delay > WIFI_BACKOFF_MAX_MS) {
+        delay = WIFI_BACKOFF_MAX_MS;
+    }
+    return delay / 2 + esp_random() % (delay / 2 + 1);
+}
+
+static void on_disconnected(const wifi_event_sta_disconnected_t *event)
+{
+    bool was_up = xEventGroupGetBits(s_events) & LINK_UP_BIT;
+    xEventGroupClearBits(s_events, LINK_UP_BIT);
+    if (was_up && s_on_state) {
+        s_on_state(false);
+    }
+
+    if (s_pinned) {
+        unpin();
+        if (!s_ever_connected) {
+            // The cached AP is gone or moved channel: scan now, do not wait
+            ESP_LOGW(TAG, "Cached AP not found (reason %d), scanning", event->reason);
+            cache_store(NULL);
+            esp_wifi_connect();
+            return;
+        }
+    }
+
+    uint32_t delay = backoff_ms();
+    s_attempt++;
+    ESP_LOGI(TAG, "Disconnected (reason %d), retry %lu in %lu ms", event->reason,
+             (unsigned long)s_attempt, (unsigned long)delay);
+    esp_timer_stop(s_retry_timer);
+    esp_timer_start_once(s_retry_timer, (uint64_t)delay * 1000);
+}
+
+static void on_got_ip(const ip_event_got_ip_t *event)
+{
+    s_attempt = 0;
+    if (!s_ever_connected) {
+        s_ever_connected = true;
+        s_fast = s_pinned;
+        s_connect_us = esp_timer_get_time() - s_start_us;
+        ESP_LOGI(TAG, "Connected in %lld ms (%s), IP " IPSTR, s_connect_us / 1000,
+                 s_fast ? "cached AP, no scan" : "full scan", IP2STR(&event->ip_info.ip));
+    } else {
+        ESP_LOGI(TAG, "Reconnected, IP " IPSTR, IP2STR(&event->ip_info.ip));
+    }
+
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) == ESP_OK &&
+        (s_cache.channel != ap.primary || memcmp(s_cache.bssid, ap.bssid, sizeof(ap.bssid)) != 0)) {
+        s_cache.version = WIFI_CACHE_VERSION;
+        s_cache.ssid_hash = fnv1a((const char *)s_wifi_config.sta.ssid);
+        memcpy(s_cache.bssid, ap.bssid, sizeof(ap.bssid));
+        s_cache.channel = ap.primary;
+        cache_store(&s_cache);
+        ESP_LOGI(TAG, "Cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %d", ap.bssid[0], ap.bssid[1],
+                 ap.bssid[2], ap.bssid[3], ap.bssid[4], ap.bssid[5], ap.primary);
+    }
+
+    xEventGroupSetBits(s_events, LINK_UP_BIT);
+    if (s_on_state) {
+        s_on_state(true);
+    }
+}
+
+static void event_handler(void *arg, esp_event_base_t event_base, int32_t event_id, void *event_data)
+{
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
+        esp_wifi_connect();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        on_disconnected(event_data);
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        on_got_ip(event_data);
+    }
+}
+
+/**
+ * Fixed address instead of DHCP (dhcpc is stopped before the link comes up)
+ */
+static esp_err_t set_static_ip(esp_netif_t *netif, const wifi_link_config_t *config)
+{
+    esp_netif_ip_info_t info = {
+        .ip.addr = esp_ip4addr_aton(config->static_ip),
+        .gw.addr = esp_ip4addr_aton(config->gateway),
+        .netmask.addr = esp_ip4addr_aton(config->netmask),
+    };
+    esp_err_t err = esp_netif_dhcpc_stop(netif);
+    if (err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+        return err;
+    }
+    err = esp_netif_set_ip_info(netif, &info);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    esp_netif_dns_info_t dns = {
+        .ip.type = ESP_IPADDR_TYPE_V4,
+        .ip.u_addr.ip4.addr = config->dns ? esp_ip4addr_aton(config->dns) : info.gw.addr,
+    };
+    ESP_LOGI(TAG, "Static IP %s", config->static_ip);
+    return esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns);
+}
+
+esp_err_t wifi_link_start(const wifi_link_config_t *config)
+{
+    if (s_events) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_start_us = esp_timer_get_time();
+    s_on_state = config->on_state;
+    s_events = xEventGroupCreate();
+    if (!s_events) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t retry_args = {
+        .callback = retry_timer_cb,
+        .name = "wifi_retry",
+    };
+    esp_err_t err = esp_timer_create(&retry_args, &s_retry_timer);
+    if (err == ESP_OK) {
+        err = esp_netif_init();
+    }
+    if (err == ESP_OK) {
+        err = esp_event_loop_create_default();
+    }
+    if (err == ESP_OK) {
+        esp_netif_t *netif = esp_netif_create_default_wifi_sta();
+        if (config->static_ip && config->static_ip[0]) {
+            err = set_static_ip(netif, config);
+        }
+    }
+    if (err == ESP_OK) {
+        wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
+        err = esp_wifi_init(&cfg);
+    }
+    if (err == ESP_OK) {
+        err = esp_event_handler_instance_register(WIFI_EVENT, ESP_EVENT_ANY_ID, event_handler, NULL, NULL);
+    }
+    if (err == ESP_OK) {
+        err = esp_event_handler_instance_register(IP_EVENT, IP_EVENT_STA_GOT_IP, event_handler, NULL, NULL);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize Wi-Fi: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    memset(&s_wifi_config, 0, sizeof(s_wifi_config));
+    strlcpy((char *)s_wifi_config.sta.ssid, config->ssid, sizeof(s_wifi_config.sta.ssid));
+    strlcpy((char *)s_wifi_config.sta.password, config->password, sizeof(s_wifi_config.sta.password));
+    s_wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    s_wifi_config.sta.scan_method = WIFI_FAST_SCAN;     // Stop at the first match
+    if (cache_load(config->ssid)) {
+        s_pinned = true;
+        s_wifi_config.sta.bssid_set = true;
+        memcpy(s_wifi_config.sta.bssid, s_cache.bssid, sizeof(s_cache.bssid));
+        s_wifi_config.sta.channel = s_cache.channel;
+        ESP_LOGI(TAG, "Fast connect to cached AP on channel %d", s_cache.channel);
+    } else {
+        memset(&s_cache, 0, sizeof(s_cache));
+    }
+
+    // The config is rebuilt every boot and changed again by unpin(): keep it out of flash
+    err = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    if (err == ESP_OK) {
+        err = esp_wifi_set_mode(WIFI_MODE_STA);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_set_config(WIFI_IF_STA, &s_wifi_config);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_start();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start Wi-Fi: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    ESP_LOGI(TAG, "Connecting to %s", config->ssid);
+    return ESP_OK;
+}
+
+bool wifi_link_wait(uint32_t timeout_ms)
+{
+    if (!s_events) {
+        return false;
+    }
+    TickType_t ticks = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return xEventGroupWaitBits(s_events, LINK_UP_BIT, pdFALSE, pdTRUE, ticks) & LINK_UP_BIT;
+}
+
+bool wifi_link_connected(void)
+{
+    return s_events && (xEventGroupGetBits(s_events) & LINK_UP_BIT);
+}
+
+int64_t wifi_link_connect_time_us(void)
+{
+    return s_connect_us;
+}
+
+bool wifi_link_fast_connected(void)
+{
+    return s_fast;
+}
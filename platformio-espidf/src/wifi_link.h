@@ -0,0 +1,71 @@
+/**
+ * Wi-Fi station link
+ * Connects straight to the access point cached in NVS, reconnects with
+ * exponential backoff and times how long association took
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Link state callback, run on the event loop task
+ */
+typedef void (*wifi_link_state_cb_t)(bool connected);
+
+typedef struct {
+    const char *ssid;
+    const char *password;
+    const char *static_ip;          /*!< NULL or "" for DHCP */
+    const char *gateway;            /*!< With static_ip */
+    const char *netmask;            /*!< With static_ip */
+    const char *dns;                /*!< With static_ip (NULL: the gateway) */
+    wifi_link_state_cb_t on_state;  /*!< May be NULL */
+} wifi_link_config_t;
+
+/**
+ * @brief Start Wi-Fi and begin connecting, without waiting for it
+ *
+ * If the last successful connection to this SSID left its BSSID and
+ * channel in NVS, the station probes only that channel instead of
+ * scanning all of them. When the cached AP is gone the cache is dropped
+ * and a full scan follows at once.
+ *
+ * @return
+ *      - ESP_OK: Connecting
+ *      - Others: Wi-Fi or netif initialization failed
+ */
+esp_err_t wifi_link_start(const wifi_link_config_t *config);
+
+/**
+ * @brief Block until the station has an IP address or timeout_ms passes
+ *        (UINT32_MAX waits for good)
+ *
+ * @return true if connected
+ */
+bool wifi_link_wait(uint32_t timeout_ms);
+
+/**
+ * @brief Whether the station currently has an IP address
+ */
+bool wifi_link_connected(void);
+
+/**
+ * @brief Time from wifi_link_start() to the first IP address, in us (-1 before that)
+ */
+int64_t wifi_link_connect_time_us(void);
+
+/**
+ * @brief Whether the first connection used the cached AP (no scan)
+ */
+bool wifi_link_fast_connected(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,406 @@
+"""
+Load generator for the voice gateway
+
+Replays recorded clips from N simulated ATOM Echo devices against
+/api/voice and reports, per AI provider, p50/p95/p99 time to first audio
+byte, full-turn latency and throughput. Each device has its own
+X-Device-ID, so the gateway keeps a session per device exactly as it does
+for a real fleet, and waits a think time between turns.
+
+    python loadgen.py --url http://localhost:8000 --devices 20 --duration 120 clips/*.wav
+    python loadgen.py --url http://gw-a:8000 --url http://gw-b:8000 --codec ima-adpcm --upload stream clips/
+
+With several --url the devices are spread over them and each gateway is
+reported under the provider its health check names (AI_PROVIDER), so an
+OpenAI and a Gemini gateway can be compared in one run. Latencies are timed
+from the last uploaded byte - the moment a device stops recording - which
+is the wait the user hears.
+
+Clips are mono 16-bit WAV files (the rate is taken from the header) or raw
+PCM16 at --rate. Only the standard library is needed.
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import random
+import ssl
+import sys
+import time
+import wave
+from array import array
+from collections import Counter
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional, Tuple
+from urllib.parse import urlsplit
+
+try:
+    import audioop  # C encoder, removed from the standard library in Python 3.13
+except ImportError:
+    audioop = None
+
+CHUNK_SAMPLES = 1024  # Samples per streamed upload chunk, as the firmware's AUDIO_CHUNK_SIZE
+DEFAULT_SAMPLE_RATE = 16000
+PERCENTILES = (50, 95, 99)
+
+# Same tables as main.py / voice_core/src/vc_adpcm.c
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+
+
+@dataclass
+class Clip:
+    name: str
+    pcm: bytes
+    sample_rate: int
+
+
+@dataclass
+class Target:
+    url: str
+    provider: str = "unknown"
+
+
+@dataclass
+class TurnResult:
+    provider: str
+    status: int             # HTTP status, 0 if the request failed without one
+    ttfa: Optional[float]   # Release to first audio byte, s
+    turn: Optional[float]   # Release to last audio byte, s
+    audio_bytes: int = 0
+    upload_bytes: int = 0
+    error: str = ""
+
+
+@dataclass
+class ProviderStats:
+    results: List[TurnResult] = field(default_factory=list)
+
+    def ok(self) -> List[TurnResult]:
+        return [r for r in self.results if r.status == 200 and r.ttfa is not None]
+
+
+def encode_ima_adpcm(pcm: bytes) -> bytes:
+    """Encode PCM16 as IMA-ADPCM (high nibble first, initial state 0/0), like vc_adpcm_encode"""
+    if audioop:
+        return audioop.lin2adpcm(pcm, 2, None)[0]
+
+    samples = array("h", pcm)
+    if sys.byteorder == "big":
+        samples.byteswap()
+    out = bytearray()
+    predictor, index, pending = 0, 0, None
+    for sample in samples:
+        step = IMA_STEP_TABLE[index]
+        diff = sample - predictor
+        code = 0
+        if diff < 0:
+            code, diff = 8, -diff
+        vpdiff = step >> 3
+        for bit in (4, 2, 1):
+            if diff >= step:
+                code |= bit
+                diff -= step
+                vpdiff += step
+            step >>= 1
+        predictor += -vpdiff if code & 8 else vpdiff
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + IMA_INDEX_TABLE[code]))
+        if pending is None:
+            pending = code << 4
+        else:
+            out.append(pending | code)
+            pending = None
+    if pending is not None:
+        out.append(pending)  # Odd count: the last sample pads the low nibble with 0
+    return bytes(out)
+
+
+def load_clips(paths: List[str], raw_rate: int) -> List[Clip]:
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            files += sorted(os.path.join(path, f) for f in os.listdir(path)
+                            if f.lower().endswith((".wav", ".pcm", ".raw")))
+        else:
+            files.append(path)
+
+    clips = []
+    for path in files:
+        if path.lower().endswith(".wav"):
+            with wave.open(path, "rb") as wav:
+                if wav.getnchannels() != 1 or wav.getsampwidth() != 2:
+                    raise SystemExit(f"{path}: need mono 16-bit PCM")
+                clips.append(Clip(os.path.basename(path), wav.readframes(wav.getnframes()), wav.getframerate()))
+        else:
+            with open(path, "rb") as f:
+                clips.append(Clip(os.path.basename(path), f.read(), raw_rate))
+    if not clips:
+        raise SystemExit("No clips given")
+    return clips
+
+
+async def open_connection(url: str):
+    parts = urlsplit(url)
+    secure = parts.scheme == "https"
+    port = parts.port or (443 if secure else 80)
+    reader, writer = await asyncio.open_connection(parts.hostname, port,
+                                                   ssl=ssl.create_default_context() if secure else None)
+    return reader, writer, parts.netloc
+
+
+async def read_head(reader: asyncio.StreamReader) -> Tuple[int, Dict[str, str]]:
+    status_line = await reader.readline()
+    if not status_line:
+        raise ConnectionError("Connection closed before the response")
+    status = int(status_line.split()[1])
+    headers = {}
+    while True:
+        line = (await reader.readline()).decode("latin-1").strip()
+        if not line:
+            return status, headers
+        key, _, value = line.partition(":")
+        headers[key.strip().lower()] = value.strip()
+
+
+async def read_body(reader: asyncio.StreamReader, headers: Dict[str, str], on_data=None) -> bytes:
+    """Read a response body (chunked, Content-Length or until close), on_data(len) per piece"""
+    body = bytearray()
+
+    def got(data: bytes) -> None:
+        if data and on_data:
+            on_data(len(data))
+        body.extend(data)
+
+    if headers.get("transfer-encoding", "").lower() == "chunked":
+        while True:
+            size = int((await reader.readline()).split(b";")[0], 16)
+            if size == 0:
+                await reader.readline()
+                break
+            got(await reader.readexactly(size))
+            await reader.readline()
+    elif "content-length" in headers:
+        remaining = int(headers["content-length"])
+        while remaining:
+            data = await reader.read(min(remaining, 65536))
+            if not data:
+                raise ConnectionError("Short body")
+            remaining -= len(data)
+            got(data)
+    else:
+        while data := await reader.read(65536):
+            got(data)
+    return bytes(body)
+
+
+async def detect_provider(target: Target) -> None:
+    """Label a gateway with the ai_provider of its health check"""
+    try:
+        reader, writer, host = await open_connection(target.url)
+        writer.write(f"GET / HTTP/1.1\r\nHost: {host}\r\nConnection: close\r\n\r\n".encode())
+        await writer.drain()
+        status, headers = await read_head(reader)
+        info = json.loads(await read_body(reader, headers))
+        writer.close()
+        target.provider = f"{info.get('ai_provider', 'unknown')} ({target.url})"
+    except (OSError, ValueError, ConnectionError) as e:
+        raise SystemExit(f"{target.url}: health check failed: {e}")
+
+
+async def run_turn(target: Target, device: str, clip: Clip, args) -> TurnResult:
+    """One push-to-talk turn: upload the clip, time the reply audio"""
+    pcm = clip.pcm
+    if args.codec == "ima-adpcm":
+        body = encode_ima_adpcm(pcm)
+        content_type = f"audio/x-ima-adpcm; rate={clip.sample_rate}"
+        chunk_bytes = CHUNK_SAMPLES // 2
+    else:
+        body = pcm
+        content_type = f"application/octet-stream; rate={clip.sample_rate}"
+        chunk_bytes = CHUNK_SAMPLES * 2
+
+    result = TurnResult(target.provider, 0, None, None, upload_bytes=len(body))
+    writer = None
+    try:
+        reader, writer, host = await open_connection(target.url)
+        head = (f"POST /api/voice HTTP/1.1\r\nHost: {host}\r\nX-Device-ID: {device}\r\n"
+                f"Content-Type: {content_type}\r\nConnection: close\r\n")
+
+        if args.upload == "stream":
+            # Chunks leave as they would be recorded, like PIPELINED_UPLOAD
+            writer.write((head + "Transfer-Encoding: chunked\r\n\r\n").encode())
+            chunk_s = CHUNK_SAMPLES / clip.sample_rate
+            next_send = time.perf_counter()
+            for offset in range(0, len(body), chunk_bytes):
+                chunk = body[offset:offset + chunk_bytes]
+                writer.write(b"%x\r\n%s\r\n" % (len(chunk), chunk))
+                await writer.drain()
+                next_send += chunk_s
+                await asyncio.sleep(max(0.0, next_send - time.perf_counter()))
+            writer.write(b"0\r\n\r\n")
+        else:
+            # The whole recording goes up after the button is released
+            writer.write((head + f"Content-Length: {len(body)}\r\n\r\n").encode() + body)
+        await writer.drain()
+        release = time.perf_counter()
+
+        result.status, headers = await read_head(reader)
+        if result.status != 200:
+            result.error = (await read_body(reader, headers)).decode("utf-8", "replace")[:200]
+            return result
+
+        def on_data(length: int) -> None:
+            if result.ttfa is None:
+                result.ttfa = time.perf_counter() - release
+            result.audio_bytes += length
+
+        await read_body(reader, headers, on_data)
+        result.turn = time.perf_counter() - release
+    except (OSError, ValueError, ConnectionError, asyncio.IncompleteReadError) as e:
+        result.error = f"{type(e).__name__}: {e}"
+    finally:
+        if writer:
+            writer.close()
+    return result
+
+
+async def device_loop(index: int, target: Target, clips: List[Clip], args, deadline: float,
+                      stats: Dict[str, ProviderStats]) -> None:
+    device = f"{args.device_prefix}-{index:04d}"
+    rng = random.Random(args.seed + index)
+    await asyncio.sleep(args.ramp * index / max(1, args.devices))
+
+    turn = 0
+    while time.monotonic() < deadline and (not args.turns or turn < args.turns):
+        clip = clips[(index + turn) % len(clips)]
+        try:
+            result = await asyncio.wait_for(run_turn(target, device, clip, args), args.timeout)
+        except asyncio.TimeoutError:
+            result = TurnResult(target.provider, 0, None, None, error="timeout")
+        stats[target.provider].results.append(result)
+        if args.verbose:
+            ttfa = f"{result.ttfa * 1000:.0f}" if result.ttfa is not None else "-"
+            print(f"{device} {clip.name} status {result.status} ttfa {ttfa} ms "
+                  f"audio {result.audio_bytes} {result.error}", flush=True)
+        turn += 1
+        await asyncio.sleep(rng.uniform(args.think_min, args.think_max))
+
+
+def percentile(sorted_values: List[float], p: float) -> float:
+    """Nearest-rank percentile of an ascending list"""
+    rank = max(1, -(-len(sorted_values) * p // 100))
+    return sorted_values[int(rank) - 1]
+
+
+def summarize(stats: Dict[str, ProviderStats], elapsed: float) -> dict:
+    report = {}
+    for provider, s in stats.items():
+        ok = s.ok()
+        ttfa = sorted(r.ttfa for r in ok)
+        turn = sorted(r.turn for r in ok if r.turn is not None)
+        entry = {
+            "turns": len(s.results),
+            "ok": len(ok),
+            "status": dict(Counter(str(r.status) for r in s.results)),
+            "errors": dict(Counter(r.error.split(":")[0] for r in s.results if r.error and r.status == 0)),
+            "turns_per_s": len(ok) / elapsed if elapsed else 0.0,
+            "audio_bytes_per_s": sum(r.audio_bytes for r in ok) / elapsed if elapsed else 0.0,
+            "upload_bytes_per_s": sum(r.upload_bytes for r in s.results) / elapsed if elapsed else 0.0,
+        }
+        for name, values in (("ttfa_ms", ttfa), ("turn_ms", turn)):
+            if values:
+                entry[name] = {f"p{p}": round(percentile(values, p) * 1000, 1) for p in PERCENTILES}
+        report[provider] = entry
+    return report
+
+
+def print_report(report: dict, elapsed: float, args) -> None:
+    print(f"\n{args.devices} devices, {elapsed:.0f} s, codec {args.codec}, upload {args.upload}, "
+          f"think {args.think_min:g}-{args.think_max:g} s")
+    for provider, entry in report.items():
+        print(f"\n{provider}")
+        statuses = ", ".join(f"{code or 'none'} x{n}" for code, n in sorted(entry["status"].items()))
+        print(f"  turns       {entry['turns']} ({entry['ok']} ok; status {statuses})")
+        if entry["errors"]:
+            print(f"  errors      {', '.join(f'{e} x{n}' for e, n in entry['errors'].items())}")
+        for name, label in (("ttfa_ms", "first audio"), ("turn_ms", "full turn")):
+            if name in entry:
+                p = entry[name]
+                print(f"  {label:<11} p50 {p['p50']:8.0f}  p95 {p['p95']:8.0f}  p99 {p['p99']:8.0f} ms")
+        print(f"  throughput  {entry['turns_per_s'] * 60:.1f} turns/min, "
+              f"{entry['audio_bytes_per_s'] / 1024:.1f} KiB/s audio down, "
+              f"{entry['upload_bytes_per_s'] / 1024:.1f} KiB/s up")
+
+
+def parse_think(value: str) -> Tuple[float, float]:
+    low, _, high = value.partition("-")
+    low_s = float(low)
+    high_s = float(high) if high else low_s
+    if low_s < 0 or high_s < low_s:
+        raise argparse.ArgumentTypeError("think time is SECONDS or MIN-MAX")
+    return low_s, high_s
+
+
+async def run(args) -> int:
+    clips = load_clips(args.clips, args.rate)
+    targets = [Target(url.rstrip("/")) for url in args.url]
+    await asyncio.gather(*(detect_provider(t) for t in targets))
+    stats = {t.provider: ProviderStats() for t in targets}
+
+    print(f"{len(clips)} clips, {args.devices} devices over {len(targets)} gateway(s): "
+          + ", ".join(t.provider for t in targets), flush=True)
+    start = time.monotonic()
+    deadline = start + args.duration if args.duration else float("inf")
+    await asyncio.gather(*(device_loop(i, targets[i % len(targets)], clips, args, deadline, stats)
+                           for i in range(args.devices)))
+    elapsed = time.monotonic() - start
+
+    report = summarize(stats, elapsed)
+    print_report(report, elapsed, args)
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({"devices": args.devices, "codec": args.codec, "upload": args.upload,
+                       "elapsed_s": elapsed, "providers": report}, f, indent=2)
+    return 0 if any(entry["ok"] for entry in report.values()) else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate ATOM Echo devices against /api/voice")
+    parser.add_argument("clips", nargs="+", help="WAV/raw PCM16 files or directories of them")
+    parser.add_argument("--url", action="append", default=None,
+                        help="Gateway base URL, repeat to compare gateways (default http://localhost:8000)")
+    parser.add_argument("--devices", type=int, default=4, help="Simulated devices")
+    parser.add_argument("--duration", type=float, default=60, help="Seconds to run (0 = until --turns)")
+    parser.add_argument("--turns", type=int, default=0, help="Turns per device (0 = until --duration)")
+    parser.add_argument("--think", type=parse_think, default=(2.0, 5.0), metavar="S[-S]",
+                        help="Pause between a device's turns, uniform in MIN-MAX seconds (default 2-5)")
+    parser.add_argument("--ramp", type=float, default=5.0, help="Seconds over which devices start")
+    parser.add_argument("--codec", choices=["pcm16", "ima-adpcm"], default="pcm16", help="Uplink codec")
+    parser.add_argument("--upload", choices=["buffered", "stream"], default="buffered",
+                        help="buffered: upload after release; stream: chunked at real time while 'recording'")
+    parser.add_argument("--rate", type=int, default=DEFAULT_SAMPLE_RATE, help="Sample rate of raw PCM clips")
+    parser.add_argument("--timeout", type=float, default=60, help="Seconds before a turn counts as failed")
+    parser.add_argument("--device-prefix", default="loadgen", help="X-Device-ID prefix")
+    parser.add_argument("--seed", type=int, default=1, help="Think time seed")
+    parser.add_argument("--json", help="Also write the report as JSON")
+    parser.add_argument("-v", "--verbose", action="store_true", help="One line per turn")
+    args = parser.parse_args()
+    args.url = args.url or ["http://localhost:8000"]
+    args.think_min, args.think_max = args.think
+    if not args.duration and not args.turns:
+        parser.error("Set --duration or --turns")
+    sys.exit(asyncio.run(run(args)))
+
+
+if __name__ == "__main__":
+    main()
@@ -5,14 +5,29 @@ Supports both OpenAI and Google Gemini APIs
 """
 
 from fastapi import FastAPI, HTTPException, Request
-from fastapi.responses import Response
+from fastapi.responses import StreamingResponse
+from starlette.concurrency import run_in_threadpool
+import asyncio
+import hashlib
 import os
 import io
+import sys
 import logging
-from openai import OpenAI
+import time
+import wave
+from urllib.parse import quote
+from array import array
+from collections import OrderedDict
+from dataclasses import dataclass, field
+from openai import AsyncOpenAI
 import google.generativeai as genai
-from pydub import AudioSegment
-from typing import Optional
+from contextlib import AsyncExitStack
+from typing import AsyncIterator, Callable, List, Optional, Tuple
+
+try:
+    import audioop  # C decoder, removed from the standard library in Python 3.13
+except ImportError:
+    audioop = None
 
 # Configure logging
 logging.basicConfig(level=logging.INFO)
@@ -29,41 +44,199 @@ TTS_PROVIDER = os.getenv("TTS_PROVIDER", "openai")  # "openai" for now
 # Initialize clients
 openai_client = None
 if OPENAI_API_KEY:
-    openai_client = OpenAI(api_key=OPENAI_API_KEY)
+    openai_client = AsyncOpenAI(api_key=OPENAI_API_KEY)
     logger.info("✓ OpenAI client initialized")
 
 if GEMINI_API_KEY:
     genai.configure(api_key=GEMINI_API_KEY)
     logger.info("✓ Gemini client initialized")
 
-# Conversation context (simple in-memory storage)
-conversation_history = []
+# Concurrency limits - every provider call is awaited, so the event loop
+# keeps serving other devices; these only bound how much runs at once
+MAX_CONCURRENT_TURNS = int(os.getenv("MAX_CONCURRENT_TURNS", "16"))  # Turns talking to providers at once
+TURN_QUEUE_TIMEOUT_S = float(os.getenv("TURN_QUEUE_TIMEOUT_S", "10"))  # Wait for a slot before 503
+SESSION_IDLE_TTL_S = float(os.getenv("SESSION_IDLE_TTL_S", "3600"))  # Forget idle devices after this
+MAX_SESSIONS = int(os.getenv("MAX_SESSIONS", "1000"))
 MAX_HISTORY = 10
 
 
+@dataclass
+class DeviceSession:
+    """Conversation context and turn state of one device (in-memory)"""
+    history: List[dict] = field(default_factory=list)
+    busy: bool = False  # A turn is in flight, including its TTS stream
+    last_seen: float = field(default_factory=time.monotonic)
+
+
+sessions: "OrderedDict[str, DeviceSession]" = OrderedDict()  # Least recently seen first
+turn_slots = asyncio.Semaphore(MAX_CONCURRENT_TURNS)
+
+
+def device_id(request: Request) -> str:
+    """X-Device-ID header (the firmware sends its MAC), else the client address"""
+    return request.headers.get("x-device-id") or (request.client.host if request.client else "unknown")
+
+
+def get_session(device: str) -> DeviceSession:
+    """Session of a device, created on first use; idle sessions are evicted"""
+    now = time.monotonic()
+    while sessions:
+        oldest_id, oldest = next(iter(sessions.items()))
+        expired = now - oldest.last_seen > SESSION_IDLE_TTL_S
+        if not oldest.busy and (expired or len(sessions) >= MAX_SESSIONS):
+            del sessions[oldest_id]
+        else:
+            break
+
+    session = sessions.get(device)
+    if session is None:
+        session = sessions[device] = DeviceSession()
+    session.last_seen = now
+    sessions.move_to_end(device)
+    return session
+
+
+def trim_history(history: List[dict]) -> None:
+    if len(history) > MAX_HISTORY * 2:
+        history[:] = history[-MAX_HISTORY * 2:]
+
+# Uplink audio formats accepted by /api/voice, by Content-Type
+PCM_CONTENT_TYPES = ("application/octet-stream", "audio/pcm")
+ADPCM_CONTENT_TYPE = "audio/x-ima-adpcm"  # See voice_core/src/vc_adpcm.h
+UPLINK_CODECS = ["pcm16", "ima-adpcm"]
+DEFAULT_SAMPLE_RATE = 16000
+TTS_CHUNK_SIZE = 4096  # Even, so every chunk is whole samples
+
+# TTS request settings, also part of the cache key
+TTS_MODEL = "tts-1"   # or "tts-1-hd" for better quality
+TTS_VOICE = "alloy"   # alloy, echo, fable, onyx, nova, shimmer
+TTS_FORMAT = "pcm"    # Raw PCM 16-bit, 24kHz
+TTS_SPEED = 1.0
+TTS_CACHE_MAX_BYTES = int(os.getenv("TTS_CACHE_MAX_BYTES", str(32 * 1024 * 1024)))  # ~11 min of 24kHz PCM16
+TTS_CACHE_MAX_ENTRY = 1024 * 1024  # Longer replies are one-offs, not worth the room
+
+
+class TTSCache:
+    """
+    Synthesized audio by content (text, voice, format), least recently used
+    evicted first. Replies like "Sorry, I didn't catch that" come back often
+    and then cost neither a TTS call nor its latency.
+    """
+
+    def __init__(self, max_bytes: int):
+        self.max_bytes = max_bytes
+        self.size = 0
+        self.hits = 0
+        self.misses = 0
+        self.entries: "OrderedDict[str, bytes]" = OrderedDict()
+
+    @staticmethod
+    def key(text: str) -> str:
+        parts = (TTS_MODEL, TTS_VOICE, TTS_FORMAT, str(TTS_SPEED), text.strip())
+        return hashlib.sha256("\0".join(parts).encode("utf-8")).hexdigest()
+
+    def get(self, key: str) -> Optional[bytes]:
+        audio = self.entries.get(key)
+        if audio is None:
+            self.misses += 1
+            return None
+        self.hits += 1
+        self.entries.move_to_end(key)
+        return audio
+
+    def put(self, key: str, audio: bytes) -> None:
+        if len(audio) > min(TTS_CACHE_MAX_ENTRY, self.max_bytes) or key in self.entries:
+            return
+        self.entries[key] = audio
+        self.size += len(audio)
+        while self.size > self.max_bytes:
+            _, evicted = self.entries.popitem(last=False)
+            self.size -= len(evicted)
+
+    def stats(self) -> dict:
+        return {"entries": len(self.entries), "bytes": self.size, "hits": self.hits, "misses": self.misses}
+
+
+tts_cache = TTSCache(TTS_CACHE_MAX_BYTES)
+
+IMA_INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8] * 2
+IMA_STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+    11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+    32767,
+]
+
+
+def decode_ima_adpcm(data: bytes) -> bytes:
+    """Decode an IMA-ADPCM stream (high nibble first, initial state 0/0) to PCM16"""
+    if audioop:
+        return audioop.adpcm2lin(data, 2, None)[0]
+
+    out = array("h")
+    predictor, index = 0, 0
+    for byte in data:
+        for code in (byte >> 4, byte & 0x0F):
+            step = IMA_STEP_TABLE[index]
+            vpdiff = step >> 3
+            if code & 4:
+                vpdiff += step
+            if code & 2:
+                vpdiff += step >> 1
+            if code & 1:
+                vpdiff += step >> 2
+            predictor += -vpdiff if code & 8 else vpdiff
+            predictor = max(-32768, min(32767, predictor))
+            index = max(0, min(88, index + IMA_INDEX_TABLE[code]))
+            out.append(predictor)
+    if sys.byteorder == "big":
+        out.byteswap()
+    return out.tobytes()
+
+
+def parse_uplink_audio(content_type: str, body: bytes) -> Tuple[bytes, int]:
+    """Turn a /api/voice body into PCM16 and its sample rate, by Content-Type"""
+    media_type, _, params = content_type.partition(";")
+    media_type = media_type.strip().lower() or PCM_CONTENT_TYPES[0]
+    sample_rate = DEFAULT_SAMPLE_RATE
+    for param in params.split(";"):
+        key, _, value = param.partition("=")
+        if key.strip().lower() == "rate" and value.strip().isdigit():
+            sample_rate = int(value.strip())
+
+    if media_type in PCM_CONTENT_TYPES:
+        return body, sample_rate
+    if media_type == ADPCM_CONTENT_TYPE:
+        start = time.perf_counter()
+        pcm = decode_ima_adpcm(body)
+        logger.info(f"Decoded IMA-ADPCM: {len(body)} -> {len(pcm)} bytes "
+                    f"in {(time.perf_counter() - start) * 1000:.1f} ms")
+        return pcm, sample_rate
+    raise HTTPException(status_code=415, detail=f"Unsupported audio format: {media_type}")
+
+
 def convert_pcm_to_wav(pcm_data: bytes, sample_rate: int = 16000) -> bytes:
-    """Convert raw PCM to WAV format for Whisper API"""
-    audio = AudioSegment(
-        data=pcm_data,
-        sample_width=2,  # 16-bit
-        frame_rate=sample_rate,
-        channels=1
-    )
-    
+    """Convert raw PCM to WAV format for Whisper API (header only, no resampling)"""
     wav_buffer = io.BytesIO()
-    audio.export(wav_buffer, format="wav")
-    wav_buffer.seek(0)
-    return wav_buffer.read()
+    with wave.open(wav_buffer, "wb") as wav:
+        wav.setnchannels(1)
+        wav.setsampwidth(2)  # 16-bit
+        wav.setframerate(sample_rate)
+        wav.writeframes(pcm_data)
+    return wav_buffer.getvalue()
 
 
-def transcribe_audio(audio_data: bytes) -> Optional[str]:
+async def transcribe_audio(audio_data: bytes, sample_rate: int = DEFAULT_SAMPLE_RATE) -> Optional[str]:
     """Transcribe audio using OpenAI Whisper API"""
     if not openai_client:
         raise HTTPException(status_code=500, detail="OpenAI not configured")
     
     try:
         # Convert PCM to WAV
-        wav_data = convert_pcm_to_wav(audio_data)
+        wav_data = convert_pcm_to_wav(audio_data, sample_rate)
         
         # Create a file-like object
         audio_file = io.BytesIO(wav_data)
@@ -71,7 +244,7 @@ def transcribe_audio(audio_data: bytes) -> Optional[str]:
         
         # Transcribe with Whisper
         logger.info("Transcribing audio with Whisper...")
-        transcript = openai_client.audio.transcriptions.create(
+        transcript = await openai_client.audio.transcriptions.create(
             model="whisper-1",
             file=audio_file,
             response_format="text"
@@ -85,26 +258,25 @@ def transcribe_audio(audio_data: bytes) -> Optional[str]:
         raise HTTPException(status_code=500, detail=f"Transcription failed: {str(e)}")
 
 
-def get_ai_response_openai(user_text: str) -> str:
-    """Get AI response using OpenAI ChatGPT"""
+async def get_ai_response_openai(user_text: str, history: List[dict]) -> str:
+    """Get AI response using OpenAI ChatGPT, with the device's history"""
     if not openai_client:
         raise HTTPException(status_code=500, detail="OpenAI not configured")
     
     try:
         # Add user message to history
-        conversation_history.append({"role": "user", "content": user_text})
+        history.append({"role": "user", "content": user_text})
         
         # Trim history if too long
-        if len(conversation_history) > MAX_HISTORY * 2:
-            conversation_history[:] = conversation_history[-MAX_HISTORY * 2:]
+        trim_history(history)
         
         # Get response
         logger.info("Getting ChatGPT response...")
-        response = openai_client.chat.completions.create(
+        response = await openai_client.chat.completions.create(
             model="gpt-4o-mini",  # or "gpt-4" for better quality
             messages=[
                 {"role": "system", "content": "You are a helpful voice assistant. Keep responses concise and conversational."},
-                *conversation_history
+                *history
             ],
             max_tokens=150,
             temperature=0.7
@@ -114,7 +286,7 @@ def get_ai_response_openai(user_text: str) -> str:
         logger.info(f"AI Response: {ai_text}")
         
         # Add assistant response to history
-        conversation_history.append({"role": "assistant", "content": ai_text})
+        history.append({"role": "assistant", "content": ai_text})
         
         return ai_text
         
@@ -123,8 +295,8 @@ def get_ai_response_openai(user_text: str) -> str:
         raise HTTPException(status_code=500, detail=f"AI processing failed: {str(e)}")
 
 
-def get_ai_response_gemini(user_text: str) -> str:
-    """Get AI response using Google Gemini"""
+async def get_ai_response_gemini(user_text: str, history: List[dict]) -> str:
+    """Get AI response using Google Gemini, with the device's history"""
     if not GEMINI_API_KEY:
         raise HTTPException(status_code=500, detail="Gemini not configured")
     
@@ -135,7 +307,7 @@ def get_ai_response_gemini(user_text: str) -> str:
         # Build context from history
         context = "\n".join([
             f"{'User' if msg['role'] == 'user' else 'Assistant'}: {msg['content']}"
-            for msg in conversation_history[-6:]  # Last 3 exchanges
+            for msg in history[-6:]  # Last 3 exchanges
         ])
         
         prompt = f"""You are a helpful voice assistant. Keep responses concise and conversational.
@@ -147,17 +319,15 @@ User: {user_text}
 Assistant:"""
         
         logger.info("Getting Gemini response...")
-        response = model.generate_content(prompt)
+        response = await model.generate_content_async(prompt)
         ai_text = response.text
         
         logger.info(f"AI Response: {ai_text}")
         
         # Update history
-        conversation_history.append({"role": "user", "content": user_text})
-        conversation_history.append({"role": "assistant", "content": ai_text})
-        
-        if len(conversation_history) > MAX_HISTORY * 2:
-            conversation_history[:] = conversation_history[-MAX_HISTORY * 2:]
+        history.append({"role": "user", "content": user_text})
+        history.append({"role": "assistant", "content": ai_text})
+        trim_history(history)
         
         return ai_text
         
@@ -166,30 +336,139 @@ Assistant:"""
         raise HTTPException(status_code=500, detail=f"AI processing failed: {str(e)}")
 
 
-def text_to_speech(text: str) -> bytes:
-    """Convert text to speech using OpenAI TTS"""
+class SpeechStream:
+    """
+    TTS audio chunks. Unlike a bare async generator, aclose() also releases
+    the provider response when iteration never started (an async generator
+    that was never entered does not run its cleanup).
+    """
+    
+    def __init__(self, chunks: AsyncIterator[bytes], stack: Optional[AsyncExitStack] = None):
+        self.chunks = chunks
+        self.stack = stack
+    
+    def __aiter__(self) -> "SpeechStream":
+        return self
+    
+    async def __anext__(self) -> bytes:
+        return await self.chunks.__anext__()
+    
+    async def aclose(self) -> None:
+        await self.chunks.aclose()
+        if self.stack is not None:
+            await self.stack.aclose()
+
+
+class TurnResponse(StreamingResponse):
+    """
+    Streamed turn reply whose cleanup always runs: after the body, on a
+    hang-up mid-stream, and when the client is gone before the body starts
+    (where the body generator's own finally never would).
+    """
+    
+    def __init__(self, content: SpeechStream, cleanup: Callable[[], None], **kwargs):
+        super().__init__(content, **kwargs)
+        self.speech = content
+        self.cleanup = cleanup
+    
+    async def __call__(self, scope, receive, send) -> None:
+        try:
+            await super().__call__(scope, receive, send)
+        finally:
+            try:
+                await self.speech.aclose()
+            finally:
+                self.cleanup()
+
+
+async def cached_speech(audio: bytes) -> AsyncIterator[bytes]:
+    for offset in range(0, len(audio), TTS_CHUNK_SIZE):
+        yield audio[offset:offset + TTS_CHUNK_SIZE]
+
+
+async def text_to_speech_stream(text: str) -> SpeechStream:
+    """Stream speech from OpenAI TTS as raw PCM16 chunks while it is generated"""
+    key = TTSCache.key(text)
+    audio = tts_cache.get(key)
+    if audio is not None:
+        logger.info(f"TTS cache hit ({len(audio)} bytes)")
+        return SpeechStream(cached_speech(audio))
+    
     if not openai_client:
         raise HTTPException(status_code=500, detail="OpenAI TTS not configured")
     
+    # Open the request here so a failure still becomes an error status,
+    # before the streaming response has sent its headers
+    stack = AsyncExitStack()
     try:
         logger.info("Converting text to speech...")
-        response = openai_client.audio.speech.create(
-            model="tts-1",  # or "tts-1-hd" for better quality
-            voice="alloy",  # alloy, echo, fable, onyx, nova, shimmer
+        response = await stack.enter_async_context(openai_client.audio.speech.with_streaming_response.create(
+            model=TTS_MODEL,
+            voice=TTS_VOICE,
             input=text,
-            response_format="pcm",  # Raw PCM 16-bit
-            speed=1.0
-        )
-        
-        # The response is already PCM data
-        pcm_data = response.content
-        logger.info(f"Generated {len(pcm_data)} bytes of audio")
-        
-        return pcm_data
-        
+            response_format=TTS_FORMAT,
+            speed=TTS_SPEED
+        ))
     except Exception as e:
+        await stack.aclose()
         logger.error(f"TTS error: {e}")
         raise HTTPException(status_code=500, detail=f"TTS failed: {str(e)}")
+    
+    async def chunks() -> AsyncIterator[bytes]:
+        sent = 0
+        kept: Optional[List[bytes]] = []  # Copy for the cache, dropped once too long
+        async with stack:
+            try:
+                async for chunk in response.iter_bytes(TTS_CHUNK_SIZE):
+                    sent += len(chunk)
+                    if kept is not None:
+                        kept.append(chunk)
+                        if sent > TTS_CACHE_MAX_ENTRY:
+                            kept = None
+                    yield chunk
+            except Exception as e:
+                # Headers are gone already, the device sees a short body
+                logger.error(f"TTS stream error after {sent} bytes: {e}")
+                return
+        logger.info(f"Streamed {sent} bytes of audio")
+        # Only complete audio is cached: a device that hung up never gets here
+        if kept is not None:
+            tts_cache.put(key, b"".join(kept))
+    
+    return SpeechStream(chunks(), stack)
+
+
+async def acquire_turn(device: str) -> Callable[[], None]:
+    """
+    Admit one turn of a device, or refuse it:
+    429 while the device's previous turn is still running, 503 when every
+    provider slot stays taken for TURN_QUEUE_TIMEOUT_S.
+    Returns the (idempotent) release for when the turn, TTS stream included, ends.
+    """
+    session = get_session(device)
+    if session.busy:
+        raise HTTPException(status_code=429, detail="Previous turn still in progress",
+                            headers={"Retry-After": "1"})
+    session.busy = True
+    
+    try:
+        await asyncio.wait_for(turn_slots.acquire(), TURN_QUEUE_TIMEOUT_S)
+    except asyncio.TimeoutError:
+        session.busy = False
+        logger.warning(f"[{device}] No free turn slot after {TURN_QUEUE_TIMEOUT_S}s")
+        raise HTTPException(status_code=503, detail="Gateway busy", headers={"Retry-After": "2"})
+    
+    released = False
+    
+    def release() -> None:
+        nonlocal released
+        if not released:
+            released = True
+            session.busy = False
+            session.last_seen = time.monotonic()
+            turn_slots.release()
+    
+    return release
 
 
 @app.get("/")
@@ -200,7 +479,11 @@ async def root():
         "ai_provider": AI_PROVIDER,
         "tts_provider": TTS_PROVIDER,
         "openai_configured": bool(OPENAI_API_KEY),
-        "gemini_configured": bool(GEMINI_API_KEY)
+        "gemini_configured": bool(GEMINI_API_KEY),
+        "uplink_codecs": UPLINK_CODECS,
+        "sessions": len(sessions),
+        "active_turns": sum(1 for session in sessions.values() if session.busy),
+        "tts_cache": tts_cache.stats()
     }
 
 
@@ -208,58 +491,80 @@ async def root():
 async def process_voice(request: Request):
     """
     Main voice processing endpoint
-    Receives PCM audio, transcribes, gets AI response, returns TTS audio
+    Receives PCM16 (application/octet-stream) or IMA-ADPCM (audio/x-ima-adpcm)
+    audio, optionally with "; rate=<Hz>", transcribes, gets AI response,
+    and streams the TTS audio back (chunked) while it is being generated.
+    Conversation history is per device (X-Device-ID).
     """
+    device = device_id(request)
+    release = await acquire_turn(device)
+    audio_stream = None
     try:
-        # Read raw PCM audio data
-        audio_data = await request.body()
-        logger.info(f"Received {len(audio_data)} bytes of audio data")
+        start = time.perf_counter()
+        body = await request.body()
+        content_type = request.headers.get("content-type", "")
+        logger.info(f"[{device}] Received {len(body)} bytes of audio data ({content_type or 'no Content-Type'})")
         
+        # Decoding is CPU-bound in pure Python, keep it off the event loop
+        audio_data, sample_rate = await run_in_threadpool(parse_uplink_audio, content_type, body)
         if len(audio_data) < 1000:
             raise HTTPException(status_code=400, detail="Audio data too short")
         
         # Step 1: Transcribe audio to text
-        user_text = transcribe_audio(audio_data)
+        user_text = await transcribe_audio(audio_data, sample_rate)
         if not user_text or len(user_text.strip()) == 0:
             raise HTTPException(status_code=400, detail="Could not transcribe audio")
         
         # Step 2: Get AI response
+        history = get_session(device).history
         if AI_PROVIDER == "gemini":
-            ai_response = get_ai_response_gemini(user_text)
+            ai_response = await get_ai_response_gemini(user_text, history)
         else:
-            ai_response = get_ai_response_openai(user_text)
+            ai_response = await get_ai_response_openai(user_text, history)
+        
+        # Header values must be latin-1, so percent-encode the text (UTF-8)
+        headers = {
+            "X-Transcription": quote(user_text[:200]),  # Send back what was heard
+            "X-AI-Response": quote(ai_response[:200])   # Send back what AI said
+        }
         
-        # Step 3: Convert response to speech
-        audio_response = text_to_speech(ai_response)
+        # Step 3: Convert response to speech, forwarded as it arrives
+        audio_stream = await text_to_speech_stream(ai_response)
+        logger.info(f"[{device}] First audio after {(time.perf_counter() - start) * 1000:.0f} ms")
         
-        # Return audio as PCM
-        return Response(
-            content=audio_response,
+        # Return audio as PCM; the turn ends with the stream, or when the device hangs up
+        return TurnResponse(
+            audio_stream,
+            release,
             media_type="application/octet-stream",
-            headers={
-                "X-Transcription": user_text[:200],  # Send back what was heard
-                "X-AI-Response": ai_response[:200]   # Send back what AI said
-            }
+            headers=headers
         )
         
     except HTTPException:
+        if audio_stream is not None:
+            await audio_stream.aclose()
+        release()
         raise
     except Exception as e:
-        logger.error(f"Voice processing error: {e}", exc_info=True)
+        if audio_stream is not None:
+            await audio_stream.aclose()
+        release()
+        logger.error(f"[{device}] Voice processing error: {e}", exc_info=True)
         raise HTTPException(status_code=500, detail=str(e))
 
 
 @app.post("/api/clear-history")
-async def clear_history():
-    """Clear conversation history"""
-    conversation_history.clear()
+async def clear_history(request: Request):
+    """Clear the calling device's conversation history"""
+    get_session(device_id(request)).history.clear()
     return {"status": "cleared"}
 
 
 @app.get("/api/history")
-async def get_history():
-    """Get conversation history (for debugging)"""
-    return {"history": conversation_history}
+async def get_history(request: Request):
+    """Get the calling device's conversation history (for debugging)"""
+    device = device_id(request)
+    return {"device": device, "history": get_session(device).history}
 
 
 if __name__ == "__main__":
@@ -274,6 +579,7 @@ if __name__ == "__main__":
     logger.info("Voice AI Gateway Server Starting")
     logger.info(f"AI Provider: {AI_PROVIDER.upper()}")
     logger.info(f"TTS Provider: {TTS_PROVIDER.upper()}")
+    logger.info(f"Max concurrent turns: {MAX_CONCURRENT_TURNS}")
     logger.info("=" * 50)
     
     uvicorn.run(app, host="0.0.0.0", port=8000)
@@ -0,0 +1,76 @@
+"""
+Render the ESP-IDF firmware's canned prompts into a flash image
+
+The clips are synthesized once with OpenAI TTS (24kHz PCM16, the firmware's
+PLAYBACK_SAMPLE_RATE) and packed in the layout prompt_store.c reads from the
+"prompts" partition. Flash the result with:
+
+    python render_prompts.py prompts.bin
+    parttool.py --port <port> write_partition --partition-name prompts --input prompts.bin
+"""
+
+import os
+import struct
+import sys
+from openai import OpenAI
+
+# Keys are the names in prompt_store.c, values what the device says
+PROMPTS = {
+    "ready": "Ready.",
+    "not_heard": "Sorry, I didn't catch that.",
+    "error": "Something went wrong. Please try again.",
+}
+
+SAMPLE_RATE = 24000  # OpenAI TTS "pcm" format
+PARTITION_SIZE = 0x80000  # See platformio-espidf/partitions.csv
+MAGIC = b"VCPR"
+VERSION = 1
+NAME_LEN = 16
+HEADER = struct.Struct("<4sHHI")
+ENTRY = struct.Struct(f"<{NAME_LEN}sII")
+
+
+def synthesize(client: OpenAI, text: str) -> bytes:
+    response = client.audio.speech.create(
+        model="tts-1",
+        voice="alloy",
+        input=text,
+        response_format="pcm",
+        speed=1.0
+    )
+    return response.content
+
+
+def build_image(clips: dict) -> bytes:
+    base = HEADER.size + ENTRY.size * len(clips)
+    entries = []
+    data = bytearray()
+    for name, audio in clips.items():
+        data += bytes(-(base + len(data)) % 4)  # Clips are read in place as int16
+        entries.append(ENTRY.pack(name.encode("ascii"), base + len(data), len(audio)))
+        data += audio
+
+    image = HEADER.pack(MAGIC, VERSION, len(clips), SAMPLE_RATE) + b"".join(entries) + bytes(data)
+    if len(image) > PARTITION_SIZE:
+        raise SystemExit(f"Prompts need {len(image)} bytes, the partition holds {PARTITION_SIZE}")
+    return image
+
+
+def main():
+    output = sys.argv[1] if len(sys.argv) > 1 else "prompts.bin"
+    client = OpenAI(api_key=os.getenv("OPENAI_API_KEY", ""))
+
+    clips = {}
+    for name, text in PROMPTS.items():
+        assert len(name) < NAME_LEN, name
+        clips[name] = synthesize(client, text)
+        print(f"{name}: {len(clips[name]) / 2 / SAMPLE_RATE:.2f} s  \"{text}\"")
+
+    image = build_image(clips)
+    with open(output, "wb") as f:
+        f.write(image)
+    print(f"Wrote {output}: {len(image)} of {PARTITION_SIZE} bytes")
+
+
+if __name__ == "__main__":
+    main()
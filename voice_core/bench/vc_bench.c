@@ -0,0 +1,433 @@
+/**
+ * voice_core micro-benchmarks
+ *
+ * Each case runs one operation of a hot path on a buffer the size the
+ * firmware uses (a 1024-sample mic chunk, a 256-sample playback chunk, a
+ * 2 KB upload chunk, an 8 KB audio delta). The iteration count doubles
+ * until a run lasts BENCH_MIN_NS, and the best of BENCH_REPEATS runs is
+ * reported, so one preemption does not skew a line.
+ *
+ * On the host time comes from CLOCK_MONOTONIC. Under ESP-IDF it comes from
+ * the CPU cycle counter, and cycles per sample are printed as well - that
+ * is the number to compare between builds before flashing a fleet.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "vc_bench.h"
+#include "vc_adpcm.h"
+#include "vc_base64.h"
+#include "vc_chat_stream.h"
+#include "vc_echo_gate.h"
+#include "vc_json_extract.h"
+#include "vc_kws.h"
+#include "vc_mfcc.h"
+#include "vc_pcm.h"
+#include "vc_realtime.h"
+#include "vc_resample.h"
+#include "vc_upload.h"
+#include "vc_vad.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#define BENCH_MIN_NS    20000000ull     // 20 ms per run, well inside the 32-bit cycle counter
+#else
+#include <time.h>
+#define BENCH_MIN_NS    50000000ull
+#endif
+
+#define BENCH_REPEATS   3
+#define BENCH_MAX_ITERS (1u << 24)
+
+#define MIC_CHUNK       1024            // Samples per mic read
+#define PLAY_CHUNK      256             // Samples per I2S write
+#define UPLOAD_CHUNK    2048            // PCM bytes per HTTP chunk
+#define DELTA_PCM       6144            // PCM bytes in one Realtime audio delta (~8 KB as base64)
+#define KWS_HOP         160             // 16 kHz samples per wake word frame
+#define KWS_EXAMPLE     100             // Frames per enrolled example (1 s)
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);    // Once, outside the timing (may be NULL)
+    void (*run)(void);      // One operation
+    size_t samples;         // Audio samples per operation (0 if not sample based)
+    size_t bytes;           // Input bytes per operation
+} bench_case_t;
+
+static volatile uint32_t s_sink;    // Keeps results observable
+
+// Fixtures
+static int16_t s_mic[MIC_CHUNK];
+static uint32_t s_frames[PLAY_CHUNK];
+static int16_t s_out[MIC_CHUNK + 2];
+static uint8_t s_adpcm[VC_ADPCM_BYTES(MIC_CHUNK) + 1];
+static uint8_t s_bytes[DELTA_PCM];
+static char s_b64[VC_BASE64_ENCODED_LEN(DELTA_PCM) + 1];
+static size_t s_b64_len;
+static char s_text[VC_RT_APPEND_FRAME_SIZE(DELTA_PCM) + 64];
+static size_t s_text_len;
+static char s_upload[VC_CHUNK_HEADER + UPLOAD_CHUNK + VC_CHUNK_TRAILER];
+
+static vc_resampler_t s_resampler;
+static vc_vad_t s_vad;
+static vc_adpcm_state_t s_adpcm_state;
+static vc_chat_stream_t s_chat;
+static vc_mfcc_t s_mfcc;
+static vc_kws_t s_kws;
+static vc_kws_example_t s_examples[VC_KWS_MAX_EXAMPLES];
+static int8_t s_feat[VC_KWS_DIM];
+
+/**
+ * Speech-like test signal: noise under a slow envelope, deterministic
+ */
+static void fill_signal(int16_t *out, size_t count, uint32_t seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int32_t noise = (int16_t)(seed >> 16);
+        int32_t envelope = (int32_t)((i * 7) % 512) - 256;
+        envelope = envelope < 0 ? -envelope : envelope;     // Triangle, 0..256
+        out[i] = (int16_t)(noise * envelope / 512);
+    }
+}
+
+static uint64_t now_ticks(void)
+{
+#ifdef ESP_PLATFORM
+    return esp_cpu_get_cycle_count();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/**
+ * Ticks between two now_ticks() readings, in ns
+ */
+static double ticks_to_ns(uint64_t ticks)
+{
+#ifdef ESP_PLATFORM
+    return (double)ticks * 1000.0 / esp_rom_get_cpu_ticks_per_us();
+#else
+    return (double)ticks;
+#endif
+}
+
+static uint64_t elapsed_ticks(uint64_t start, uint64_t end)
+{
+#ifdef ESP_PLATFORM
+    return (uint32_t)((uint32_t)end - (uint32_t)start);    // The cycle counter wraps
+#else
+    return end - start;
+#endif
+}
+
+// ---- Cases -----------------------------------------------------------------
+
+static void setup_signal(void)
+{
+    fill_signal(s_mic, MIC_CHUNK, 1);
+}
+
+static void run_mono_to_stereo(void)
+{
+    vc_pcm_mono_to_stereo(s_frames, s_mic, PLAY_CHUNK);
+    s_sink += s_frames[PLAY_CHUNK - 1];
+}
+
+static void setup_resample(void)
+{
+    setup_signal();
+    vc_resampler_init(&s_resampler, 24000, 16000);
+}
+
+static void run_resample(void)
+{
+    s_sink += vc_resampler_process(&s_resampler, s_mic, MIC_CHUNK, s_out);
+}
+
+static void setup_vad(void)
+{
+    setup_signal();
+    vc_vad_config_t cfg = vc_vad_default_config(24000);
+    vc_vad_init(&s_vad, &cfg);
+}
+
+static void run_vad(void)
+{
+    s_sink += vc_vad_process(&s_vad, s_mic, MIC_CHUNK);
+}
+
+static void setup_mfcc(void)
+{
+    setup_signal();
+    vc_mfcc_init(&s_mfcc, 16000);
+    const int16_t *in = s_mic;
+    size_t count = 400 - KWS_HOP;     // A frame minus one hop buffered, each run completes one
+    float coeffs[VC_MFCC_COEFFS];
+    vc_mfcc_frame(&s_mfcc, &in, &count, coeffs);
+}
+
+static void run_mfcc(void)
+{
+    const int16_t *in = s_mic;
+    size_t count = KWS_HOP;
+    float coeffs[VC_MFCC_COEFFS];
+    s_sink += vc_mfcc_frame(&s_mfcc, &in, &count, coeffs);
+}
+
+static void setup_kws(void)
+{
+    // Three 1 s examples of pseudo-random features; the cost is the same whatever they hold
+    uint32_t seed = 7;
+    vc_kws_config_t cfg = { .threshold = 1, .confirm_frames = 5 };
+    vc_kws_init(&s_kws, &cfg);
+    for (int e = 0; e < VC_KWS_MAX_EXAMPLES; e++) {
+        s_examples[e].frames = KWS_EXAMPLE;
+        for (int f = 0; f < KWS_EXAMPLE; f++) {
+            for (int c = 0; c < VC_KWS_DIM; c++) {
+                seed = seed * 1664525u + 1013904223u;
+                s_examples[e].feat[f][c] = (int8_t)(seed >> 24);
+            }
+        }
+        vc_kws_add_example(&s_kws, &s_examples[e]);
+    }
+    memcpy(s_feat, s_examples[0].feat[KWS_EXAMPLE / 2], VC_KWS_DIM);
+}
+
+static void run_kws(void)
+{
+    s_sink += vc_kws_process(&s_kws, s_feat);
+}
+
+static void run_echo_level(void)
+{
+    s_sink += vc_echo_gate_level(s_mic, MIC_CHUNK);
+}
+
+static void run_adpcm_encode(void)
+{
+    vc_adpcm_init(&s_adpcm_state);
+    s_sink += vc_adpcm_encode(&s_adpcm_state, s_mic, MIC_CHUNK, s_adpcm);
+}
+
+static void setup_adpcm_decode(void)
+{
+    setup_signal();
+    run_adpcm_encode();
+}
+
+static void run_adpcm_decode(void)
+{
+    vc_adpcm_init(&s_adpcm_state);
+    s_sink += vc_adpcm_decode(&s_adpcm_state, s_adpcm, VC_ADPCM_BYTES(MIC_CHUNK), s_out);
+}
+
+static void setup_bytes(void)
+{
+    int16_t *pcm = (int16_t *)s_bytes;
+    fill_signal(pcm, DELTA_PCM / sizeof(int16_t), 2);
+    s_b64_len = vc_base64_encode(s_b64, sizeof(s_b64), s_bytes, DELTA_PCM);
+}
+
+static void run_base64_encode(void)
+{
+    s_sink += vc_base64_encode(s_b64, sizeof(s_b64), s_bytes, UPLOAD_CHUNK);
+}
+
+static void run_base64_decode(void)
+{
+    s_sink += vc_base64_decode(s_bytes, sizeof(s_bytes), s_b64, s_b64_len);
+}
+
+static void run_base64_stream(void)
+{
+    // Pieces where a fragment boundary lands: never on a group boundary
+    vc_base64_decoder_t dec;
+    vc_base64_decoder_init(&dec);
+    size_t done = 0;
+    while (done < s_b64_len) {
+        size_t n = s_b64_len - done < 1365 ? s_b64_len - done : 1365;
+        s_sink += vc_base64_decoder_update(&dec, s_bytes, sizeof(s_bytes), s_b64 + done, n);
+        done += n;
+    }
+}
+
+static void run_rt_append(void)
+{
+    s_sink += vc_rt_append_fill(s_text, sizeof(s_text), s_mic, MIC_CHUNK * sizeof(int16_t));
+}
+
+static void setup_rt_append(void)
+{
+    setup_signal();
+    vc_rt_append_init(s_text);
+}
+
+static void setup_rt_delta(void)
+{
+    setup_bytes();
+    s_text_len = (size_t)snprintf(s_text, sizeof(s_text),
+                                  "{\"type\":\"response.audio.delta\",\"event_id\":\"event_A1\","
+                                  "\"response_id\":\"resp_B2\",\"item_id\":\"item_C3\","
+                                  "\"output_index\":0,\"content_index\":0,\"delta\":\"%s\"}", s_b64);
+}
+
+static void run_rt_route(void)
+{
+    size_t len = 0;
+    if (vc_rt_sniff(s_text, s_text_len) == VC_RT_EVENT_AUDIO_DELTA) {
+        s_sink += (uint32_t)(uintptr_t)vc_rt_find_string(s_text, s_text_len, "delta", &len);
+    }
+    s_sink += len;
+}
+
+static const char s_chat_body[] =
+    "{\"id\":\"chatcmpl-123\",\"object\":\"chat.completion\",\"created\":1700000000,"
+    "\"model\":\"gpt-4o-mini\",\"system_fingerprint\":\"fp_0123456789\","
+    "\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\",\"content\":"
+    "\"Sure. The forecast for today is mostly sunny with a high of 22 degrees and a light "
+    "breeze from the west. Expect clouds to roll in after sunset, with a chance of rain "
+    "overnight. Tomorrow looks cooler, around 17 degrees, so bring a jacket if you head out "
+    "early. Is there anything else you would like to know?\"},"
+    "\"logprobs\":null,\"finish_reason\":\"stop\"}],"
+    "\"usage\":{\"prompt_tokens\":42,\"completion_tokens\":73,\"total_tokens\":115}}";
+
+static void run_json_extract(void)
+{
+    static char value[1024];
+    vc_json_extractor_t ex;
+    vc_json_extractor_init_buffer(&ex, "choices[0].message.content", value, sizeof(value));
+    // Fed the way HTTP_EVENT_ON_DATA delivers it
+    const size_t len = sizeof(s_chat_body) - 1;
+    for (size_t done = 0; done < len && ex.status == VC_JSON_MORE; done += 128) {
+        vc_json_extractor_feed(&ex, s_chat_body + done, len - done < 128 ? len - done : 128);
+    }
+    s_sink += ex.status;
+}
+
+static void chat_sentence(const char *sentence, size_t len, void *arg)
+{
+    (void)sentence;
+    (void)arg;
+    s_sink += len;
+}
+
+#define SSE(token) "data: {\"id\":\"c\",\"object\":\"chat.completion.chunk\",\"choices\":[{\"index\":0," \
+                   "\"delta\":{\"content\":\"" token "\"},\"finish_reason\":null}]}\n\n"
+static const char s_sse[] =
+    SSE("Sure") SSE(".") SSE(" The") SSE(" forecast") SSE(" for") SSE(" today") SSE(" is")
+    SSE(" mostly") SSE(" sunny") SSE(" with") SSE(" a") SSE(" high") SSE(" of") SSE(" 22")
+    SSE(" degrees") SSE(".") SSE(" Bring") SSE(" a") SSE(" jacket") SSE(" tonight") SSE("!")
+    "data: [DONE]\n\n";
+
+static void run_chat_stream(void)
+{
+    vc_chat_stream_init(&s_chat, chat_sentence, NULL);
+    vc_chat_stream_feed(&s_chat, s_sse, sizeof(s_sse) - 1);
+    vc_chat_stream_flush(&s_chat);
+    vc_chat_stream_free(&s_chat);
+}
+
+static void run_upload_frame(void)
+{
+    vc_wav_header((uint8_t *)s_upload + VC_CHUNK_HEADER, VC_WAV_STREAMING_SIZE, 16000);
+    s_sink += vc_chunk_frame(s_upload, UPLOAD_CHUNK);
+}
+
+static const bench_case_t s_cases[] = {
+    { "pcm_mono_to_stereo",   setup_signal,       run_mono_to_stereo, PLAY_CHUNK, PLAY_CHUNK * 2 },
+    { "resample_24k_16k",     setup_resample,     run_resample,       MIC_CHUNK,  MIC_CHUNK * 2 },
+    { "vad_process",          setup_vad,          run_vad,            MIC_CHUNK,  MIC_CHUNK * 2 },
+    { "echo_gate_level",      setup_signal,       run_echo_level,     MIC_CHUNK,  MIC_CHUNK * 2 },
+    { "mfcc_frame",           setup_mfcc,         run_mfcc,           KWS_HOP,    KWS_HOP * 2 },
+    { "kws_frame_3x1s",       setup_kws,          run_kws,            KWS_HOP,    VC_KWS_DIM },
+    { "adpcm_encode",         setup_signal,       run_adpcm_encode,   MIC_CHUNK,  MIC_CHUNK * 2 },
+    { "adpcm_decode",         setup_adpcm_decode, run_adpcm_decode,   MIC_CHUNK,  VC_ADPCM_BYTES(MIC_CHUNK) },
+    { "base64_encode_2k",     setup_bytes,        run_base64_encode,  UPLOAD_CHUNK / 2, UPLOAD_CHUNK },
+    { "base64_decode_delta",  setup_bytes,        run_base64_decode,  DELTA_PCM / 2, VC_BASE64_ENCODED_LEN(DELTA_PCM) },
+    { "base64_stream_delta",  setup_bytes,        run_base64_stream,  DELTA_PCM / 2, VC_BASE64_ENCODED_LEN(DELTA_PCM) },
+    { "rt_append_fill",       setup_rt_append,    run_rt_append,      MIC_CHUNK,  MIC_CHUNK * 2 },
+    { "rt_route_delta",       setup_rt_delta,     run_rt_route,       DELTA_PCM / 2, VC_RT_APPEND_FRAME_SIZE(DELTA_PCM) },
+    { "json_extract_chat",    NULL,               run_json_extract,   0,          sizeof(s_chat_body) - 1 },
+    { "chat_stream_sse",      NULL,               run_chat_stream,    0,          sizeof(s_sse) - 1 },
+    { "upload_frame",         NULL,               run_upload_frame,   0,          UPLOAD_CHUNK },
+};
+
+// ---- Harness ---------------------------------------------------------------
+
+/**
+ * Best time of one operation, in ns
+ */
+static double measure(const bench_case_t *c)
+{
+    uint32_t iterations = 1;
+    uint64_t ticks = 0;
+    for (;;) {
+        uint64_t start = now_ticks();
+        for (uint32_t i = 0; i < iterations; i++) {
+            c->run();
+        }
+        ticks = elapsed_ticks(start, now_ticks());
+        if (ticks_to_ns(ticks) >= BENCH_MIN_NS || iterations >= BENCH_MAX_ITERS) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    uint64_t best = ticks;
+    for (int r = 1; r < BENCH_REPEATS; r++) {
+        uint64_t start = now_ticks();
+        for (uint32_t i = 0; i < iterations; i++) {
+            c->run();
+        }
+        ticks = elapsed_ticks(start, now_ticks());
+        best = ticks < best ? ticks : best;
+    }
+    return ticks_to_ns(best) / iterations;
+}
+
+int vc_bench_run(const char *filter)
+{
+#ifdef ESP_PLATFORM
+    printf("vc_bench: ESP-IDF, cycle counter at %lu MHz\n", (unsigned long)esp_rom_get_cpu_ticks_per_us());
+    printf("%-22s %12s %12s %12s %10s\n", "case", "ns/op", "ns/sample", "cycles/smp", "MB/s");
+#else
+    printf("vc_bench: host, CLOCK_MONOTONIC\n");
+    printf("%-22s %12s %12s %10s\n", "case", "ns/op", "ns/sample", "MB/s");
+#endif
+
+    int ran = 0;
+    for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+        const bench_case_t *c = &s_cases[i];
+        if (filter && filter[0] && !strstr(c->name, filter)) {
+            continue;
+        }
+        if (c->setup) {
+            c->setup();
+        }
+
+        double ns = measure(c);
+        double mb_per_s = c->bytes * 1000.0 / ns;   // bytes/ns * 1e9 / 1e6
+#ifdef ESP_PLATFORM
+        if (c->samples) {
+            double cycles = ns * esp_rom_get_cpu_ticks_per_us() / 1000.0;
+            printf("%-22s %12.1f %12.2f %12.1f %10.2f\n", c->name, ns, ns / c->samples,
+                   cycles / c->samples, mb_per_s);
+        } else {
+            printf("%-22s %12.1f %12s %12s %10.2f\n", c->name, ns, "-", "-", mb_per_s);
+        }
+#else
+        if (c->samples) {
+            printf("%-22s %12.1f %12.2f %10.2f\n", c->name, ns, ns / c->samples, mb_per_s);
+        } else {
+            printf("%-22s %12.1f %12s %10.2f\n", c->name, ns, "-", mb_per_s);
+        }
+#endif
+        ran++;
+    }
+    return ran;
+}
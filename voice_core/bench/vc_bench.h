@@ -0,0 +1,25 @@
+/**
+ * voice_core micro-benchmarks
+ * The audio and protocol hot paths timed on the host (ns) or on the ESP32
+ * (CPU cycle counter), one line per case on stdout
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run every case whose name contains filter (NULL or "" runs all)
+ *
+ * On ESP-IDF call it before Wi-Fi starts, so radio interrupts do not land
+ * in the measurements.
+ *
+ * @return Number of cases run
+ */
+int vc_bench_run(const char *filter);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+/**
+ * Host entry point for vc_bench
+ *
+ *     cmake -S voice_core -B build && cmake --build build
+ *     ./build/vc_bench [filter]
+ */
+
+#include <stdio.h>
+#include "vc_bench.h"
+
+int main(int argc, char **argv)
+{
+    int ran = vc_bench_run(argc > 1 ? argv[1] : NULL);
+    if (ran == 0) {
+        fprintf(stderr, "No benchmark matches \"%s\"\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
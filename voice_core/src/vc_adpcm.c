@@ -0,0 +1,129 @@
+/**
+ * IMA-ADPCM codec
+ *
+ * Each nibble is the quantised difference to a predictor, in units of an
+ * adaptive step that grows on large differences and shrinks on small ones.
+ * The arithmetic is the reference IMA/DVI one (shifts and adds only), so
+ * the stream decodes bit-exactly with audioop or any WAV IMA decoder.
+ */
+
+#include "vc_adpcm.h"
+
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+void vc_adpcm_init(vc_adpcm_state_t *st)
+{
+    st->predictor = 0;
+    st->index = 0;
+    st->half = false;
+    st->pending = 0;
+}
+
+static void advance(vc_adpcm_state_t *st, uint8_t code, int32_t vpdiff)
+{
+    int32_t p = st->predictor + ((code & 8) ? -vpdiff : vpdiff);
+    st->predictor = p > INT16_MAX ? INT16_MAX : p < INT16_MIN ? INT16_MIN : p;
+
+    int index = st->index + index_table[code];
+    st->index = index < 0 ? 0 : index > 88 ? 88 : (uint8_t)index;
+}
+
+static uint8_t encode_sample(vc_adpcm_state_t *st, int16_t sample)
+{
+    int32_t step = step_table[st->index];
+    int32_t diff = sample - st->predictor;
+    uint8_t code = 0;
+    if (diff < 0) {
+        code = 8;
+        diff = -diff;
+    }
+
+    int32_t vpdiff = step >> 3;
+    if (diff >= step) {
+        code |= 4;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    advance(st, code, vpdiff);
+    return code;
+}
+
+static int16_t decode_nibble(vc_adpcm_state_t *st, uint8_t code)
+{
+    int32_t step = step_table[st->index];
+    int32_t vpdiff = step >> 3;
+    if (code & 4) {
+        vpdiff += step;
+    }
+    if (code & 2) {
+        vpdiff += step >> 1;
+    }
+    if (code & 1) {
+        vpdiff += step >> 2;
+    }
+
+    advance(st, code, vpdiff);
+    return (int16_t)st->predictor;
+}
+
+size_t vc_adpcm_encode(vc_adpcm_state_t *st, const int16_t *pcm, size_t count, uint8_t *out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t code = encode_sample(st, pcm[i]);
+        if (st->half) {
+            out[n++] = st->pending | code;
+            st->half = false;
+        } else {
+            st->pending = (uint8_t)(code << 4);
+            st->half = true;
+        }
+    }
+    return n;
+}
+
+size_t vc_adpcm_encode_flush(vc_adpcm_state_t *st, uint8_t *out)
+{
+    if (!st->half) {
+        return 0;
+    }
+    out[0] = st->pending;
+    st->half = false;
+    return 1;
+}
+
+size_t vc_adpcm_decode(vc_adpcm_state_t *st, const uint8_t *in, size_t len, int16_t *out)
+{
+    for (size_t i = 0; i < len; i++) {
+        out[2 * i] = decode_nibble(st, in[i] >> 4);
+        out[2 * i + 1] = decode_nibble(st, in[i] & 0x0f);
+    }
+    return 2 * len;
+}
@@ -0,0 +1,64 @@
+/**
+ * IMA-ADPCM codec
+ * 4 bits per PCM16 sample, first sample of a byte in the high nibble
+ * (the layout of Python's audioop.lin2adpcm / adpcm2lin)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_ADPCM_CONTENT_TYPE "audio/x-ima-adpcm"   /*!< Media type of a raw stream from the initial state */
+
+/**
+ * @brief Encoded bytes for a stream of samples (last byte padded if odd)
+ */
+#define VC_ADPCM_BYTES(samples) (((samples) + 1) / 2)
+
+/**
+ * @brief Codec state - treat as opaque, one per direction and stream
+ */
+typedef struct {
+    int32_t predictor;
+    uint8_t index;
+    bool half;          // Encoder: the high nibble in pending waits for its partner
+    uint8_t pending;
+} vc_adpcm_state_t;
+
+/**
+ * @brief Start a stream (predictor 0, step index 0)
+ */
+void vc_adpcm_init(vc_adpcm_state_t *st);
+
+/**
+ * @brief Encode the next count samples (any split of the stream is fine)
+ *
+ * @param[out] out Room for VC_ADPCM_BYTES(count) bytes; may be the pcm
+ *                 buffer itself, output never overtakes input
+ * @return Whole bytes written (a trailing odd sample waits in st)
+ */
+size_t vc_adpcm_encode(vc_adpcm_state_t *st, const int16_t *pcm, size_t count, uint8_t *out);
+
+/**
+ * @brief Write out a trailing odd sample, padded with a zero nibble
+ *
+ * @return Bytes written (0 or 1)
+ */
+size_t vc_adpcm_encode_flush(vc_adpcm_state_t *st, uint8_t *out);
+
+/**
+ * @brief Decode len bytes into 2 * len samples
+ *
+ * @return Samples written
+ */
+size_t vc_adpcm_decode(vc_adpcm_state_t *st, const uint8_t *in, size_t len, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
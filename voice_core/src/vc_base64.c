@@ -0,0 +1,230 @@
+/**
+ * Base64 codec for audio frames
+ *
+ * Works a group at a time (3 bytes <-> 4 characters) through lookup tables,
+ * four groups per loop iteration on the bulk path. A 1KB mic frame encodes
+ * without a single heap allocation or per-character append.
+ */
+
+#include "vc_base64.h"
+
+static const char s_encode[64] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz"
+    "0123456789+/";
+
+// 0xFF marks characters outside the alphabet, including '='
+static const uint8_t s_decode[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+/**
+ * 3 bytes -> 4 characters
+ */
+static inline void encode_group(char *out, const uint8_t *in)
+{
+    uint32_t v = ((uint32_t)in[0] << 16) | ((uint32_t)in[1] << 8) | in[2];
+    out[0] = s_encode[v >> 18];
+    out[1] = s_encode[(v >> 12) & 0x3F];
+    out[2] = s_encode[(v >> 6) & 0x3F];
+    out[3] = s_encode[v & 0x3F];
+}
+
+/**
+ * 4 characters -> 3 bytes. All four are read before anything is written,
+ * which is what makes in-place decoding safe.
+ */
+static inline bool decode_group(uint8_t *out, const char *in)
+{
+    uint32_t a = s_decode[(uint8_t)in[0]];
+    uint32_t b = s_decode[(uint8_t)in[1]];
+    uint32_t c = s_decode[(uint8_t)in[2]];
+    uint32_t d = s_decode[(uint8_t)in[3]];
+    if ((a | b | c | d) & 0x80) {
+        return false;
+    }
+    uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+    out[0] = (uint8_t)(v >> 16);
+    out[1] = (uint8_t)(v >> 8);
+    out[2] = (uint8_t)v;
+    return true;
+}
+
+/**
+ * Final group, which may carry one or two '=' padding characters
+ *
+ * @return Bytes written (1-3), or 0 if the group is malformed
+ */
+static size_t decode_final_group(uint8_t *out, const char *in)
+{
+    if (in[3] != '=') {
+        return decode_group(out, in) ? 3 : 0;
+    }
+
+    uint32_t a = s_decode[(uint8_t)in[0]];
+    uint32_t b = s_decode[(uint8_t)in[1]];
+    uint32_t c = in[2] == '=' ? 0 : s_decode[(uint8_t)in[2]];
+    if ((a | b | c) & 0x80) {
+        return 0;
+    }
+    uint32_t v = (a << 18) | (b << 12) | (c << 6);
+    out[0] = (uint8_t)(v >> 16);
+    if (in[2] == '=') {
+        return 1;
+    }
+    out[1] = (uint8_t)(v >> 8);
+    return 2;
+}
+
+size_t vc_base64_encode(char *dst, size_t dst_size, const void *src, size_t len)
+{
+    size_t out_len = VC_BASE64_ENCODED_LEN(len);
+    if (dst_size < out_len) {
+        return VC_BASE64_ERROR;
+    }
+
+    const uint8_t *in = (const uint8_t *)src;
+    char *out = dst;
+
+    for (; len >= 12; len -= 12, in += 12, out += 16) {
+        encode_group(out, in);
+        encode_group(out + 4, in + 3);
+        encode_group(out + 8, in + 6);
+        encode_group(out + 12, in + 9);
+    }
+    for (; len >= 3; len -= 3, in += 3, out += 4) {
+        encode_group(out, in);
+    }
+
+    if (len) {
+        uint32_t v = (uint32_t)in[0] << 16;
+        if (len == 2) {
+            v |= (uint32_t)in[1] << 8;
+        }
+        out[0] = s_encode[v >> 18];
+        out[1] = s_encode[(v >> 12) & 0x3F];
+        out[2] = len == 2 ? s_encode[(v >> 6) & 0x3F] : '=';
+        out[3] = '=';
+    }
+    return out_len;
+}
+
+size_t vc_base64_decode(uint8_t *dst, size_t dst_size, const char *src, size_t len)
+{
+    if (len % 4) {
+        return VC_BASE64_ERROR;
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    size_t pad = src[len - 1] == '=' ? (src[len - 2] == '=' ? 2 : 1) : 0;
+    size_t out_len = (len / 4) * 3 - pad;
+    if (dst_size < out_len) {
+        return VC_BASE64_ERROR;
+    }
+
+    // Groups before the last one never contain padding ('=' decodes as invalid)
+    size_t groups = len / 4 - 1;
+    const char *in = src;
+    uint8_t *out = dst;
+
+    for (; groups >= 4; groups -= 4, in += 16, out += 12) {
+        if (!decode_group(out, in) || !decode_group(out + 3, in + 4) ||
+            !decode_group(out + 6, in + 8) || !decode_group(out + 9, in + 12)) {
+            return VC_BASE64_ERROR;
+        }
+    }
+    for (; groups; groups--, in += 4, out += 3) {
+        if (!decode_group(out, in)) {
+            return VC_BASE64_ERROR;
+        }
+    }
+
+    return decode_final_group(out, in) ? out_len : VC_BASE64_ERROR;
+}
+
+void vc_base64_decoder_init(vc_base64_decoder_t *dec)
+{
+    dec->count = 0;
+    dec->finished = false;
+}
+
+size_t vc_base64_decoder_update(vc_base64_decoder_t *dec, uint8_t *dst, size_t dst_size,
+                                const char *src, size_t len)
+{
+    if (len == 0) {
+        return 0;
+    }
+    if (dec->finished || dst_size < VC_BASE64_DECODED_MAX(dec->count + len)) {
+        return VC_BASE64_ERROR;
+    }
+
+    uint8_t *out = dst;
+
+    // Complete the group left over from the previous piece
+    if (dec->count) {
+        while (dec->count < 4 && len) {
+            dec->quad[dec->count++] = *src++;
+            len--;
+        }
+        if (dec->count < 4) {
+            return 0;
+        }
+        dec->count = 0;
+
+        size_t n = decode_final_group(out, dec->quad);
+        if (n == 0) {
+            return VC_BASE64_ERROR;
+        }
+        out += n;
+        if (n < 3) {
+            dec->finished = true;
+            return len ? VC_BASE64_ERROR : (size_t)(out - dst);
+        }
+    }
+
+    // Bulk path - stops short of any group that could hold padding
+    for (; len >= 16 && src[15] != '='; len -= 16, src += 16, out += 12) {
+        if (!decode_group(out, src) || !decode_group(out + 3, src + 4) ||
+            !decode_group(out + 6, src + 8) || !decode_group(out + 9, src + 12)) {
+            return VC_BASE64_ERROR;
+        }
+    }
+    for (; len >= 4; len -= 4, src += 4) {
+        size_t n = decode_final_group(out, src);
+        if (n == 0) {
+            return VC_BASE64_ERROR;
+        }
+        out += n;
+        if (n < 3) {
+            dec->finished = true;
+            return len > 4 ? VC_BASE64_ERROR : (size_t)(out - dst);
+        }
+    }
+
+    for (; len; len--) {
+        dec->quad[dec->count++] = *src++;
+    }
+    return (size_t)(out - dst);
+}
+
+bool vc_base64_decoder_finish(const vc_base64_decoder_t *dec)
+{
+    return dec->count == 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * Base64 codec for audio frames
+ * Encodes and decodes into caller-provided buffers, no heap allocation
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Returned by the codec functions when the input is malformed or the output buffer is too small */
+#define VC_BASE64_ERROR ((size_t)-1)
+
+/** Encoded size of n bytes, without a terminator */
+#define VC_BASE64_ENCODED_LEN(n) ((((n) + 2) / 3) * 4)
+
+/** Upper bound of the decoded size of n base64 characters */
+#define VC_BASE64_DECODED_MAX(n) (((n) / 4) * 3)
+
+/**
+ * @brief Encode bytes as base64 (no terminator is written)
+ *
+ * @param[out] dst      Output, at least VC_BASE64_ENCODED_LEN(len) bytes
+ * @param[in]  dst_size Size of dst
+ * @param[in]  src      Input bytes
+ * @param[in]  len      Number of input bytes
+ * @return Number of characters written, or VC_BASE64_ERROR if dst is too small
+ */
+size_t vc_base64_encode(char *dst, size_t dst_size, const void *src, size_t len);
+
+/**
+ * @brief Decode a complete base64 string
+ *
+ * dst may be the same buffer as src, so a string received in a mutable
+ * buffer can be decoded in place.
+ *
+ * @param[out] dst      Output, at least VC_BASE64_DECODED_MAX(len) bytes
+ * @param[in]  dst_size Size of dst
+ * @param[in]  src      Base64 characters (length must be a multiple of 4)
+ * @param[in]  len      Number of characters
+ * @return Number of bytes written, or VC_BASE64_ERROR on malformed input or a short dst
+ */
+size_t vc_base64_decode(uint8_t *dst, size_t dst_size, const char *src, size_t len);
+
+/**
+ * @brief Incremental decoder for base64 that arrives in arbitrary pieces
+ */
+typedef struct {
+    char quad[4];       /*!< Characters carried over from the previous piece */
+    uint8_t count;      /*!< Number of valid characters in quad */
+    bool finished;      /*!< Padding has been seen, no more input is allowed */
+} vc_base64_decoder_t;
+
+/**
+ * @brief Reset a decoder for a new base64 string
+ */
+void vc_base64_decoder_init(vc_base64_decoder_t *dec);
+
+/**
+ * @brief Decode the next piece of a base64 string
+ *
+ * Up to three trailing characters that do not complete a group are kept
+ * in the decoder and consumed with the next piece. dst must not overlap src.
+ *
+ * @param[out] dst      Output, at least VC_BASE64_DECODED_MAX(len + 3) bytes
+ * @param[in]  dst_size Size of dst
+ * @return Number of bytes written, or VC_BASE64_ERROR on malformed input or a short dst
+ */
+size_t vc_base64_decoder_update(vc_base64_decoder_t *dec, uint8_t *dst, size_t dst_size,
+                                const char *src, size_t len);
+
+/**
+ * @brief Check that the string ended on a group boundary
+ *
+ * @return true if no characters are left over
+ */
+bool vc_base64_decoder_finish(const vc_base64_decoder_t *dec);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,201 @@
+/**
+ * Streaming chat completion parser
+ *
+ * Each SSE event is a "data:" line holding one chat.completion.chunk. The
+ * line is fed straight into an extractor for choices[0].delta.content, and
+ * the token text is appended to a sentence buffer that is handed to the
+ * caller at every sentence boundary. Nothing is buffered per line, and all
+ * storage lives in the parser struct.
+ */
+
+#include <string.h>
+#include "vc_chat_stream.h"
+
+#define SSE_PREFIX      "data:"
+#define SSE_PREFIX_LEN  5
+#define DELTA_PATH      "choices[0].delta.content"
+#define SENTENCE_MIN    8       // "Dr." or "1." alone are not worth a TTS request
+
+enum {
+    SSE_LINE_START,  // Matching "data:"
+    SSE_DATA_START,  // Skipping the space after "data:"
+    SSE_DATA,        // Feeding the JSON of the event to the extractor
+    SSE_SKIP,        // Comment, other field or [DONE] - ignore to end of line
+};
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static void emit(vc_chat_stream_t *cs)
+{
+    while (cs->sentence_len && is_space(cs->sentence[cs->sentence_len - 1])) {
+        cs->sentence_len--;
+    }
+    if (cs->sentence_len) {
+        cs->sentence[cs->sentence_len] = '\0';
+        cs->cb(cs->sentence, cs->sentence_len, cs->arg);
+        cs->sentences++;
+    }
+    cs->sentence_len = 0;
+    cs->pending_stop = false;
+}
+
+/**
+ * Sentence buffer full - cut at the last space so no word is split
+ */
+static void emit_overflow(vc_chat_stream_t *cs)
+{
+    size_t cut = cs->sentence_len;
+    while (cut && cs->sentence[cut - 1] != ' ') {
+        cut--;
+    }
+    if (cut == 0) {
+        emit(cs);
+        return;
+    }
+
+    size_t rest = cs->sentence_len - cut;
+    char tail[VC_CHAT_SENTENCE_MAX];
+    memcpy(tail, cs->sentence + cut, rest);
+    cs->sentence_len = cut;
+    emit(cs);
+    memcpy(cs->sentence, tail, rest);
+    cs->sentence_len = rest;
+}
+
+/**
+ * Append token text, emitting at sentence boundaries
+ */
+static void append_text(vc_chat_stream_t *cs, const char *text, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        char c = text[i];
+
+        if (c == '\n') {
+            emit(cs);
+            continue;
+        }
+        if (cs->pending_stop && is_space(c)) {
+            char stop = cs->sentence[cs->sentence_len - 1];
+            if (stop != '.' || cs->sentence_len >= SENTENCE_MIN) {
+                emit(cs);
+                continue;
+            }
+        }
+        if (cs->sentence_len == 0 && is_space(c)) {
+            continue;
+        }
+        if (cs->sentence_len == VC_CHAT_SENTENCE_MAX) {
+            emit_overflow(cs);
+        }
+
+        cs->sentence[cs->sentence_len++] = c;
+        cs->pending_stop = c == '.' || c == '!' || c == '?';
+    }
+}
+
+static void end_event(vc_chat_stream_t *cs)
+{
+    size_t len;
+    const char *delta = vc_json_extractor_value(&cs->ex, &len);
+    if (delta && len) {
+        append_text(cs, delta, len);
+    }
+    cs->state = SSE_LINE_START;
+    cs->prefix_pos = 0;
+}
+
+bool vc_chat_stream_init(vc_chat_stream_t *cs, vc_chat_sentence_cb_t cb, void *arg)
+{
+    memset(cs, 0, sizeof(*cs));
+    cs->cb = cb;
+    cs->arg = arg;
+    cs->state = SSE_LINE_START;
+    return vc_json_extractor_init_buffer(&cs->ex, DELTA_PATH, cs->delta, sizeof(cs->delta));
+}
+
+void vc_chat_stream_feed(vc_chat_stream_t *cs, const char *data, size_t len)
+{
+    const char *p = data;
+    const char *end = data + len;
+
+    while (p < end) {
+        char c = *p;
+
+        switch (cs->state) {
+            case SSE_LINE_START:
+                if (c == '\n' || c == '\r') {
+                    cs->prefix_pos = 0;
+                } else if (c == SSE_PREFIX[cs->prefix_pos]) {
+                    if (++cs->prefix_pos == SSE_PREFIX_LEN) {
+                        cs->state = SSE_DATA_START;
+                    }
+                } else {
+                    cs->state = SSE_SKIP;
+                }
+                p++;
+                break;
+
+            case SSE_DATA_START:
+                if (c == ' ') {
+                    p++;
+                } else if (c == '\n') {
+                    cs->state = SSE_LINE_START;
+                    cs->prefix_pos = 0;
+                    p++;
+                } else if (c == '[') {
+                    cs->done = true;  // data: [DONE]
+                    cs->state = SSE_SKIP;
+                } else {
+                    vc_json_extractor_reset(&cs->ex);
+                    cs->state = SSE_DATA;
+                }
+                break;
+
+            case SSE_DATA: {
+                const char *nl = memchr(p, '\n', (size_t)(end - p));
+                const char *run_end = nl ? nl : end;
+                if (cs->ex.status == VC_JSON_MORE) {
+                    vc_json_extractor_feed(&cs->ex, p, (size_t)(run_end - p));
+                }
+                p = run_end;
+                if (nl) {
+                    end_event(cs);
+                    p++;
+                }
+                break;
+            }
+
+            case SSE_SKIP: {
+                const char *nl = memchr(p, '\n', (size_t)(end - p));
+                if (!nl) {
+                    return;
+                }
+                cs->state = SSE_LINE_START;
+                cs->prefix_pos = 0;
+                p = nl + 1;
+                break;
+            }
+        }
+    }
+}
+
+void vc_chat_stream_flush(vc_chat_stream_t *cs)
+{
+    if (cs->state == SSE_DATA) {
+        end_event(cs);  // Body ended without a trailing newline
+    }
+    emit(cs);
+}
+
+bool vc_chat_stream_done(const vc_chat_stream_t *cs)
+{
+    return cs->done;
+}
+
+void vc_chat_stream_free(vc_chat_stream_t *cs)
+{
+    vc_json_extractor_free(&cs->ex);
+}
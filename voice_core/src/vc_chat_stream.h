@@ -0,0 +1,71 @@
+/**
+ * Streaming chat completion parser
+ * Turns the Server-Sent Events of a "stream": true chat completion into
+ * whole sentences as soon as each one is complete
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vc_json_extract.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_CHAT_SENTENCE_MAX 320    /*!< Longer runs are cut at the last space */
+#define VC_CHAT_DELTA_MAX    1024   /*!< Longest token text taken from one event */
+
+/**
+ * @brief Called for every complete sentence (terminated, valid until the callback returns)
+ */
+typedef void (*vc_chat_sentence_cb_t)(const char *sentence, size_t len, void *arg);
+
+/**
+ * @brief Parser state - treat as opaque (self-contained, the parser never allocates)
+ */
+typedef struct {
+    vc_json_extractor_t ex;     // choices[0].delta.content of the current event
+    char delta[VC_CHAT_DELTA_MAX + 1];
+    uint8_t state;
+    uint8_t prefix_pos;
+    bool done;                  // "data: [DONE]" seen
+    bool pending_stop;          // Last character was . ! or ?
+    char sentence[VC_CHAT_SENTENCE_MAX + 1];
+    size_t sentence_len;
+    size_t sentences;
+    vc_chat_sentence_cb_t cb;
+    void *arg;
+} vc_chat_stream_t;
+
+/**
+ * @brief Prepare a parser for one streamed completion
+ *
+ * @return false if the extractor could not be set up
+ */
+bool vc_chat_stream_init(vc_chat_stream_t *cs, vc_chat_sentence_cb_t cb, void *arg);
+
+/**
+ * @brief Feed the next piece of the SSE body (any split is fine)
+ */
+void vc_chat_stream_feed(vc_chat_stream_t *cs, const char *data, size_t len);
+
+/**
+ * @brief Emit whatever text is left as a final sentence
+ */
+void vc_chat_stream_flush(vc_chat_stream_t *cs);
+
+/**
+ * @brief true once the server has sent "data: [DONE]"
+ */
+bool vc_chat_stream_done(const vc_chat_stream_t *cs);
+
+/**
+ * @brief Release the parser (nothing is allocated, kept for symmetry with init)
+ */
+void vc_chat_stream_free(vc_chat_stream_t *cs);
+
+#ifdef __cplusplus
+}
+#endif
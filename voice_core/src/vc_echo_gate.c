@@ -0,0 +1,57 @@
+/**
+ * Echo gate
+ *
+ * The ATOM Echo's mic and speaker share GPIO 33, so the two never run at
+ * the same time and there is nothing for an adaptive canceller to learn
+ * from. What reaches the mic is the end of the speaker's output still
+ * ringing in the room and the amplifier when the bus switches over, which
+ * is enough to look like the start of speech to the VAD. The gate compares
+ * each frame with the level last played, scaled by the coupling and fading
+ * over the tail, and lets through only what is louder than that.
+ */
+
+#include "vc_echo_gate.h"
+
+void vc_echo_gate_init(vc_echo_gate_t *gate, uint32_t sample_rate, uint16_t tail_ms, uint16_t coupling_q8)
+{
+    gate->tail_samples = sample_rate / 1000 * tail_ms;
+    gate->coupling_q8 = coupling_q8;
+    gate->echo_level = 0;
+    gate->remaining = 0;
+}
+
+void vc_echo_gate_arm(vc_echo_gate_t *gate, uint16_t playback_level)
+{
+    gate->echo_level = ((uint32_t)playback_level * gate->coupling_q8) >> 8;
+    gate->remaining = gate->echo_level ? gate->tail_samples : 0;
+}
+
+uint16_t vc_echo_gate_level(const int16_t *samples, size_t count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        int32_t s = samples[i];
+        sum += (uint32_t)(s < 0 ? -s : s);
+    }
+    return (uint16_t)(sum / count);
+}
+
+bool vc_echo_gate_is_echo(vc_echo_gate_t *gate, const int16_t *samples, size_t count)
+{
+    if (gate->remaining == 0) {
+        return false;
+    }
+
+    // Expected echo at the start of this frame, fading linearly to 0
+    uint32_t limit = (uint32_t)((uint64_t)gate->echo_level * gate->remaining / gate->tail_samples);
+    if (vc_echo_gate_level(samples, count) > limit) {
+        gate->remaining = 0;
+        return false;
+    }
+
+    gate->remaining = count < gate->remaining ? gate->remaining - (uint32_t)count : 0;
+    return true;
+}
@@ -0,0 +1,60 @@
+/**
+ * Echo gate
+ * Drops mic frames that are no louder than the expected tail of the
+ * speaker's last output, right after the I2S bus switched back to the mic
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Gate state - treat as opaque
+ */
+typedef struct {
+    uint32_t tail_samples;  // Length of the echo tail the gate covers
+    uint16_t coupling_q8;   // Mic level per unit of playback level, Q8
+    uint32_t echo_level;    // Expected echo when armed (mean absolute sample)
+    uint32_t remaining;     // Samples of the tail still to come, 0 = gate open
+} vc_echo_gate_t;
+
+/**
+ * @brief Prepare a gate (open until armed)
+ *
+ * @param[in] tail_ms     How long the speaker's echo fades for (room and amplifier)
+ * @param[in] coupling_q8 Speaker-to-mic gain, 256 = echo as loud as the playback
+ */
+void vc_echo_gate_init(vc_echo_gate_t *gate, uint32_t sample_rate, uint16_t tail_ms, uint16_t coupling_q8);
+
+/**
+ * @brief Start a tail at the switch from speaker to mic
+ *
+ * @param[in] playback_level Mean absolute sample of the audio played last, 0 leaves the gate open
+ */
+void vc_echo_gate_arm(vc_echo_gate_t *gate, uint16_t playback_level);
+
+/**
+ * @brief Check the next mic frame against the fading echo
+ *
+ * The expected echo falls linearly to nothing over the tail. The first
+ * frame louder than that opens the gate for the rest of the turn, so
+ * speech that starts inside the tail is not chopped.
+ *
+ * @return true if the frame is no more than echo and should be dropped
+ */
+bool vc_echo_gate_is_echo(vc_echo_gate_t *gate, const int16_t *samples, size_t count);
+
+/**
+ * @brief Mean absolute sample of a frame (the level both sides are measured in)
+ */
+uint16_t vc_echo_gate_level(const int16_t *samples, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
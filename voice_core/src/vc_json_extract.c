@@ -0,0 +1,520 @@
+/**
+ * Incremental JSON string extraction
+ *
+ * A byte-at-a-time scanner that only tracks what is needed to know where it
+ * is in the document: the nesting, whether each open level is still on the
+ * target path, and the current array index or key comparison. Only the
+ * characters of the target string are stored, so memory use depends on the
+ * answer, not on the size of the response around it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "vc_json_extract.h"
+
+enum {
+    ST_VALUE,       // Expecting a value (or ']' right after '[')
+    ST_KEY_START,   // Expecting '"' of a key (or '}' right after '{')
+    ST_KEY,         // Inside a key
+    ST_COLON,       // After a key
+    ST_STRING,      // Inside a string value
+    ST_LITERAL,     // Inside a number, true, false or null
+    ST_AFTER_VALUE, // Expecting ',' or a closing bracket
+    ST_FINISHED,    // Status is final
+};
+
+static bool is_ws(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static vc_json_status_t fail(vc_json_extractor_t *ex, vc_json_status_t status)
+{
+    ex->status = status;
+    ex->state = ST_FINISHED;
+    return status;
+}
+
+bool vc_json_extractor_init(vc_json_extractor_t *ex, const char *path, size_t max_len)
+{
+    memset(ex, 0, sizeof(*ex));
+    ex->max_len = max_len;
+
+    const char *p = path;
+    while (*p) {
+        if (ex->path_len == VC_JSON_MAX_PATH) {
+            return false;
+        }
+        vc_json_segment_t *seg = &ex->path[ex->path_len++];
+
+        if (*p == '[') {
+            char *end;
+            unsigned long index = strtoul(p + 1, &end, 10);
+            if (end == p + 1 || *end != ']' || index > UINT16_MAX) {
+                return false;
+            }
+            seg->key = NULL;
+            seg->index = (uint16_t)index;
+            p = end + 1;
+        } else {
+            size_t n = strcspn(p, ".[");
+            if (n == 0 || n > UINT16_MAX) {
+                return false;
+            }
+            seg->key = p;
+            seg->key_len = (uint16_t)n;
+            p += n;
+        }
+        if (*p == '.') {
+            p++;
+        }
+    }
+
+    vc_json_extractor_reset(ex);
+    return ex->path_len > 0;
+}
+
+bool vc_json_extractor_init_buffer(vc_json_extractor_t *ex, const char *path, char *buf, size_t buf_size)
+{
+    if (!buf || buf_size == 0) {
+        return false;
+    }
+    bool ok = vc_json_extractor_init(ex, path, buf_size - 1);
+    ex->value = buf;
+    ex->value_cap = buf_size;
+    ex->external = true;
+    ex->value[0] = '\0';
+    return ok;
+}
+
+void vc_json_extractor_reset(vc_json_extractor_t *ex)
+{
+    ex->state = ST_VALUE;
+    ex->depth = 0;
+    ex->array_bits = 0;
+    ex->capturing = false;
+    ex->esc = 0;
+    ex->high_surrogate = 0;
+    ex->status = VC_JSON_MORE;
+    ex->value_len = 0;
+    ex->truncated = false;
+    if (ex->value) {
+        ex->value[0] = '\0';
+    }
+}
+
+/**
+ * Level n's current member can only be on the path if every level above it is
+ */
+static bool parent_on_path(const vc_json_extractor_t *ex, uint8_t level)
+{
+    return level == 0 || (level <= VC_JSON_MAX_PATH && ex->match[level - 1]);
+}
+
+static void update_array_match(vc_json_extractor_t *ex)
+{
+    uint8_t level = ex->depth - 1;
+    if (level >= ex->path_len) {
+        return;
+    }
+    const vc_json_segment_t *seg = &ex->path[level];
+    ex->match[level] = parent_on_path(ex, level) && !seg->key && seg->index == ex->index[level];
+}
+
+static bool reserve(vc_json_extractor_t *ex, size_t extra)
+{
+    size_t need = ex->value_len + extra + 1;
+    if (need <= ex->value_cap) {
+        return true;
+    }
+    if (ex->external) {
+        return false;
+    }
+    size_t cap = ex->value_cap ? ex->value_cap * 2 : 64;
+    if (cap < need) {
+        cap = need;
+    }
+    if (cap > ex->max_len + 1) {
+        cap = ex->max_len + 1;
+    }
+    char *value = realloc(ex->value, cap);
+    if (!value) {
+        return false;
+    }
+    ex->value = value;
+    ex->value_cap = cap;
+    return true;
+}
+
+/**
+ * Append decoded bytes of the target value
+ */
+static bool emit(vc_json_extractor_t *ex, const char *bytes, size_t n)
+{
+    if (ex->value_len + n > ex->max_len) {
+        n = ex->max_len - ex->value_len;
+        ex->truncated = true;
+    }
+    if (n == 0) {
+        return true;
+    }
+    if (!reserve(ex, n)) {
+        return false;
+    }
+    memcpy(ex->value + ex->value_len, bytes, n);
+    ex->value_len += n;
+    ex->value[ex->value_len] = '\0';
+    return true;
+}
+
+/**
+ * Route decoded bytes of a key or string value
+ */
+static bool string_byte(vc_json_extractor_t *ex, const char *bytes, size_t n)
+{
+    if (ex->state == ST_KEY) {
+        if (ex->key_ok) {
+            const vc_json_segment_t *seg = &ex->path[ex->depth - 1];
+            ex->key_ok = ex->key_pos + n <= seg->key_len && memcmp(seg->key + ex->key_pos, bytes, n) == 0;
+        }
+        ex->key_pos += (uint16_t)n;
+        return true;
+    }
+    return ex->capturing ? emit(ex, bytes, n) : true;
+}
+
+static size_t utf8_encode(char *out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/**
+ * Finish a \uXXXX escape, pairing surrogates
+ */
+static bool unicode_escape(vc_json_extractor_t *ex)
+{
+    uint32_t cp = ex->code;
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        ex->high_surrogate = cp;
+        return true;
+    }
+    if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        cp = ex->high_surrogate ? 0x10000 + ((ex->high_surrogate - 0xD800) << 10) + (cp - 0xDC00) : 0xFFFD;
+    }
+    ex->high_surrogate = 0;
+
+    char utf8[4];
+    return string_byte(ex, utf8, utf8_encode(utf8, cp));
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * One character inside an escape sequence
+ */
+static bool escape_char(vc_json_extractor_t *ex, char c)
+{
+    if (ex->esc == 1) {
+        char out;
+        switch (c) {
+            case 'n': out = '\n'; break;
+            case 't': out = '\t'; break;
+            case 'r': out = '\r'; break;
+            case 'b': out = '\b'; break;
+            case 'f': out = '\f'; break;
+            case 'u':
+                ex->esc = 2;
+                ex->code = 0;
+                return true;
+            default:  out = c; break;  // \" \\ \/
+        }
+        ex->esc = 0;
+        return string_byte(ex, &out, 1);
+    }
+
+    int h = hex_value(c);
+    if (h < 0) {
+        return false;
+    }
+    ex->code = (ex->code << 4) | (uint32_t)h;
+    if (++ex->esc < 6) {
+        return true;
+    }
+    ex->esc = 0;
+    return unicode_escape(ex);
+}
+
+static void open_container(vc_json_extractor_t *ex, bool is_array)
+{
+    uint8_t level = ex->depth++;
+    if (is_array) {
+        ex->array_bits |= 1u << level;
+    } else {
+        ex->array_bits &= ~(1u << level);
+    }
+    if (level < VC_JSON_MAX_PATH) {
+        ex->match[level] = false;
+        ex->index[level] = 0;
+    }
+    if (is_array) {
+        update_array_match(ex);
+        ex->state = ST_VALUE;
+    } else {
+        ex->state = ST_KEY_START;
+    }
+}
+
+/**
+ * A value just ended at the current depth
+ */
+static void value_done(vc_json_extractor_t *ex)
+{
+    ex->state = ex->depth == 0 ? ST_FINISHED : ST_AFTER_VALUE;
+    if (ex->depth == 0) {
+        ex->status = VC_JSON_END;
+    }
+}
+
+static bool in_array(const vc_json_extractor_t *ex)
+{
+    return ex->depth > 0 && (ex->array_bits & (1u << (ex->depth - 1)));
+}
+
+vc_json_status_t vc_json_extractor_feed(vc_json_extractor_t *ex, const char *data, size_t len)
+{
+    const char *p = data;
+    const char *end = data + len;
+
+    while (p < end && ex->state != ST_FINISHED) {
+        char c = *p;
+
+        switch (ex->state) {
+            case ST_VALUE:
+                if (is_ws(c)) {
+                    break;
+                }
+                if (c == '"') {
+                    ex->capturing = ex->depth > 0 && ex->depth == ex->path_len && ex->match[ex->depth - 1];
+                    if (ex->capturing) {
+                        if (!reserve(ex, 0)) {
+                            return fail(ex, VC_JSON_ERROR);
+                        }
+                        ex->value[0] = '\0';
+                    }
+                    ex->state = ST_STRING;
+                } else if (c == '{' || c == '[') {
+                    if (ex->depth == VC_JSON_MAX_DEPTH) {
+                        return fail(ex, VC_JSON_ERROR);
+                    }
+                    open_container(ex, c == '[');
+                } else if (c == ']' && in_array(ex)) {
+                    ex->depth--;  // Empty array
+                    value_done(ex);
+                } else {
+                    ex->state = ST_LITERAL;
+                }
+                break;
+
+            case ST_KEY_START:
+                if (is_ws(c)) {
+                    break;
+                }
+                if (c == '"') {
+                    uint8_t level = ex->depth - 1;
+                    ex->key_ok = level < ex->path_len && ex->path[level].key && parent_on_path(ex, level);
+                    ex->key_pos = 0;
+                    ex->state = ST_KEY;
+                } else if (c == '}') {
+                    ex->depth--;  // Empty object
+                    value_done(ex);
+                } else {
+                    return fail(ex, VC_JSON_ERROR);
+                }
+                break;
+
+            case ST_KEY:
+            case ST_STRING: {
+                if (ex->esc) {
+                    if (!escape_char(ex, c)) {
+                        return fail(ex, VC_JSON_ERROR);
+                    }
+                    break;
+                }
+                if (c == '\\') {
+                    ex->esc = 1;
+                    break;
+                }
+                if (c == '"') {
+                    if (ex->state == ST_KEY) {
+                        uint8_t level = ex->depth - 1;
+                        if (level < VC_JSON_MAX_PATH) {
+                            ex->match[level] = ex->key_ok && ex->key_pos == ex->path[level].key_len;
+                        }
+                        ex->state = ST_COLON;
+                    } else if (ex->capturing) {
+                        ex->capturing = false;
+                        return fail(ex, VC_JSON_FOUND);
+                    } else {
+                        value_done(ex);
+                    }
+                    break;
+                }
+
+                // Plain run - hand it over in one piece
+                const char *run = p;
+                while (p < end && *p != '"' && *p != '\\') {
+                    p++;
+                }
+                if (!string_byte(ex, run, (size_t)(p - run))) {
+                    return fail(ex, VC_JSON_ERROR);
+                }
+                continue;
+            }
+
+            case ST_COLON:
+                if (is_ws(c)) {
+                    break;
+                }
+                if (c != ':') {
+                    return fail(ex, VC_JSON_ERROR);
+                }
+                ex->state = ST_VALUE;
+                break;
+
+            case ST_LITERAL:
+                if (c != ',' && c != ']' && c != '}' && !is_ws(c)) {
+                    break;
+                }
+                value_done(ex);
+                continue;  // Delimiter belongs to the enclosing level
+
+            case ST_AFTER_VALUE:
+                if (is_ws(c)) {
+                    break;
+                }
+                if (c == ',') {
+                    if (in_array(ex)) {
+                        uint8_t level = ex->depth - 1;
+                        if (level < VC_JSON_MAX_PATH) {
+                            ex->index[level]++;
+                        }
+                        update_array_match(ex);
+                        ex->state = ST_VALUE;
+                    } else {
+                        ex->state = ST_KEY_START;
+                    }
+                } else if ((c == ']' && in_array(ex)) || (c == '}' && !in_array(ex))) {
+                    ex->depth--;
+                    value_done(ex);
+                } else {
+                    return fail(ex, VC_JSON_ERROR);
+                }
+                break;
+        }
+        p++;
+    }
+
+    return ex->status;
+}
+
+const char *vc_json_extractor_value(const vc_json_extractor_t *ex, size_t *len)
+{
+    if (len) {
+        *len = ex->value_len;
+    }
+    return ex->status == VC_JSON_FOUND || ex->capturing ? ex->value : NULL;
+}
+
+char *vc_json_extractor_take(vc_json_extractor_t *ex)
+{
+    if (ex->external) {
+        return NULL;
+    }
+    char *value = (char *)vc_json_extractor_value(ex, NULL);
+    if (value) {
+        ex->value = NULL;
+        ex->value_cap = 0;
+        ex->value_len = 0;
+    }
+    return value;
+}
+
+void vc_json_extractor_free(vc_json_extractor_t *ex)
+{
+    if (ex->external) {
+        return;
+    }
+    free(ex->value);
+    ex->value = NULL;
+    ex->value_cap = 0;
+    ex->value_len = 0;
+}
+
+size_t vc_json_escape(char *dst, size_t dst_size, const char *src, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t out = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)src[i];
+        char seq[6];
+        size_t n;
+
+        switch (c) {
+            case '"':  seq[0] = '\\'; seq[1] = '"';  n = 2; break;
+            case '\\': seq[0] = '\\'; seq[1] = '\\'; n = 2; break;
+            case '\n': seq[0] = '\\'; seq[1] = 'n';  n = 2; break;
+            case '\r': seq[0] = '\\'; seq[1] = 'r';  n = 2; break;
+            case '\t': seq[0] = '\\'; seq[1] = 't';  n = 2; break;
+            default:
+                if (c < 0x20) {
+                    memcpy(seq, "\\u00", 4);
+                    seq[4] = hex[c >> 4];
+                    seq[5] = hex[c & 0xF];
+                    n = 6;
+                } else {
+                    seq[0] = (char)c;
+                    n = 1;
+                }
+                break;
+        }
+
+        if (dst) {
+            if (out + n > dst_size) {
+                return VC_JSON_ESCAPE_ERROR;
+            }
+            memcpy(dst + out, seq, n);
+        }
+        out += n;
+    }
+
+    if (dst && out < dst_size) {
+        dst[out] = '\0';
+    }
+    return out;
+}
@@ -0,0 +1,136 @@
+/**
+ * Incremental JSON string extraction
+ * Pulls one string field out of a JSON document fed in arbitrary chunks,
+ * without building a DOM or buffering the document
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_JSON_MAX_PATH   8    /*!< Segments in a target path */
+#define VC_JSON_MAX_DEPTH  32   /*!< Nesting the scanner can follow */
+
+/**
+ * @brief Result of feeding a chunk
+ */
+typedef enum {
+    VC_JSON_MORE = 0,   /*!< Target not complete yet, feed more data */
+    VC_JSON_FOUND,      /*!< Target string fully extracted, the rest of the input is ignored */
+    VC_JSON_END,        /*!< Document ended without the target (or it was not a string) */
+    VC_JSON_ERROR,      /*!< Malformed input, nesting too deep or out of memory */
+} vc_json_status_t;
+
+typedef struct {
+    const char *key;    /*!< Member name (not terminated), NULL for an array index */
+    uint16_t key_len;
+    uint16_t index;     /*!< Array index when key is NULL */
+} vc_json_segment_t;
+
+/**
+ * @brief Extractor state - treat as opaque
+ */
+typedef struct {
+    // Target
+    vc_json_segment_t path[VC_JSON_MAX_PATH];
+    uint8_t path_len;
+
+    // Scanner
+    uint8_t state;
+    uint8_t depth;
+    uint32_t array_bits;                // Bit n set when level n is an array
+    bool match[VC_JSON_MAX_PATH];       // Current member/element of level n is on the path
+    uint16_t index[VC_JSON_MAX_PATH];   // Current element of array levels
+    bool capturing;
+    bool key_ok;
+    uint16_t key_pos;
+    uint8_t esc;                        // 0, 1 after '\', 2-5 reading \u digits
+    uint32_t code;
+    uint32_t high_surrogate;
+    vc_json_status_t status;
+
+    // Output
+    char *value;
+    size_t value_len;
+    size_t value_cap;
+    size_t max_len;
+    bool truncated;
+    bool external;                      // value belongs to the caller, never reallocated or freed
+} vc_json_extractor_t;
+
+#define VC_JSON_ESCAPE_ERROR ((size_t)-1)
+
+/**
+ * @brief Prepare an extractor for one target
+ *
+ * @param[out] ex      Extractor
+ * @param[in]  path    Dotted path with array indices, e.g. "choices[0].message.content".
+ *                     Must stay valid while the extractor is used.
+ * @param[in]  max_len Longest value kept; longer values are cut and flagged as truncated
+ * @return false if the path is malformed or too long
+ */
+bool vc_json_extractor_init(vc_json_extractor_t *ex, const char *path, size_t max_len);
+
+/**
+ * @brief Prepare an extractor that stores the value in a caller-provided buffer
+ *
+ * The extractor never allocates; values longer than buf_size - 1 are cut and
+ * flagged as truncated. vc_json_extractor_take() returns NULL for such an
+ * extractor, read the value with vc_json_extractor_value() instead.
+ *
+ * @param[out] ex       Extractor
+ * @param[in]  path     As for vc_json_extractor_init()
+ * @param[in]  buf      Value storage, must stay valid while the extractor is used
+ * @param[in]  buf_size Size of buf including the terminator (at least 1)
+ * @return false if the path is malformed or too long
+ */
+bool vc_json_extractor_init_buffer(vc_json_extractor_t *ex, const char *path, char *buf, size_t buf_size);
+
+/**
+ * @brief Start over on a new document with the same target, keeping the value buffer
+ */
+void vc_json_extractor_reset(vc_json_extractor_t *ex);
+
+/**
+ * @brief Feed the next chunk of the document
+ */
+vc_json_status_t vc_json_extractor_feed(vc_json_extractor_t *ex, const char *data, size_t len);
+
+/**
+ * @brief The extracted value so far (terminated), or NULL if nothing matched yet
+ */
+const char *vc_json_extractor_value(const vc_json_extractor_t *ex, size_t *len);
+
+/**
+ * @brief Hand the value buffer to the caller (free() it), or NULL if nothing matched
+ *
+ * The extractor no longer owns a buffer afterwards.
+ */
+char *vc_json_extractor_take(vc_json_extractor_t *ex);
+
+/**
+ * @brief Release the value buffer (no-op for a caller-provided buffer)
+ */
+void vc_json_extractor_free(vc_json_extractor_t *ex);
+
+/**
+ * @brief Write src as the contents of a JSON string (no surrounding quotes)
+ *
+ * Quotes, backslashes and control characters are escaped, everything else
+ * (including UTF-8) is copied as is. With dst NULL only the length is
+ * computed.
+ *
+ * @return Bytes written (dst is terminated if there is room), or
+ *         VC_JSON_ESCAPE_ERROR if dst_size is too small
+ */
+size_t vc_json_escape(char *dst, size_t dst_size, const char *src, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,197 @@
+/**
+ * Keyword spotter
+ *
+ * There is no model to train: the user says the wake word a few times and
+ * each take is kept as a sequence of quantised MFCC frames. Every new frame
+ * of the stream extends a subsequence DTW against each example - a column
+ * of best alignment costs, one cell per example frame, where any frame of
+ * the stream may start a match and a match ends on the example's last
+ * frame. A step advances the stream, the example or both; neither may
+ * stretch twice in a row, so the spoken word can be half to twice as fast
+ * as the example. Distances are L1 over int8 features, so a frame costs
+ * 12 byte differences per example cell and three one-second examples take
+ * a few thousand operations per 10 ms.
+ *
+ * A match below the threshold becomes a candidate; it is reported once
+ * confirm_frames pass without a closer one, with how long ago the best
+ * alignment ended, so the caller knows where the word stopped and the
+ * command begins.
+ */
+
+#include <string.h>
+#include "vc_kws.h"
+
+#define FEATURE_SCALE   8.0f        // Cepstral units per int8 step
+#define MEAN_SHIFT      (1.0f / 256) // Running mean over ~2.5 s of frames
+#define NO_PATH         UINT32_MAX
+
+enum {
+    MOVE_BOTH = 0,  // Stream and example advance
+    MOVE_STREAM,    // Stream advances (spoken slower than the example)
+    MOVE_EXAMPLE,   // Example advances (spoken faster)
+};
+
+void vc_kws_init(vc_kws_t *kws, const vc_kws_config_t *cfg)
+{
+    kws->cfg = *cfg;
+    kws->count = 0;
+    kws->primed = false;
+    memset(kws->mean, 0, sizeof(kws->mean));
+    vc_kws_reset(kws);
+}
+
+bool vc_kws_add_example(vc_kws_t *kws, const vc_kws_example_t *example)
+{
+    if (kws->count >= VC_KWS_MAX_EXAMPLES ||
+        example->frames < VC_KWS_MIN_FRAMES || example->frames > VC_KWS_MAX_FRAMES) {
+        return false;
+    }
+    kws->examples[kws->count] = example;
+    for (int j = 0; j < VC_KWS_MAX_FRAMES; j++) {
+        kws->cost[kws->count][j] = NO_PATH;
+    }
+    kws->count++;
+    return true;
+}
+
+void vc_kws_reset(vc_kws_t *kws)
+{
+    for (int e = 0; e < VC_KWS_MAX_EXAMPLES; e++) {
+        for (int j = 0; j < VC_KWS_MAX_FRAMES; j++) {
+            kws->cost[e][j] = NO_PATH;
+        }
+    }
+    kws->candidate = false;
+    kws->since_best = 0;
+    kws->score = UINT16_MAX;
+}
+
+void vc_kws_features(vc_kws_t *kws, const float mfcc[VC_MFCC_COEFFS], int8_t out[VC_KWS_DIM])
+{
+    if (!kws->primed) {
+        memcpy(kws->mean, mfcc, sizeof(kws->mean));
+        kws->primed = true;
+    }
+    for (int c = 0; c < VC_KWS_DIM; c++) {
+        kws->mean[c] += (mfcc[c] - kws->mean[c]) * MEAN_SHIFT;
+        float q = (mfcc[c] - kws->mean[c]) * FEATURE_SCALE;
+        out[c] = (int8_t)(q > 127.0f ? 127 : q < -127.0f ? -127 : (int)(q + (q < 0 ? -0.5f : 0.5f)));
+    }
+}
+
+static uint32_t distance(const int8_t *a, const int8_t *b)
+{
+    uint32_t sum = 0;
+    for (int c = 0; c < VC_KWS_DIM; c++) {
+        int d = a[c] - b[c];
+        sum += (uint32_t)(d < 0 ? -d : d);
+    }
+    return sum;
+}
+
+/**
+ * Advance one column of alignments by a stream frame
+ *
+ * cost/len/move[j] hold the best path ending at the previous stream frame
+ * and example frame j, and are updated in place. open_start lets the path
+ * begin at this frame (example frame 0, from nothing).
+ */
+static void dtw_step(const int8_t *feat, const vc_kws_example_t *ex,
+                     uint32_t *cost, uint16_t *len, uint8_t *move, bool open_start)
+{
+    uint32_t diag_cost = open_start ? 0 : NO_PATH;  // (previous frame, j - 1)
+    uint16_t diag_len = 0;
+    uint32_t left_cost = NO_PATH;                   // (this frame, j - 1)
+    uint16_t left_len = 0;
+    uint8_t left_move = MOVE_BOTH;
+
+    for (int j = 0; j < ex->frames; j++) {
+        uint32_t up_cost = cost[j];                 // (previous frame, j)
+        uint16_t up_len = len[j];
+        uint8_t up_move = move[j];
+
+        uint32_t best = diag_cost;
+        uint16_t best_len = diag_len;
+        uint8_t best_move = MOVE_BOTH;
+        if (up_cost < best && up_move != MOVE_STREAM) {
+            best = up_cost;
+            best_len = up_len;
+            best_move = MOVE_STREAM;
+        }
+        if (left_cost < best && left_move != MOVE_EXAMPLE) {
+            best = left_cost;
+            best_len = left_len;
+            best_move = MOVE_EXAMPLE;
+        }
+
+        if (best == NO_PATH) {
+            cost[j] = NO_PATH;
+        } else {
+            cost[j] = best + distance(feat, ex->feat[j]);
+            len[j] = best_len + 1;
+            move[j] = best_move;
+        }
+        diag_cost = up_cost;
+        diag_len = up_len;
+        left_cost = cost[j];
+        left_len = len[j];
+        left_move = move[j];
+    }
+}
+
+int vc_kws_process(vc_kws_t *kws, const int8_t feat[VC_KWS_DIM])
+{
+    uint32_t score = UINT16_MAX;
+    for (int e = 0; e < kws->count; e++) {
+        const vc_kws_example_t *ex = kws->examples[e];
+        dtw_step(feat, ex, kws->cost[e], kws->len[e], kws->move[e], true);
+        uint32_t end = kws->cost[e][ex->frames - 1];
+        if (end != NO_PATH) {
+            uint32_t mean = end / kws->len[e][ex->frames - 1];
+            if (mean < score) {
+                score = mean;
+            }
+        }
+    }
+    kws->score = (uint16_t)score;
+
+    if (score < kws->cfg.threshold && (!kws->candidate || score < kws->best)) {
+        kws->candidate = true;
+        kws->best = (uint16_t)score;
+        kws->since_best = 0;
+        return -1;
+    }
+    if (!kws->candidate) {
+        return -1;
+    }
+    kws->since_best++;
+    if (kws->since_best < kws->cfg.confirm_frames) {
+        return -1;
+    }
+
+    // Matched: start over, so the tail of the same word cannot match again
+    int ago = kws->since_best;
+    vc_kws_reset(kws);
+    return ago;
+}
+
+uint16_t vc_kws_calibrate(const vc_kws_example_t *a, const vc_kws_example_t *b)
+{
+    uint32_t cost[VC_KWS_MAX_FRAMES];
+    uint16_t len[VC_KWS_MAX_FRAMES];
+    uint8_t move[VC_KWS_MAX_FRAMES];
+    for (int j = 0; j < VC_KWS_MAX_FRAMES; j++) {
+        cost[j] = NO_PATH;
+    }
+
+    // a plays the stream, anchored at its first frame
+    for (int i = 0; i < a->frames; i++) {
+        dtw_step(a->feat[i], b, cost, len, move, i == 0);
+    }
+    uint32_t end = cost[b->frames - 1];
+    if (end == NO_PATH) {
+        return UINT16_MAX;     // Too different in length to align
+    }
+    uint32_t mean = end / len[b->frames - 1];
+    return mean < UINT16_MAX ? (uint16_t)mean : UINT16_MAX;
+}
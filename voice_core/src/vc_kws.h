@@ -0,0 +1,99 @@
+/**
+ * Keyword spotter
+ * Enrolled examples of the wake word matched against the MFCC stream by
+ * subsequence DTW on int8 features, no allocation
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vc_mfcc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_KWS_DIM          VC_MFCC_COEFFS
+#define VC_KWS_MAX_FRAMES   120     /*!< Longest example (1.2 s of 10 ms frames) */
+#define VC_KWS_MIN_FRAMES   25      /*!< Shortest example (a click or a cough is shorter) */
+#define VC_KWS_MAX_EXAMPLES 3
+
+/**
+ * @brief One spoken example of the wake word (stored as is, e.g. in NVS)
+ */
+typedef struct {
+    uint16_t frames;
+    int8_t feat[VC_KWS_MAX_FRAMES][VC_KWS_DIM];
+} vc_kws_example_t;
+
+typedef struct {
+    uint16_t threshold;         /*!< A match averages less than this per frame (see vc_kws_calibrate()) */
+    uint8_t confirm_frames;     /*!< Frames without a closer match before it is reported */
+} vc_kws_config_t;
+
+/**
+ * @brief Spotter state - treat as opaque except cfg, best and score
+ */
+typedef struct {
+    vc_kws_config_t cfg;
+    const vc_kws_example_t *examples[VC_KWS_MAX_EXAMPLES];
+    int count;
+    float mean[VC_KWS_DIM];     // Running cepstral mean
+    bool primed;
+    uint32_t cost[VC_KWS_MAX_EXAMPLES][VC_KWS_MAX_FRAMES];  // Best path ending at (now, frame)
+    uint16_t len[VC_KWS_MAX_EXAMPLES][VC_KWS_MAX_FRAMES];   // Its steps
+    uint8_t move[VC_KWS_MAX_EXAMPLES][VC_KWS_MAX_FRAMES];   // And how it got here
+    uint16_t best;              // Closest match of the current candidate
+    uint16_t since_best;        // Frames since then
+    bool candidate;
+    uint16_t score;             // Last frame: closest example's mean distance per frame
+} vc_kws_t;
+
+/**
+ * @brief Prepare a spotter with no examples
+ */
+void vc_kws_init(vc_kws_t *kws, const vc_kws_config_t *cfg);
+
+/**
+ * @brief Match against example too (kept by reference, up to VC_KWS_MAX_EXAMPLES)
+ *
+ * @return false if full or the example is shorter than VC_KWS_MIN_FRAMES
+ */
+bool vc_kws_add_example(vc_kws_t *kws, const vc_kws_example_t *example);
+
+/**
+ * @brief Drop partial matches (listening restarts, or just after a detection)
+ */
+void vc_kws_reset(vc_kws_t *kws);
+
+/**
+ * @brief Normalise and quantise one MFCC frame
+ *
+ * Subtracts the running mean of the stream (a few seconds), which takes
+ * out the mic and the room. Examples and the stream they are matched
+ * against must go through the same spotter.
+ */
+void vc_kws_features(vc_kws_t *kws, const float mfcc[VC_MFCC_COEFFS], int8_t out[VC_KWS_DIM]);
+
+/**
+ * @brief Match the next frame
+ *
+ * A match is reported once no closer one has followed for confirm_frames.
+ *
+ * @return -1, or how many frames ago (before this one) the matched word ended
+ */
+int vc_kws_process(vc_kws_t *kws, const int8_t feat[VC_KWS_DIM]);
+
+/**
+ * @brief Mean per-frame distance between two examples (both aligned end to end)
+ *
+ * What the same speaker saying the same word twice differs by; a threshold
+ * a little above the average over all pairs rejects most other words.
+ */
+uint16_t vc_kws_calibrate(const vc_kws_example_t *a, const vc_kws_example_t *b);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,199 @@
+/**
+ * MFCC front end
+ *
+ * The features a keyword spotter looks at: each 25 ms frame is
+ * pre-emphasised and windowed, its power spectrum folded into 26
+ * triangular bands spaced evenly on the mel scale (20 Hz up to 8 kHz or
+ * Nyquist), and the log band energies decorrelated with a DCT. c0 is
+ * dropped so that how loud the speaker is does not move the features;
+ * what is left describes the shape of the spectrum.
+ *
+ * The 512-point real FFT runs as a 256-point complex one on the even and
+ * odd samples and is split afterwards, which halves the work and the
+ * buffer. Everything is single precision: the ESP32 has a float unit, and
+ * one frame is about 40k multiply-adds, well under a millisecond.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "vc_mfcc.h"
+
+#define HALF            (VC_MFCC_FFT / 2)
+#define PI_F            3.14159265358979f
+#define MEL_LOW_HZ      20.0f
+#define MEL_HIGH_HZ     8000.0f
+#define PRE_EMPHASIS    0.97f
+#define LOG_FLOOR       1.0f        // Added to band energies: digital silence stays finite
+
+static float hz_to_mel(float hz)
+{
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float mel_to_hz(float mel)
+{
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+bool vc_mfcc_init(vc_mfcc_t *m, uint32_t sample_rate)
+{
+    uint32_t frame_len = sample_rate / 40;
+    if (sample_rate < 4000 || frame_len > VC_MFCC_FFT) {
+        return false;
+    }
+    m->frame_len = (uint16_t)frame_len;
+    m->hop = (uint16_t)(sample_rate / 100);
+
+    for (uint32_t i = 0; i < frame_len; i++) {
+        float w = 0.54f - 0.46f * cosf(2.0f * PI_F * i / (frame_len - 1));
+        m->window[i] = (int16_t)lrintf(w * 32767.0f);
+    }
+    for (int k = 0; k < HALF; k++) {
+        m->twiddle_re[k] = cosf(2.0f * PI_F * k / VC_MFCC_FFT);
+        m->twiddle_im[k] = -sinf(2.0f * PI_F * k / VC_MFCC_FFT);
+    }
+
+    float high = sample_rate / 2.0f < MEL_HIGH_HZ ? sample_rate / 2.0f : MEL_HIGH_HZ;
+    float mel_low = hz_to_mel(MEL_LOW_HZ);
+    float mel_step = (hz_to_mel(high) - mel_low) / (VC_MFCC_BANDS + 1);
+    for (int b = 0; b < VC_MFCC_BANDS + 2; b++) {
+        float bin = mel_to_hz(mel_low + b * mel_step) * VC_MFCC_FFT / sample_rate;
+        m->band_edge[b] = (uint16_t)lrintf(bin * 16.0f);
+    }
+
+    // Orthonormal DCT-II rows 1..COEFFS
+    float scale = sqrtf(2.0f / VC_MFCC_BANDS);
+    for (int c = 0; c < VC_MFCC_COEFFS; c++) {
+        for (int b = 0; b < VC_MFCC_BANDS; b++) {
+            m->dct[c][b] = scale * cosf(PI_F * (c + 1) * (b + 0.5f) / VC_MFCC_BANDS);
+        }
+    }
+
+    vc_mfcc_reset(m);
+    return true;
+}
+
+void vc_mfcc_reset(vc_mfcc_t *m)
+{
+    m->fill = 0;
+}
+
+/**
+ * In-place radix-2 FFT of HALF complex points (interleaved re, im)
+ */
+static void fft_half(vc_mfcc_t *m)
+{
+    float *x = m->work;
+
+    for (int i = 1, j = 0; i < HALF; i++) {
+        int bit = HALF >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            float re = x[2 * i], im = x[2 * i + 1];
+            x[2 * i] = x[2 * j];
+            x[2 * i + 1] = x[2 * j + 1];
+            x[2 * j] = re;
+            x[2 * j + 1] = im;
+        }
+    }
+
+    for (int len = 2; len <= HALF; len <<= 1) {
+        int stride = VC_MFCC_FFT / len;     // HALF-point twiddles are every other FFT-point one
+        for (int start = 0; start < HALF; start += len) {
+            for (int k = 0; k < len / 2; k++) {
+                float wr = m->twiddle_re[k * stride], wi = m->twiddle_im[k * stride];
+                float *a = &x[2 * (start + k)];
+                float *b = &x[2 * (start + k + len / 2)];
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * Power spectrum of the windowed frame in buf (bins 0..HALF)
+ */
+static void power_spectrum(vc_mfcc_t *m)
+{
+    // Pre-emphasis and window, even samples to re and odd to im, zero padded
+    float prev = m->buf[0];
+    for (int i = 0; i < VC_MFCC_FFT; i++) {
+        float v = 0.0f;
+        if (i < m->frame_len) {
+            float s = m->buf[i];
+            v = (s - PRE_EMPHASIS * prev) * m->window[i] * (1.0f / 32768.0f);  // PCM16 units
+            prev = s;
+        }
+        m->work[i] = v;
+    }
+    fft_half(m);
+
+    // Split: X[k] = E[k] + W^k O[k], with E and O from Z[k] and conj(Z[HALF - k])
+    const float *z = m->work;
+    m->power[0] = (z[0] + z[1]) * (z[0] + z[1]);
+    m->power[HALF] = (z[0] - z[1]) * (z[0] - z[1]);
+    for (int k = 1; k < HALF; k++) {
+        float zr = z[2 * k], zi = z[2 * k + 1];
+        float cr = z[2 * (HALF - k)], ci = -z[2 * (HALF - k) + 1];
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        float or_ = 0.5f * (zi - ci), oi = -0.5f * (zr - cr);
+        float wr = m->twiddle_re[k], wi = m->twiddle_im[k];
+        float xr = er + or_ * wr - oi * wi;
+        float xi = ei + or_ * wi + oi * wr;
+        m->power[k] = xr * xr + xi * xi;
+    }
+}
+
+static void cepstrum(vc_mfcc_t *m, float out[VC_MFCC_COEFFS])
+{
+    float log_energy[VC_MFCC_BANDS];
+    for (int b = 0; b < VC_MFCC_BANDS; b++) {
+        // Triangle from corner b to b + 2 peaking at b + 1, bins in Q4
+        int32_t lo = m->band_edge[b], mid = m->band_edge[b + 1], hi = m->band_edge[b + 2];
+        float sum = 0.0f;
+        for (int32_t k = (lo + 15) / 16; k * 16 < hi && k <= HALF; k++) {
+            int32_t pos = k * 16;
+            float w = pos < mid ? (float)(pos - lo) / (mid - lo) : (float)(hi - pos) / (hi - mid);
+            sum += w * m->power[k];
+        }
+        log_energy[b] = logf(sum + LOG_FLOOR);
+    }
+    for (int c = 0; c < VC_MFCC_COEFFS; c++) {
+        float acc = 0.0f;
+        for (int b = 0; b < VC_MFCC_BANDS; b++) {
+            acc += m->dct[c][b] * log_energy[b];
+        }
+        out[c] = acc;
+    }
+}
+
+bool vc_mfcc_frame(vc_mfcc_t *m, const int16_t **in, size_t *count, float out[VC_MFCC_COEFFS])
+{
+    size_t take = m->frame_len - m->fill;
+    if (take > *count) {
+        take = *count;
+    }
+    memcpy(&m->buf[m->fill], *in, take * sizeof(int16_t));
+    m->fill += take;
+    *in += take;
+    *count -= take;
+    if (m->fill < m->frame_len) {
+        return false;
+    }
+
+    power_spectrum(m);
+    cepstrum(m, out);
+
+    // Keep the overlap for the next frame
+    m->fill = m->frame_len - m->hop;
+    memmove(m->buf, &m->buf[m->hop], m->fill * sizeof(int16_t));
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * MFCC front end
+ * 25 ms Hamming frames every 10 ms, 512-point real FFT, 26 mel bands,
+ * cepstral coefficients 1-12 (the energy term c0 is left out), no allocation
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_MFCC_COEFFS  12      /*!< Coefficients per frame */
+#define VC_MFCC_BANDS   26      /*!< Mel filters */
+#define VC_MFCC_FFT     512     /*!< Frame length must fit (up to 20.48 kHz) */
+
+/**
+ * @brief Front end state - treat as opaque (self-contained)
+ */
+typedef struct {
+    uint16_t frame_len;     // Samples per frame (25 ms)
+    uint16_t hop;           // Samples between frames (10 ms)
+    uint16_t fill;          // Samples in buf
+    uint16_t band_edge[VC_MFCC_BANDS + 2];  // Filter corners in FFT bins, Q4
+    int16_t buf[VC_MFCC_FFT];
+    int16_t window[VC_MFCC_FFT];            // Hamming, Q15
+    float twiddle_re[VC_MFCC_FFT / 2];      // e^(-2 pi i k / FFT)
+    float twiddle_im[VC_MFCC_FFT / 2];
+    float dct[VC_MFCC_COEFFS][VC_MFCC_BANDS];
+    float work[VC_MFCC_FFT];                // Interleaved complex, FFT / 2 points
+    float power[VC_MFCC_FFT / 2 + 1];
+} vc_mfcc_t;
+
+/**
+ * @brief Build the window, filter bank and DCT for sample_rate
+ *
+ * @return false if a 25 ms frame does not fit the FFT (above 20.48 kHz) or the rate is below 4 kHz
+ */
+bool vc_mfcc_init(vc_mfcc_t *m, uint32_t sample_rate);
+
+/**
+ * @brief Drop buffered input (start of a new stream)
+ */
+void vc_mfcc_reset(vc_mfcc_t *m);
+
+/**
+ * @brief Consume input until the next frame is complete
+ *
+ * Call in a loop, any split of the stream is fine:
+ * `while (vc_mfcc_frame(&m, &in, &count, coeffs)) { ... }`
+ *
+ * @param[in,out] in    Advanced past the consumed samples
+ * @param[in,out] count Samples left at *in
+ * @param[out] out      This frame's coefficients
+ * @return true if out holds a new frame, false once the input ran out
+ */
+bool vc_mfcc_frame(vc_mfcc_t *m, const int16_t **in, size_t *count, float out[VC_MFCC_COEFFS]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,19 @@
+/**
+ * PCM sample format helpers
+ *
+ * Runs on the playback task for every sample that reaches the speaker. The
+ * loop is the vc_pipeline.hpp one for 16-bit stereo, instantiated here so
+ * the C firmware gets the same specialisation as the C++ ones.
+ */
+
+#include "vc_pcm.h"
+#include "vc_pipeline.hpp"
+
+typedef vc::format<int16_t, 2> speaker_format;
+
+static_assert(speaker_format::frame_bytes == sizeof(uint32_t), "one word per stereo frame");
+
+extern "C" void vc_pcm_mono_to_stereo(uint32_t *frames, const int16_t *mono, size_t samples)
+{
+    speaker_format::expand(reinterpret_cast<int16_t *>(frames), mono, samples);
+}
@@ -0,0 +1,29 @@
+/**
+ * PCM sample format helpers
+ * Mono PCM16 to the interleaved stereo frames the I2S speaker takes
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Duplicate mono samples into L/R frames, one 32-bit word per frame
+ *
+ * Both halves of each word are identical, so slot order within the word
+ * does not matter.
+ *
+ * @param[out] frames  Output, samples words (must not overlap mono)
+ * @param[in]  mono    Mono PCM16 samples
+ * @param[in]  samples Number of samples
+ */
+void vc_pcm_mono_to_stereo(uint32_t *frames, const int16_t *mono, size_t samples);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,153 @@
+/**
+ * Audio pipeline shape
+ *
+ * A stream is described once, by its sample type, rate, channel count and
+ * how many frames each read or write moves, and every size the firmware
+ * needs is derived from that at compile time: chunk bytes, buffers per
+ * duration, legacy I2S DMA descriptors. The per-sample loops take the same
+ * parameters, so each firmware gets a copy specialised for its own layout
+ * with the channel loop unrolled and the alignment masks constant.
+ *
+ * Header only and C++11, which is what the Arduino cores build with. The
+ * C firmware reaches the instantiations it uses through vc_pcm.h.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace vc {
+
+/**
+ * @brief What a PCM16 sample becomes in each I2S slot width
+ */
+template <typename Sample> struct sample_traits;
+
+template <> struct sample_traits<int16_t> {
+    static inline int16_t from_pcm16(int16_t s) { return s; }
+};
+
+template <> struct sample_traits<int32_t> {
+    static inline int32_t from_pcm16(int16_t s) { return (int32_t)((uint32_t)(uint16_t)s << 16); }  // Left-justified
+};
+
+/**
+ * @brief Mono PCM16 to Channels identical slots per frame
+ */
+template <typename Sample, unsigned Channels>
+struct expander {
+    static void run(Sample *out, const int16_t *mono, size_t frames)
+    {
+        for (size_t i = 0; i < frames; i++) {
+            Sample s = sample_traits<Sample>::from_pcm16(mono[i]);
+            for (unsigned c = 0; c < Channels; c++) {
+                out[i * Channels + c] = s;
+            }
+        }
+    }
+};
+
+// 16-bit stereo: one 32-bit word per frame, both halves the same so slot order does not matter
+template <>
+struct expander<int16_t, 2> {
+    static void run(int16_t *out, const int16_t *mono, size_t frames)
+    {
+        // Unrolled by 4 so the compiler can keep loads and stores in registers
+        size_t i = 0;
+        for (; i + 4 <= frames; i += 4) {
+            uint32_t w[4];
+            for (int k = 0; k < 4; k++) {
+                uint32_t s = (uint16_t)mono[i + k];
+                w[k] = s | (s << 16);
+            }
+            memcpy(&out[2 * i], w, sizeof(w));
+        }
+        for (; i < frames; i++) {
+            uint32_t s = (uint16_t)mono[i];
+            uint32_t w = s | (s << 16);
+            memcpy(&out[2 * i], &w, sizeof(w));
+        }
+    }
+};
+
+/**
+ * @brief Sample layout of a stream, independent of its rate
+ */
+template <typename Sample, unsigned Channels>
+struct format {
+    typedef Sample sample_type;
+    static constexpr unsigned channels = Channels;
+    static constexpr size_t frame_bytes = sizeof(Sample) * Channels;    /*!< One sample per channel */
+
+    /**
+     * @brief Bytes of n that make whole frames (the rest waits for the next read)
+     */
+    static constexpr size_t whole_bytes(size_t n) { return n - n % frame_bytes; }
+
+    /**
+     * @brief Duplicate mono PCM16 into every channel, widened to the slot type
+     *
+     * @param[out] out    frames * Channels samples (must not overlap mono)
+     * @param[in]  mono   Mono PCM16 samples
+     * @param[in]  frames Number of samples
+     */
+    static void expand(Sample *out, const int16_t *mono, size_t frames)
+    {
+        expander<Sample, Channels>::run(out, mono, frames);
+    }
+};
+
+template <typename Sample, unsigned Channels>
+constexpr unsigned format<Sample, Channels>::channels;
+template <typename Sample, unsigned Channels>
+constexpr size_t format<Sample, Channels>::frame_bytes;
+
+/**
+ * @brief A stream at a fixed rate, moved ChunkFrames frames at a time
+ */
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+struct pipeline : format<Sample, Channels> {
+    typedef format<Sample, Channels> base;
+
+    static_assert(ChunkFrames % 4 == 0, "chunks are split into four DMA buffers");
+
+    static constexpr uint32_t rate = Rate;
+    static constexpr size_t chunk_frames = ChunkFrames;
+    static constexpr size_t chunk_bytes = ChunkFrames * base::frame_bytes;
+    static constexpr uint32_t chunk_ms = (uint32_t)((uint64_t)ChunkFrames * 1000 / Rate);
+
+    /**
+     * Legacy I2S driver DMA: a chunk spans four buffers and the ring holds
+     * two chunks, so one late read does not drop audio. The driver caps a
+     * buffer at 1024 frames and 4092 bytes.
+     */
+    static constexpr int dma_buf_count = 8;
+    static constexpr int dma_buf_len =
+        ChunkFrames / 4 > 1024 ? 1024 :
+        ChunkFrames / 4 * base::frame_bytes > 4092 ? (int)(4092 / base::frame_bytes) :
+        (int)(ChunkFrames / 4);
+
+    static constexpr size_t frames_for_ms(uint32_t ms) { return (size_t)((uint64_t)Rate * ms / 1000); }
+    static constexpr size_t bytes_for_ms(uint32_t ms) { return frames_for_ms(ms) * base::frame_bytes; }
+    static constexpr uint32_t ms_for_bytes(size_t bytes)
+    {
+        return (uint32_t)((uint64_t)(bytes / base::frame_bytes) * 1000 / Rate);
+    }
+};
+
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+constexpr uint32_t pipeline<Sample, Rate, Channels, ChunkFrames>::rate;
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+constexpr size_t pipeline<Sample, Rate, Channels, ChunkFrames>::chunk_frames;
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+constexpr size_t pipeline<Sample, Rate, Channels, ChunkFrames>::chunk_bytes;
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+constexpr uint32_t pipeline<Sample, Rate, Channels, ChunkFrames>::chunk_ms;
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+constexpr int pipeline<Sample, Rate, Channels, ChunkFrames>::dma_buf_count;
+template <typename Sample, uint32_t Rate, unsigned Channels, size_t ChunkFrames>
+constexpr int pipeline<Sample, Rate, Channels, ChunkFrames>::dma_buf_len;
+
+}  // namespace vc
@@ -0,0 +1,139 @@
+/**
+ * OpenAI Realtime API message helpers
+ *
+ * At 24kHz the capture side sends a frame every ~40ms and the server sends
+ * audio deltas at a similar rate. Building a JSON DOM for each of them is
+ * the largest CPU and heap cost of the Realtime path; everything here works
+ * on flat buffers instead.
+ */
+
+#include <string.h>
+#include "vc_realtime.h"
+
+#define SNIFF_WINDOW 64  // "type" is the first member, well inside this
+
+void vc_rt_append_init(char *frame)
+{
+    memcpy(frame, VC_RT_APPEND_PREFIX, VC_RT_APPEND_PREFIX_LEN);
+}
+
+size_t vc_rt_append_fill(char *frame, size_t frame_size, const void *pcm, size_t pcm_len)
+{
+    if (frame_size < VC_RT_APPEND_FRAME_SIZE(pcm_len)) {
+        return 0;
+    }
+
+    char *payload = frame + VC_RT_APPEND_PREFIX_LEN;
+    size_t b64_len = vc_base64_encode(payload, frame_size - VC_RT_APPEND_PREFIX_LEN, pcm, pcm_len);
+    memcpy(payload + b64_len, VC_RT_APPEND_SUFFIX, VC_RT_APPEND_SUFFIX_LEN + 1);
+    return VC_RT_APPEND_PREFIX_LEN + b64_len + VC_RT_APPEND_SUFFIX_LEN;
+}
+
+/**
+ * Skip JSON whitespace
+ */
+static const char *skip_ws(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * Opening quote of a string member's value, starting at the key's closing quote + 1, or NULL
+ */
+static const char *string_open(const char *p, const char *end)
+{
+    p = skip_ws(p, end);
+    if (p >= end || *p != ':') {
+        return NULL;
+    }
+    p = skip_ws(p + 1, end);
+    return p < end && *p == '"' ? p : NULL;
+}
+
+/**
+ * Value of a string member starting at the key's closing quote + 1, or NULL
+ */
+static const char *string_value(const char *p, const char *end, size_t *value_len)
+{
+    p = string_open(p, end);
+    if (!p) {
+        return NULL;
+    }
+
+    // Audio values run to tens of KB, so let memchr do the scanning
+    const char *value = p + 1;
+    const char *close = memchr(value, '"', (size_t)(end - value));
+    if (!close || memchr(value, '\\', (size_t)(close - value))) {
+        return NULL;
+    }
+    *value_len = (size_t)(close - value);
+    return value;
+}
+
+/**
+ * Key's closing quote + 1 for the next occurrence of "key" at or after p, or NULL
+ */
+static const char *find_key(const char *p, const char *end, const char *key, size_t key_len)
+{
+    while (p + key_len + 2 <= end) {
+        const char *quote = memchr(p, '"', (size_t)(end - p));
+        if (!quote || quote + key_len + 2 > end) {
+            return NULL;
+        }
+        if (memcmp(quote + 1, key, key_len) == 0 && quote[key_len + 1] == '"') {
+            return quote + key_len + 2;
+        }
+        p = quote + 1;
+    }
+    return NULL;
+}
+
+const char *vc_rt_find_string(const char *msg, size_t len, const char *key, size_t *value_len)
+{
+    size_t key_len = strlen(key);
+    const char *end = msg + len;
+
+    for (const char *p = msg; (p = find_key(p, end, key, key_len)) != NULL;) {
+        const char *value = string_value(p, end, value_len);
+        if (value) {
+            return value;
+        }
+    }
+    return NULL;
+}
+
+const char *vc_rt_find_string_start(const char *msg, size_t len, const char *key)
+{
+    size_t key_len = strlen(key);
+    const char *end = msg + len;
+
+    for (const char *p = msg; (p = find_key(p, end, key, key_len)) != NULL;) {
+        const char *open = string_open(p, end);
+        if (open) {
+            return open + 1;
+        }
+    }
+    return NULL;
+}
+
+vc_rt_event_t vc_rt_sniff(const char *msg, size_t len)
+{
+    size_t type_len;
+    const char *type = vc_rt_find_string(msg, len < SNIFF_WINDOW ? len : SNIFF_WINDOW, "type", &type_len);
+    if (!type) {
+        return VC_RT_EVENT_UNKNOWN;
+    }
+
+#define TYPE_IS(s) (type_len == sizeof(s) - 1 && memcmp(type, s, sizeof(s) - 1) == 0)
+    if (TYPE_IS("response.audio.delta") || TYPE_IS("response.output_audio.delta")) {
+        return VC_RT_EVENT_AUDIO_DELTA;
+    }
+    if (TYPE_IS("response.audio_transcript.delta") || TYPE_IS("response.output_audio_transcript.delta")) {
+        return VC_RT_EVENT_AUDIO_TRANSCRIPT_DELTA;
+    }
+#undef TYPE_IS
+    return VC_RT_EVENT_UNKNOWN;
+}
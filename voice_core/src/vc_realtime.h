@@ -0,0 +1,92 @@
+/**
+ * OpenAI Realtime API message helpers
+ * Pre-built input_audio_buffer.append frames and a DOM-free event sniffer
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "vc_base64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_RT_APPEND_PREFIX     "{\"type\":\"input_audio_buffer.append\",\"audio\":\""
+#define VC_RT_APPEND_SUFFIX     "\"}"
+#define VC_RT_APPEND_PREFIX_LEN (sizeof(VC_RT_APPEND_PREFIX) - 1)
+#define VC_RT_APPEND_SUFFIX_LEN (sizeof(VC_RT_APPEND_SUFFIX) - 1)
+
+/** Frame size needed for pcm_bytes of audio, including a terminator */
+#define VC_RT_APPEND_FRAME_SIZE(pcm_bytes) \
+    (VC_RT_APPEND_PREFIX_LEN + VC_BASE64_ENCODED_LEN(pcm_bytes) + VC_RT_APPEND_SUFFIX_LEN + 1)
+
+/**
+ * @brief Server events the audio path cares about
+ */
+typedef enum {
+    VC_RT_EVENT_UNKNOWN = 0,            /*!< Anything else - parse normally if needed */
+    VC_RT_EVENT_AUDIO_DELTA,            /*!< response.audio.delta / response.output_audio.delta */
+    VC_RT_EVENT_AUDIO_TRANSCRIPT_DELTA, /*!< response.audio_transcript.delta (frequent, usually ignored) */
+} vc_rt_event_t;
+
+/**
+ * @brief Write the fixed frame prefix once, frames are then filled in place
+ *
+ * @param[out] frame Frame buffer, at least VC_RT_APPEND_FRAME_SIZE() bytes
+ */
+void vc_rt_append_init(char *frame);
+
+/**
+ * @brief Encode PCM behind the prefix and close the frame
+ *
+ * @param[in,out] frame      Buffer prepared with vc_rt_append_init()
+ * @param[in]     frame_size Size of frame
+ * @param[in]     pcm        Audio bytes
+ * @param[in]     pcm_len    Number of audio bytes
+ * @return Frame length (excluding the terminator), or 0 if it does not fit
+ */
+size_t vc_rt_append_fill(char *frame, size_t frame_size, const void *pcm, size_t pcm_len);
+
+/**
+ * @brief Find the top-level "type" of a server event without parsing it
+ *
+ * The Realtime API sends "type" as the first member, so only the head of
+ * the message is scanned.
+ *
+ * @return The event class, VC_RT_EVENT_UNKNOWN if not one of the above
+ */
+vc_rt_event_t vc_rt_sniff(const char *msg, size_t len);
+
+/**
+ * @brief Locate a string member by key in a flat scan
+ *
+ * @param[in]  msg       JSON text
+ * @param[in]  len       Length of msg
+ * @param[in]  key       Member name without quotes
+ * @param[out] value_len Length of the value
+ * @return Pointer to the first character of the value inside msg, or NULL if
+ *         the key is missing or the value contains escapes (parse it normally)
+ */
+const char *vc_rt_find_string(const char *msg, size_t len, const char *key, size_t *value_len);
+
+/**
+ * @brief Locate where a string member's value begins in the head of a message
+ *
+ * For messages that arrive in pieces: the value may run past len, so the
+ * closing quote is not required. Scanning for it, and for escapes, is up to
+ * the caller as the rest of the value arrives.
+ *
+ * @param[in] msg JSON text received so far
+ * @param[in] len Length of msg
+ * @param[in] key Member name without quotes
+ * @return Pointer to the first character of the value inside msg (may equal
+ *         msg + len), or NULL if the key and opening quote are not in msg yet
+ */
+const char *vc_rt_find_string_start(const char *msg, size_t len, const char *key);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,126 @@
+/**
+ * Rational sample rate converter
+ *
+ * Conceptually the input is upsampled by L (zeros in between), low-pass
+ * filtered and decimated by M. The polyphase form skips the zeros and the
+ * outputs that would be thrown away: each output is one TAPS-long dot
+ * product of the newest inputs with the filter phase that lands on it.
+ *
+ * The filter is a Blackman-windowed sinc cut off at 0.45 of the lower rate,
+ * designed in floating point once at init. Each phase is quantised to Q15
+ * with its taps summing to exactly 1.0, so every phase has unity DC gain;
+ * with the sum of |taps| below 2 the products fit a 32-bit accumulator,
+ * and the inner loop is plain 16x16 multiply-accumulates.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "vc_resample.h"
+
+#define CUTOFF 0.45     // Of the lower of the two rates
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+    while (b) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static void design(vc_resampler_t *rs, uint32_t in_rate, uint32_t out_rate)
+{
+    const int L = rs->up;
+    const int n = L * VC_RESAMPLE_TAPS;
+    const double center = (n - 1) / 2.0;
+    // Cutoff in cycles per sample of the upsampled stream
+    const double fc = CUTOFF * (in_rate < out_rate ? in_rate : out_rate) / ((double)in_rate * L);
+
+    for (int p = 0; p < L; p++) {
+        double h[VC_RESAMPLE_TAPS];
+        double sum = 0;
+        for (int k = 0; k < VC_RESAMPLE_TAPS; k++) {
+            int i = p + k * L;
+            double t = i - center;
+            double sinc = t == 0 ? 2 * fc : sin(2 * M_PI * fc * t) / (M_PI * t);
+            double w = 0.42 - 0.5 * cos(2 * M_PI * i / (n - 1)) + 0.08 * cos(4 * M_PI * i / (n - 1));
+            h[k] = sinc * w;
+            sum += h[k];
+        }
+
+        // Unity gain per phase, rounding error folded into the largest tap
+        int32_t total = 0;
+        int peak = 0;
+        for (int k = 0; k < VC_RESAMPLE_TAPS; k++) {
+            rs->coeffs[p][k] = (int16_t)lrint(h[k] / sum * 32768.0);
+            total += rs->coeffs[p][k];
+            if (rs->coeffs[p][k] > rs->coeffs[p][peak]) {
+                peak = k;
+            }
+        }
+        rs->coeffs[p][peak] += (int16_t)(32768 - total);
+    }
+}
+
+bool vc_resampler_init(vc_resampler_t *rs, uint32_t in_rate, uint32_t out_rate)
+{
+    if (in_rate == 0 || out_rate == 0) {
+        return false;
+    }
+    uint32_t g = gcd(in_rate, out_rate);
+    if (out_rate / g > VC_RESAMPLE_MAX_PHASES || in_rate / g > UINT16_MAX) {
+        return false;
+    }
+
+    memset(rs, 0, sizeof(*rs));
+    rs->up = (uint16_t)(out_rate / g);
+    rs->down = (uint16_t)(in_rate / g);
+    if (rs->up != rs->down) {
+        design(rs, in_rate, out_rate);
+    }
+    return true;
+}
+
+void vc_resampler_reset(vc_resampler_t *rs)
+{
+    memset(rs->delay, 0, sizeof(rs->delay));
+    rs->pos = 0;
+    rs->phase = 0;
+}
+
+size_t vc_resampler_max_output(const vc_resampler_t *rs, size_t count)
+{
+    return (count * rs->up + rs->down - 1) / rs->down + 1;
+}
+
+size_t vc_resampler_process(vc_resampler_t *rs, const int16_t *in, size_t count, int16_t *out)
+{
+    if (rs->up == rs->down) {
+        if (out != in) {
+            memmove(out, in, count * sizeof(int16_t));
+        }
+        return count;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        // Newest first and contiguous, thanks to the mirrored half
+        rs->pos = rs->pos ? rs->pos - 1 : VC_RESAMPLE_TAPS - 1;
+        rs->delay[rs->pos] = rs->delay[rs->pos + VC_RESAMPLE_TAPS] = in[i];
+
+        while (rs->phase < rs->up) {
+            const int16_t *h = rs->coeffs[rs->phase];
+            const int16_t *x = &rs->delay[rs->pos];
+            int32_t acc = 1 << 14;
+            for (int k = 0; k < VC_RESAMPLE_TAPS; k++) {
+                acc += (int32_t)h[k] * x[k];
+            }
+            acc >>= 15;
+            out[n++] = acc > INT16_MAX ? INT16_MAX : acc < INT16_MIN ? INT16_MIN : (int16_t)acc;
+            rs->phase += rs->down;
+        }
+        rs->phase -= rs->up;
+    }
+    return n;
+}
@@ -0,0 +1,60 @@
+/**
+ * Rational sample rate converter
+ * Polyphase FIR with Q15 coefficients, PCM16 in and out, no allocation
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_RESAMPLE_TAPS       32   /*!< Taps per phase (filter length is TAPS * up) */
+#define VC_RESAMPLE_MAX_PHASES 8    /*!< Largest up factor once the ratio is reduced */
+
+/**
+ * @brief Converter state - treat as opaque (self-contained)
+ */
+typedef struct {
+    uint16_t up;            // Interpolation factor L
+    uint16_t down;          // Decimation factor M
+    uint16_t phase;         // Next output's phase, < up while outputs are due
+    uint16_t pos;           // Newest sample in delay[pos], mirrored at pos + TAPS
+    int16_t coeffs[VC_RESAMPLE_MAX_PHASES][VC_RESAMPLE_TAPS];
+    int16_t delay[2 * VC_RESAMPLE_TAPS];
+} vc_resampler_t;
+
+/**
+ * @brief Design the anti-aliasing filter for in_rate -> out_rate
+ *
+ * Equal rates make a pass-through converter.
+ *
+ * @return false if the reduced ratio needs more than VC_RESAMPLE_MAX_PHASES phases
+ */
+bool vc_resampler_init(vc_resampler_t *rs, uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * @brief Forget past input (start of a new stream), keeping the filter
+ */
+void vc_resampler_reset(vc_resampler_t *rs);
+
+/**
+ * @brief Most samples vc_resampler_process() can write for count input samples
+ */
+size_t vc_resampler_max_output(const vc_resampler_t *rs, size_t count);
+
+/**
+ * @brief Convert the next count samples (any split of the stream is fine)
+ *
+ * @param[out] out At least vc_resampler_max_output(rs, count) samples (may equal in when downsampling)
+ * @return Samples written to out
+ */
+size_t vc_resampler_process(vc_resampler_t *rs, const int16_t *in, size_t count, int16_t *out);
+
+#ifdef __cplusplus
+}
+#endif
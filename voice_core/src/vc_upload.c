@@ -0,0 +1,56 @@
+/**
+ * Transcription upload framing
+ *
+ * The pipelined upload frames every 2 KB of captured audio as it goes out,
+ * so framing is plain stores into the caller's buffer: no printf, no copy.
+ */
+
+#include <string.h>
+#include "vc_upload.h"
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+void vc_wav_header(uint8_t *header, uint32_t data_bytes, uint32_t sample_rate)
+{
+    uint32_t riff_size = data_bytes == VC_WAV_STREAMING_SIZE ? VC_WAV_STREAMING_SIZE
+                                                             : data_bytes + VC_WAV_HEADER_SIZE - 8;
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, riff_size);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    put_le32(header + 16, 16);              // fmt chunk size
+    put_le16(header + 20, 1);               // PCM
+    put_le16(header + 22, 1);               // Mono
+    put_le32(header + 24, sample_rate);
+    put_le32(header + 28, sample_rate * 2); // Byte rate
+    put_le16(header + 32, 2);               // Block align
+    put_le16(header + 34, 16);              // Bits per sample
+    memcpy(header + 36, "data", 4);
+    put_le32(header + 40, data_bytes);
+}
+
+size_t vc_chunk_frame(char *buf, size_t len)
+{
+    static const char hex[16] = "0123456789abcdef";
+    buf[0] = hex[(len >> 12) & 0xF];
+    buf[1] = hex[(len >> 8) & 0xF];
+    buf[2] = hex[(len >> 4) & 0xF];
+    buf[3] = hex[len & 0xF];
+    buf[4] = '\r';
+    buf[5] = '\n';
+    buf[VC_CHUNK_HEADER + len] = '\r';
+    buf[VC_CHUNK_HEADER + len + 1] = '\n';
+    return VC_CHUNK_HEADER + len + VC_CHUNK_TRAILER;
+}
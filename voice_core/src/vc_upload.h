@@ -0,0 +1,66 @@
+/**
+ * Transcription upload framing
+ * WAV header, multipart/form-data envelope and chunked-transfer framing
+ * for streaming PCM16 to /v1/audio/transcriptions
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VC_UPLOAD_BOUNDARY      "----WebKitFormBoundary7MA4YWxkTrZu0gW"
+#define VC_UPLOAD_CONTENT_TYPE  "multipart/form-data; boundary=" VC_UPLOAD_BOUNDARY
+
+/** Multipart part header in front of the WAV file */
+#define VC_UPLOAD_PREAMBLE \
+    "--" VC_UPLOAD_BOUNDARY "\r\n" \
+    "Content-Disposition: form-data; name=\"file\"; filename=\"audio.wav\"\r\n" \
+    "Content-Type: audio/wav\r\n\r\n"
+
+/** Closes the file part, names the model and ends the body */
+#define VC_UPLOAD_TRAILER \
+    "\r\n--" VC_UPLOAD_BOUNDARY "\r\n" \
+    "Content-Disposition: form-data; name=\"model\"\r\n\r\n" \
+    "whisper-1\r\n" \
+    "--" VC_UPLOAD_BOUNDARY "--\r\n"
+
+#define VC_UPLOAD_PREAMBLE_LEN  (sizeof(VC_UPLOAD_PREAMBLE) - 1)
+#define VC_UPLOAD_TRAILER_LEN   (sizeof(VC_UPLOAD_TRAILER) - 1)
+
+#define VC_WAV_HEADER_SIZE      44
+#define VC_WAV_STREAMING_SIZE   0xFFFFFFFFu     /*!< Length unknown, read until end of part */
+
+#define VC_CHUNK_HEADER         6               /*!< "XXXX\r\n" in front of the payload */
+#define VC_CHUNK_TRAILER        2               /*!< "\r\n" after it */
+#define VC_CHUNK_MAX            0xFFFF          /*!< Largest payload one chunk can frame */
+
+/**
+ * @brief Write a PCM16 mono WAV header (little-endian on any host)
+ *
+ * @param[out] header      VC_WAV_HEADER_SIZE bytes
+ * @param[in]  data_bytes  Size of the samples, or VC_WAV_STREAMING_SIZE
+ * @param[in]  sample_rate Sample rate in Hz
+ */
+void vc_wav_header(uint8_t *header, uint32_t data_bytes, uint32_t sample_rate);
+
+/**
+ * @brief Frame a payload as one chunked-transfer chunk, in place
+ *
+ * buf must have VC_CHUNK_HEADER bytes free before the payload and
+ * VC_CHUNK_TRAILER bytes after it, so the whole chunk goes out in a single
+ * write (and a single TLS record).
+ *
+ * @param[in,out] buf Chunk buffer, payload at buf + VC_CHUNK_HEADER
+ * @param[in]     len Payload length, at most VC_CHUNK_MAX
+ * @return Length of the framed chunk
+ */
+size_t vc_chunk_frame(char *buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
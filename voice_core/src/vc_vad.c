@@ -0,0 +1,127 @@
+/**
+ * Voice activity detector
+ *
+ * A frame counts as speech if its energy clears the noise floor by
+ * threshold_q4 and it crosses zero often enough to be more than hum; a
+ * frame with many crossings (s, f, sh) only has to clear half of that.
+ * Speech is confirmed after onset_ms of such frames and ends after
+ * hangover_ms without one, so short words, clicks and pauses between words
+ * do not toggle the state. The noise floor follows quiet frames down
+ * quickly and up slowly, and barely moves while someone is talking.
+ */
+
+#include "vc_vad.h"
+
+#define NOISE_FALL_SHIFT    2   // Floor drops a quarter of the gap per frame
+#define NOISE_RISE_SHIFT    5   // Rises 1/32 per quiet frame (~1.5 s at 40 ms frames)
+#define NOISE_SPEECH_SHIFT  10  // And 1/1024 while speech is going on
+
+vc_vad_config_t vc_vad_default_config(uint32_t sample_rate)
+{
+    vc_vad_config_t cfg = {
+        .sample_rate = sample_rate,
+        .onset_ms = 60,
+        .hangover_ms = 700,
+        .threshold_q4 = 64,         // 4x the floor, 6 dB
+        .min_energy = 150 * 150,    // RMS 150, well above the mic's self-noise
+        .zcr_voiced = 200,          // Below 100 Hz
+        .zcr_unvoiced = 6000,       // Mostly above 3 kHz
+    };
+    return cfg;
+}
+
+void vc_vad_init(vc_vad_t *vad, const vc_vad_config_t *cfg)
+{
+    vad->cfg = *cfg;
+    vad->onset_samples = cfg->sample_rate / 1000 * cfg->onset_ms;
+    vad->hangover_samples = cfg->sample_rate / 1000 * cfg->hangover_ms;
+    vad->noise = cfg->min_energy;
+    vad->dc = 0;
+    vad->energy = 0;
+    vad->zcr = 0;
+    vc_vad_reset(vad);
+}
+
+void vc_vad_reset(vc_vad_t *vad)
+{
+    vad->speech = false;
+    vad->run = 0;
+}
+
+static void track_noise(vc_vad_t *vad, bool quiet)
+{
+    uint32_t e = vad->energy;
+    if (e < vad->noise) {
+        vad->noise -= (vad->noise - e) >> NOISE_FALL_SHIFT;
+    } else {
+        vad->noise += (e - vad->noise) >> (quiet ? NOISE_RISE_SHIFT : NOISE_SPEECH_SHIFT);
+    }
+}
+
+vc_vad_event_t vc_vad_process(vc_vad_t *vad, const int16_t *samples, size_t count)
+{
+    if (count == 0) {
+        return vad->speech ? VC_VAD_SPEECH : VC_VAD_SILENCE;
+    }
+
+    int64_t sum = 0;
+    uint64_t sum_sq = 0;
+    uint32_t crossings = 0;
+    bool above = samples[0] >= vad->dc;
+    for (size_t i = 0; i < count; i++) {
+        int32_t x = samples[i];
+        sum += x;
+        sum_sq += (uint64_t)((int64_t)x * x);
+        bool a = x >= vad->dc;
+        crossings += a != above;
+        above = a;
+    }
+
+    // Variance rather than raw power, so a PDM offset does not read as sound
+    int64_t mean = sum / (int64_t)count;
+    int64_t var = (int64_t)(sum_sq / count) - mean * mean;
+    vad->dc = (int32_t)mean;
+    vad->energy = var > 0 ? (uint32_t)var : 0;
+    vad->zcr = (uint32_t)((uint64_t)crossings * vad->cfg.sample_rate / count);
+
+    uint64_t threshold = ((uint64_t)vad->noise * vad->cfg.threshold_q4) >> 4;
+    if (threshold < vad->cfg.min_energy) {
+        threshold = vad->cfg.min_energy;
+    }
+    bool voiced = vad->energy > threshold && vad->zcr >= vad->cfg.zcr_voiced;
+    bool unvoiced = vad->energy > threshold / 2 && vad->zcr >= vad->cfg.zcr_unvoiced;
+    bool active = voiced || unvoiced;
+
+    track_noise(vad, !active && !vad->speech);
+
+    if (!vad->speech) {
+        if (!active) {
+            vad->run = 0;
+            return VC_VAD_SILENCE;
+        }
+        vad->run += count;
+        if (vad->run < vad->onset_samples) {
+            return VC_VAD_SILENCE;
+        }
+        vad->speech = true;
+        vad->run = 0;
+        return VC_VAD_START;
+    }
+
+    if (active) {
+        vad->run = 0;
+        return VC_VAD_SPEECH;
+    }
+    vad->run += count;
+    if (vad->run < vad->hangover_samples) {
+        return VC_VAD_SPEECH;
+    }
+    vad->speech = false;
+    vad->run = 0;
+    return VC_VAD_END;
+}
+
+bool vc_vad_in_speech(const vc_vad_t *vad)
+{
+    return vad->speech;
+}
@@ -0,0 +1,79 @@
+/**
+ * Voice activity detector
+ * Frame energy and zero-crossing rate against an adaptive noise floor,
+ * integer math only
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief What a frame means for the utterance
+ */
+typedef enum {
+    VC_VAD_SILENCE = 0, /*!< No speech (frames of a not yet confirmed onset included) */
+    VC_VAD_START,       /*!< Speech confirmed - this frame and the onset before it are speech */
+    VC_VAD_SPEECH,      /*!< Speech, or a pause still within the hangover */
+    VC_VAD_END,         /*!< Hangover ran out - this frame is the first silence kept out */
+} vc_vad_event_t;
+
+typedef struct {
+    uint32_t sample_rate;
+    uint16_t onset_ms;      /*!< Speech needed before VC_VAD_START (rejects clicks) */
+    uint16_t hangover_ms;   /*!< Pause tolerated inside speech before VC_VAD_END */
+    uint16_t threshold_q4;  /*!< Speech if energy > noise floor * threshold_q4 / 16 */
+    uint32_t min_energy;    /*!< Threshold never drops below this (mean square, PCM16) */
+    uint16_t zcr_voiced;    /*!< Fewer zero crossings per second is hum or a thump, not speech */
+    uint16_t zcr_unvoiced;  /*!< More crossings per second lets a fricative pass at half the threshold */
+} vc_vad_config_t;
+
+/**
+ * @brief Detector state - treat as opaque except the last-frame readings
+ */
+typedef struct {
+    vc_vad_config_t cfg;
+    uint32_t onset_samples;
+    uint32_t hangover_samples;
+    uint32_t noise;         // Noise floor (mean square)
+    int32_t dc;             // Offset of the previous frame, crossings are counted around it
+    bool speech;
+    uint32_t run;           // Samples of speech (onset) or of silence (hangover) so far
+    uint32_t energy;        // Last frame: mean square around dc
+    uint32_t zcr;           // Last frame: zero crossings per second
+} vc_vad_t;
+
+/**
+ * @brief Defaults for close-talking speech into the ATOM Echo's PDM mic
+ */
+vc_vad_config_t vc_vad_default_config(uint32_t sample_rate);
+
+/**
+ * @brief Prepare a detector (noise floor starts at cfg->min_energy)
+ */
+void vc_vad_init(vc_vad_t *vad, const vc_vad_config_t *cfg);
+
+/**
+ * @brief Start a new utterance, keeping the learned noise floor
+ */
+void vc_vad_reset(vc_vad_t *vad);
+
+/**
+ * @brief Classify the next frame (any length, 10-50 ms works best)
+ */
+vc_vad_event_t vc_vad_process(vc_vad_t *vad, const int16_t *samples, size_t count);
+
+/**
+ * @brief true between VC_VAD_START and VC_VAD_END
+ */
+bool vc_vad_in_speech(const vc_vad_t *vad);
+
+#ifdef __cplusplus
+}
+#endif